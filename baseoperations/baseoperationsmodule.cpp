@@ -7,6 +7,7 @@
 #include "geometry.h"
 #include "columndefinition.h"
 #include "table.h"
+#include "tablemerger.h"
 #include "attributerecord.h"
 #include "feature.h"
 #include "featurecoverage.h"
@@ -20,6 +21,7 @@
 #include "data/assignment.h"
 #include "data/selection.h"
 #include "data/selectionfeatures.h"
+#include "data/samplepoints.h"
 #include "geometry/resampleraster.h"
 #include "geometry/fcoordinate.h"
 #include "geometry/fpixel.h"
@@ -81,6 +83,7 @@ void BaseOperationsModule::prepare()
     commandhandler()->addOperation(Tangent::createMetadata(), Tangent::create);
     commandhandler()->addOperation(Text2Output::createMetadata(), Text2Output::create);
     commandhandler()->addOperation(BinaryMathFeature::createMetadata(), BinaryMathFeature::create);
+    commandhandler()->addOperation(SamplePoints::createMetadata(), SamplePoints::create);
 
 }
 
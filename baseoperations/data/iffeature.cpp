@@ -1,7 +1,9 @@
 #include <QString>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include "kernel.h"
 #include "coverage.h"
 #include "columndefinition.h"
@@ -39,22 +41,25 @@ bool IfFeature::execute(ExecutionContext *ctx, SymbolTable &symTable)
         if((_prepState = prepare(ctx, symTable)) != sPREPARED)
             return false;
 
-    SubSetAsyncFunc iffunc = [&](const std::vector<quint32>& subset) -> bool {
+    // the features of each task are added in the order of the tasks when all tasks are done
+    std::map<quint32, Features> created;
+    std::mutex mutex;
+    SubSetAsyncFunc iffunc = [&](quint32 begin, quint32 end) -> bool {
 
-        FeatureIterator iterOut(_outputFC);
-        FeatureIterator iterIn(_inputFC,subset);
-        FeatureIterator iterEnd = iterOut.end();
-        while(iterIn != iterEnd) {
-            _outputFC->newFeatureFrom(*iterIn);
-
-            ++iterOut;
-            ++iterIn;
+        Features features;
+        FeatureIterator iterIn(_inputFC, begin, end);
+        for(; iterIn != iterIn.end(); ++iterIn) {
+            features.push_back(_outputFC->createFeatureFrom(*iterIn));
         }
+        Locker lock(mutex);
+        created[begin] = std::move(features);
         return true;
 
     };
 
     bool resource = OperationHelperFeatures::execute(ctx, iffunc, _inputFC, _outputFC);
+    for(auto& task : created)
+        _outputFC->addFeatures(task.second);
 
     if ( resource && ctx != 0) {
         QVariant value;
@@ -0,0 +1,281 @@
+#include <functional>
+#include <future>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include "kernel.h"
+#include "raster.h"
+#include "columndefinition.h"
+#include "table.h"
+#include "tablemerger.h"
+#include "attributerecord.h"
+#include "polygon.h"
+#include "geometry.h"
+#include "feature.h"
+#include "featurecoverage.h"
+#include "featureiterator.h"
+#include "coordinatetransformer.h"
+#include "rasterinterpolator.h"
+#include "symboltable.h"
+#include "ilwisoperation.h"
+#include "samplepoints.h"
+
+using namespace Ilwis;
+using namespace BaseOperations;
+
+#define TILESIZE 256
+
+namespace {
+class PointOf : public boost::static_visitor<Coordinate> {
+public:
+    Coordinate operator()(const Pixel& p) const {
+        return Coordinate(p.x(), p.y());
+    }
+    Coordinate operator()(const Coordinate2d& p) const {
+        return Coordinate(p.x(), p.y());
+    }
+    Coordinate operator()(const Coordinate& p) const {
+        return p;
+    }
+    template<typename GeometryType> Coordinate operator()(const GeometryType&) const { // lines and polygons are not sampled
+        return Coordinate();
+    }
+};
+}
+
+Ilwis::OperationImplementation *SamplePoints::create(quint64 metaid, const Ilwis::OperationExpression &expr)
+{
+    return new SamplePoints(metaid, expr);
+}
+
+SamplePoints::SamplePoints() : _method(RasterInterpolator::ipNEARESTNEIGHBOUR)
+{
+}
+
+SamplePoints::SamplePoints(quint64 metaid, const Ilwis::OperationExpression &expr) :
+    OperationImplementation(metaid, expr),
+    _method(RasterInterpolator::ipNEARESTNEIGHBOUR)
+{
+}
+
+bool SamplePoints::execute(ExecutionContext *ctx, SymbolTable& symTable)
+{
+    if (_prepState == sNOTPREPARED)
+        if((_prepState = prepare(ctx,symTable)) != sPREPARED)
+            return false;
+
+    std::vector<SPFeatureI> features;
+    std::vector<Coordinate> crds;
+    FeatureIterator iter(_inputFC);
+    for(; iter != iter.end(); ++iter) {
+        SPFeatureI feature = *iter;
+        features.push_back(feature);
+        crds.push_back(feature->trackSize() > 0 ? feature->geometry().apply(PointOf()) : Coordinate());
+    }
+
+    // all points to the raster in one call, then to pixels. Points that can't be converted (e.g. poles) become undefined and get no value,
+    // like points outside the raster; the transformer falls back to converting point by point when the batch fails on them
+    SPCoordinateTransformer transformer = CoordinateTransformer::transformer(_inputFC->coordinateSystem(), _inputRaster->coordinateSystem());
+    if ( !transformer->isValid()) {
+        ERROR2(ERR_COULD_NOT_CONVERT_2, "points", _inputRaster->coordinateSystem()->name());
+        return false;
+    }
+    if ( !transformer->isIdentity()) {
+        std::vector<Coordinate> converted;
+        transformer->transform(crds, converted);
+        crds.swap(converted);
+    }
+    IGeoReference grf = _inputRaster->georeference();
+    Size sz = _inputRaster->size();
+    quint32 tilesX = (sz.xsize() + TILESIZE - 1) / TILESIZE;
+    std::vector<Pixel_d> pixels(crds.size());
+    std::vector<std::pair<quint64, quint32>> order; // the points inside the raster, sorted on tile and on row and column within the tile
+    order.reserve(crds.size());
+    for(quint32 i = 0; i < crds.size(); ++i) {
+        if ( !crds[i].isValid())
+            continue;
+        pixels[i] = grf->coord2Pixel(crds[i]);
+        if ( !pixels[i].isValid())
+            continue;
+        double x = std::floor(pixels[i].x()), y = std::floor(pixels[i].y());
+        if ( x < 0 || y < 0 || x >= sz.xsize() || y >= sz.ysize())
+            continue;
+        quint64 tile = ((quint32)y / TILESIZE) * tilesX + (quint32)x / TILESIZE;
+        order.push_back({(tile << 16) | (((quint32)y % TILESIZE) << 8) | ((quint32)x % TILESIZE), i});
+    }
+    std::sort(order.begin(), order.end());
+
+    int cores = order.size() < 10000 || !ctx->_threaded ? 1 : std::max(1, QThread::idealThreadCount());
+    std::vector<double> values(crds.size(), rUNDEF);
+    // each thread takes a contiguous part of the sorted points; it writes only the values of its own points
+    auto sample = [&](quint32 begin, quint32 end) -> bool {
+        RasterInterpolator interpolator(_inputRaster, _method);
+        quint32 first = begin;
+        while(first < end) {
+            // the points of one tile; their values are read into the window of the interpolator once
+            quint32 last = first;
+            Box2D<qint32> box(Pixel(std::numeric_limits<qint32>::max(), std::numeric_limits<qint32>::max()), Pixel(-1, -1));
+            while(last < end && (order[last].first >> 16) == (order[first].first >> 16)) {
+                const Pixel_d& pix = pixels[order[last].second];
+                qint32 x = (qint32)std::floor(pix.x()), y = (qint32)std::floor(pix.y());
+                box = Box2D<qint32>(Pixel(std::min(box.min_corner().x(), x), std::min(box.min_corner().y(), y)),
+                                    Pixel(std::max(box.max_corner().x(), x), std::max(box.max_corner().y(), y)));
+                ++last;
+            }
+            if ( last - first > 1)
+                interpolator.setWindow(box);
+            for(quint32 i = first; i < last; ++i) {
+                const Pixel_d& pix = pixels[order[i].second];
+                values[order[i].second] = interpolator.pix2value(Point3D<double>(pix.x(), pix.y(), 0));
+            }
+            interpolator.clearWindow();
+            first = last;
+        }
+        return true;
+    };
+    std::vector<std::future<bool>> futures;
+    for(int i = 1; i < cores; ++i)
+        futures.push_back(std::async(std::launch::async, sample, (quint64)order.size() * i / cores, (quint64)order.size() * (i + 1) / cores));
+    bool res = sample(0, order.size() / cores);
+    for(auto& future : futures)
+        res &= future.get();
+    if (!res)
+        return false;
+
+    ITable inputTable = _inputFC->attributeTable();
+    std::unordered_map<quint64, quint32> records;
+    if ( inputTable.isValid()) {
+        std::vector<QVariant> ids = inputTable->column(FEATUREIDCOLUMN);
+        for(quint32 rec = 0; rec < ids.size(); ++rec)
+            records.insert({ids[rec].toULongLong(), rec});
+    }
+    quint32 idColumn = _attTable->columnIndex(FEATUREIDCOLUMN);
+    quint32 valueColumn = _attTable->columnIndex(_column);
+    Features outFeatures;
+    outFeatures.reserve(features.size());
+    for(quint32 i = 0; i < features.size(); ++i) {
+        SPFeatureI feature = _outputFC->createFeatureFrom(features[i]);
+        if ( feature.isNull())
+            continue;
+        std::vector<QVariant> rec;
+        auto found = records.find(features[i]->featureid());
+        if ( found != records.end())
+            rec = inputTable->record(found->second);
+        rec = _merger.mergeRecords(rec, {});
+        rec.resize(_attTable->columns());
+        rec[idColumn] = feature->featureid();
+        rec[valueColumn] = values[i];
+        _attTable->record(NEW_RECORD, rec);
+        outFeatures.push_back(feature);
+    }
+    _outputFC->addFeatures(outFeatures);
+    OperationHelper::updateRanges(_attTable);
+    _outputFC->attributeTable(_attTable);
+
+    if ( ctx != 0) {
+        QVariant value;
+        value.setValue<IFeatureCoverage>(_outputFC);
+        ctx->addOutput(symTable, value, _outputFC->name(), itFEATURE, _outputFC->source());
+    }
+    return true;
+}
+
+Ilwis::OperationImplementation::State SamplePoints::prepare(ExecutionContext *, const SymbolTable & )
+{
+    if ( _expression.parameterCount() < 2 || _expression.parameterCount() > 4) {
+        ERROR3(ERR_ILLEGAL_NUM_PARM3,"samplepoints","2,3 or 4",QString::number(_expression.parameterCount()));
+        return sPREPAREFAILED;
+    }
+    QString points = _expression.parm(0).value();
+    QString raster = _expression.parm(1).value();
+    QString outputName = _expression.parm(0,false).value();
+
+    if (!_inputFC.prepare(points, itFEATURE)) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,points,"");
+        return sPREPAREFAILED;
+    }
+    if (!_inputRaster.prepare(raster, itRASTER)) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,raster,"");
+        return sPREPAREFAILED;
+    }
+    _column = _expression.parameterCount() > 2 ? _expression.parm(2).value().remove('"') : _inputRaster->name();
+    if ( _expression.parameterCount() == 4) {
+        QString method = _expression.parm(3).value().toLower();
+        if ( method == "nearestneighbour")
+            _method = RasterInterpolator::ipNEARESTNEIGHBOUR;
+        else if ( method == "bilinear")
+            _method = RasterInterpolator::ipBILINEAR;
+        else if ( method == "bicubic")
+            _method = RasterInterpolator::ipBICUBIC;
+        else {
+            ERROR3(ERR_ILLEGAL_PARM_3,"method",method,"samplepoints");
+            return sPREPAREFAILED;
+        }
+    }
+
+    Resource resource(itFEATURE);
+    _outputFC.prepare(resource);
+    _outputFC->setCoordinateSystem(_inputFC->coordinateSystem());
+    _outputFC->envelope(_inputFC->envelope());
+    if ( outputName != sUNDEF)
+        _outputFC->setName(outputName);
+
+    QString url = "ilwis://internal/" + outputName;
+    Resource tblResource(url, itFLATTABLE);
+    _attTable.prepare(tblResource);
+    if (!_merger.mergeMetadataTables(_attTable, _inputFC->attributeTable(), ITable())) {
+        ERROR1(ERR_NO_INITIALIZED_1, "output attribute table");
+        return sPREPAREFAILED;
+    }
+    if ( _attTable->columnIndex(FEATUREIDCOLUMN) == (quint32)iUNDEF) {
+        IDomain covdom;
+        if (!covdom.prepare("count")){
+            return sPREPAREFAILED;
+        }
+        _attTable->addColumn(FEATUREIDCOLUMN,covdom);
+    }
+    // nearest neighbour keeps the raw values, so the column gets the domain of the raster
+    IDomain dom = _inputRaster->datadef().domain();
+    if ( _method != RasterInterpolator::ipNEARESTNEIGHBOUR)
+        dom.prepare("value");
+    if ( _attTable->columnIndex(_column) != (quint32)iUNDEF || !_attTable->addColumn(_column, dom)) {
+        ERROR3(ERR_ILLEGAL_PARM_3,"column",_column,"samplepoints");
+        return sPREPAREFAILED;
+    }
+
+    return sPREPARED;
+}
+
+quint64 SamplePoints::createMetadata()
+{
+    QString url = QString("ilwis://operations/samplepoints");
+    Resource resource(QUrl(url), itOPERATIONMETADATA);
+    resource.addProperty("namespace","ilwis");
+    resource.addProperty("longname","samplepoints");
+    resource.addProperty("syntax","samplepoints(pointcoverage,inputgridcoverage[,columnname[,nearestneighbour|bilinear|bicubic]])");
+    resource.addProperty("description",TR("reads the values of a raster at all points of a point coverage; the values are added as a column to the attributes of the points"));
+    resource.addProperty("inparameters","2|3|4");
+    resource.addProperty("pin_1_type", itFEATURE);
+    resource.addProperty("pin_1_name", TR("input point coverage"));
+    resource.addProperty("pin_1_desc",TR("feature coverage with the points to sample; other features get an undefined value"));
+    resource.addProperty("pin_2_type", itRASTER);
+    resource.addProperty("pin_2_name", TR("input rastercoverage"));
+    resource.addProperty("pin_2_desc",TR("input rastercoverage with any domain"));
+    resource.addProperty("pin_3_type", itSTRING);
+    resource.addProperty("pin_3_name", TR("column name"));
+    resource.addProperty("pin_3_desc",TR("optional name of the column with the sampled values; the default is the name of the raster"));
+    resource.addProperty("pin_4_type", itSTRING);
+    resource.addProperty("pin_4_name", TR("interpolation method"));
+    resource.addProperty("pin_4_desc",TR("optional; nearestneighbour (default), bilinear or bicubic"));
+    resource.addProperty("outparameters",1);
+    resource.addProperty("pout_1_type", itFEATURE);
+    resource.addProperty("pout_1_name", TR("output point coverage"));
+    resource.addProperty("pout_1_desc",TR("copy of the input coverage with the sampled values in its attribute table"));
+    resource.prepare();
+    url += "=" + QString::number(resource.id());
+    resource.setUrl(url);
+
+    mastercatalog()->addItems({resource});
+    return resource.id();
+}
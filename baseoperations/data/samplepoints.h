@@ -0,0 +1,35 @@
+#ifndef SAMPLEPOINTS_H
+#define SAMPLEPOINTS_H
+
+namespace Ilwis {
+namespace BaseOperations {
+/*!
+ Reads the values of a raster at the points of a feature coverage in one operation. The points are transformed to the coordinate system
+ of the raster in one batch and sorted on the tile of the raster they fall in, so the threads that interpolate them each read a compact
+ part of the raster. The output is a copy of the point coverage with the sampled values as an extra attribute column.
+ */
+class SamplePoints : public OperationImplementation
+{
+public:
+    SamplePoints();
+    SamplePoints(quint64 metaid, const Ilwis::OperationExpression &expr);
+
+    bool execute(ExecutionContext *ctx,SymbolTable& symTable);
+    static Ilwis::OperationImplementation *create(quint64 metaid,const Ilwis::OperationExpression& expr);
+    Ilwis::OperationImplementation::State prepare(ExecutionContext *ctx, const SymbolTable &);
+
+    static quint64 createMetadata();
+
+private:
+    IFeatureCoverage _inputFC;
+    IRasterCoverage _inputRaster;
+    IFeatureCoverage _outputFC;
+    ITable _attTable;
+    TableMerger _merger;
+    QString _column;
+    int _method;
+};
+}
+}
+
+#endif // SAMPLEPOINTS_H
@@ -36,6 +36,12 @@ bool Selection::execute(ExecutionContext *ctx, SymbolTable& symTable)
     IRasterCoverage outputRaster = _outputObj.get<RasterCoverage>();
     IRasterCoverage inputRaster = _inputObj.get<RasterCoverage>();
 
+    // the attribute column is projected once on an array indexed by raw value; all threads share it and each pixel is a lookup
+    std::vector<double> attribValues;
+    bool projected = false;
+    if ( _attribColumn != "")
+        projected = AttributeRecord(inputRaster->attributeTable(), COVERAGEKEYCOLUMN).projectColumn(_attribColumn, attribValues);
+
     BoxedAsyncFunc selection = [&](const Box3D<qint32>& box ) -> bool {
         Box3D<qint32> inpbox = box.size();
         inpbox += _base;
@@ -46,14 +52,17 @@ bool Selection::execute(ExecutionContext *ctx, SymbolTable& symTable)
         PixelIterator iterIn(inputRaster, inpbox);
 
         AttributeRecord rec;
-        if ( _attribColumn != "")
+        if ( _attribColumn != "" && !projected)
             rec = AttributeRecord(inputRaster->attributeTable(), COVERAGEKEYCOLUMN);
 
         double v_in = 0;
         for_each(iterOut, iterOut.end(), [&](double& v){
             v_in = *iterIn;
             if ( v_in != rUNDEF) {
-                if ( rec.isValid()) {
+                if ( projected) {
+                    quint64 key = (quint64)v_in;
+                    v = v_in >= 0 && key < attribValues.size() ? attribValues[key] : rUNDEF;
+                } else if ( rec.isValid()) {
                     QVariant var = rec.cellByKey(v_in,_attribColumn);
                     v = var.toDouble();
                     if ( isNumericalUndef(v))
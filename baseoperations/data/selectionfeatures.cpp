@@ -1,6 +1,9 @@
 #include <QString>
+#include <algorithm>
 #include <functional>
 #include <future>
+#include <map>
+#include <mutex>
 #include <memory>
 #include "kernel.h"
 #include "coverage.h"
@@ -19,6 +22,7 @@
 #include "operationhelperfeatures.h"
 #include "commandhandler.h"
 #include "featureiterator.h"
+#include "spatialindex.h"
 #include "selectionfeatures.h"
 
 using namespace Ilwis;
@@ -46,24 +50,45 @@ bool SelectionFeatures::execute(ExecutionContext *ctx, SymbolTable &symTable)
     IFeatureCoverage outputFC = _outputObj.get<FeatureCoverage>();
     IFeatureCoverage inputFC = _inputObj.get<FeatureCoverage>();
 
-    SubSetAsyncFunc selection = [&](const std::vector<quint32>& subset ) -> bool {
-        FeatureIterator iterIn(inputFC, subset);
-
-        for_each(iterIn, iterIn.end(), [&](SPFeatureI feature){
-            QVariant v = feature->cell(_attribColumn);
-            SPFeatureI newFeature = outputFC->newFeatureFrom(feature);
-            _attTable->record(NEW_RECORD,{newFeature->featureid(), v});
-
-            ++iterIn;
+    bool boxSelection = _box.isValid() && !_box.isNull();
+    // each task collects its features and attribute values; they are added in the order of the tasks when all tasks are done
+    std::map<quint32, std::pair<Features, std::vector<QVariant>>> selected;
+    std::mutex mutex;
+    SubSetAsyncFunc selection = [&](quint32 begin, quint32 end ) -> bool {
+        std::vector<quint32> inRange;
+        if ( boxSelection) { // only the features of this range that were selected by the spatial index
+            auto first = std::lower_bound(_inBox.begin(), _inBox.end(), begin);
+            inRange.assign(first, std::lower_bound(first, _inBox.end(), end));
+            if ( inRange.size() == 0)
+                return true;
+        }
+        FeatureIterator iterIn = boxSelection ? FeatureIterator(inputFC, inRange) : FeatureIterator(inputFC, begin, end);
+        std::pair<Features, std::vector<QVariant>> result;
+        for(; iterIn != iterIn.end(); ++iterIn) {
+            SPFeatureI feature = *iterIn;
+            result.first.push_back(outputFC->createFeatureFrom(feature));
+            if ( _attTable.isValid())
+                result.second.push_back(feature->cell(_attribColumn));
         }
-        );
+        Locker lock(mutex);
+        selected[begin] = std::move(result);
         return true;
     };
-    ctx->_threaded = false;
-    bool resource = OperationHelperFeatures::execute(ctx,selection, inputFC, outputFC, _attTable);
+    bool resource = OperationHelperFeatures::execute(ctx,selection, inputFC, outputFC);
+    for(auto& task : selected) {
+        outputFC->addFeatures(task.second.first);
+        if ( _attTable.isValid()) {
+            for(quint32 i = 0; i < task.second.first.size(); ++i)
+                if ( !task.second.first[i].isNull())
+                    _attTable->record(NEW_RECORD,{task.second.first[i]->featureid(), task.second.second[i]});
+        }
+    }
 
     if ( resource && ctx != 0) {
-        outputFC->attributeTable(_attTable);
+        if ( _attTable.isValid()) {
+            OperationHelper::updateRanges(_attTable);
+            outputFC->attributeTable(_attTable);
+        }
         QVariant value;
         value.setValue<IFeatureCoverage>(outputFC);
         ctx->addOutput(symTable, value, outputFC->name(), itFEATURE,outputFC->source());
@@ -134,8 +159,9 @@ Ilwis::OperationImplementation::State SelectionFeatures::prepare(ExecutionContex
          _attTable->addColumn(FEATUREIDCOLUMN,covdom);
          _attTable->addColumn(_attribColumn, inputFC->attributeTable()->columndefinition(_attribColumn).datadef().domain());
      }
-     if ( (_box.isValid() && !_box.isNull()) == 0) {
-        //TODO selections in features on bounding box
+     if ( _box.isValid() && !_box.isNull()) {
+         Box2D<double> box(Coordinate2d(_box.min_corner().x(), _box.min_corner().y()), Coordinate2d(_box.max_corner().x(), _box.max_corner().y()));
+         _inBox = inputFC->spatialIndex()->window(box);
      }
      return sPREPARED;
 }
@@ -22,6 +22,7 @@ private:
     QString _attribColumn;
     ITable _attTable;
     Box3D<double> _box;
+    std::vector<quint32> _inBox;
 };
 }
 }
@@ -1,15 +1,21 @@
 #include <functional>
 #include <future>
+#include <cmath>
+#include <limits>
 #include "kernel.h"
 #include "raster.h"
 #include "symboltable.h"
 #include "ilwisoperation.h"
 #include "rasterinterpolator.h"
+#include "coordinatetransformer.h"
+#include "gridtransformer.h"
 #include "resampleraster.h"
 
 using namespace Ilwis;
 using namespace BaseOperations;
 
+#define STRIPSIZE 64
+
 
 Ilwis::OperationImplementation *ResampleRaster::create(quint64 metaid, const Ilwis::OperationExpression &expr)
 {
@@ -26,6 +32,39 @@ ResampleRaster::ResampleRaster(quint64 metaid, const Ilwis::OperationExpression
 {
 }
 
+void ResampleRaster::prepareInterpolator(RasterInterpolator& interpolator, const std::vector<Pixel_d>& strip, qint32 xsize, const Size& sourceSize) const
+{
+    if ( _method >= RasterInterpolator::ipLANCZOS && strip.size() > 1) {
+        // the footprint of an output pixel is estimated from the distances to its neighbours in the middle of the strip
+        quint32 middle = std::min((quint32)strip.size() / 2, (quint32)strip.size() - 2);
+        const Pixel_d& center = strip[middle];
+        const Pixel_d& right = strip[middle + 1];
+        const Pixel_d& below = middle + xsize < strip.size() ? strip[middle + xsize] : right; // a strip of one row is assumed square
+        if ( center.isValid() && right.isValid() && below.isValid()) {
+            double fx = std::hypot(right.x() - center.x(), right.y() - center.y());
+            double fy = std::hypot(below.x() - center.x(), below.y() - center.y());
+            interpolator.setFootprint(fx, fy);
+        }
+    }
+    // the source values under the strip are copied once to the interpolator
+    double xmin = std::numeric_limits<double>::max(), ymin = xmin, xmax = -xmin, ymax = -xmin;
+    for(const Pixel_d& pix : strip) {
+        if ( !pix.isValid())
+            continue;
+        xmin = std::min(xmin, pix.x()); xmax = std::max(xmax, pix.x());
+        ymin = std::min(ymin, pix.y()); ymax = std::max(ymax, pix.y());
+    }
+    if ( xmin > xmax) {
+        interpolator.clearWindow();
+        return;
+    }
+    // positions outside the input raster only need the window to reach its edge
+    auto clamp = [](double v, double vmax) -> qint32 { return (qint32)std::floor(std::max(-1.0, std::min(vmax, v))); };
+    Pixel pmin(clamp(xmin, sourceSize.xsize()), clamp(ymin, sourceSize.ysize()));
+    Pixel pmax(clamp(xmax, sourceSize.xsize()), clamp(ymax, sourceSize.ysize()));
+    interpolator.setWindow(Box2D<qint32>(pmin, pmax));
+}
+
 bool ResampleRaster::execute(ExecutionContext *ctx, SymbolTable& symTable)
 {
     if (_prepState == sNOTPREPARED)
@@ -35,17 +74,29 @@ bool ResampleRaster::execute(ExecutionContext *ctx, SymbolTable& symTable)
     IRasterCoverage inputRaster = _inputObj.get<RasterCoverage>();
     SPTranquilizer trq = kernel()->createTrq("resample", "", outputRaster->size().ysize(),1);
 
+    GridTransformer transformer(outputRaster->georeference(), inputRaster->georeference(), _tolerance);
+
     BoxedAsyncFunc resampleFun = [&](const Box3D<qint32>& box) -> bool {
         PixelIterator iterOut(outputRaster,box);
         iterOut.setTranquilizer(trq);
         RasterInterpolator interpolator(inputRaster, _method);
         SPRange range = inputRaster->datadef().range();
+        qint32 xmin = box.min_corner().x();
+        qint32 xsize = box.max_corner().x() - xmin + 1;
+        std::vector<Pixel_d> strip;
+        qint32 stripStart = iUNDEF, stripEnd = iUNDEF;
         PixelIterator iterEnd = iterOut.end();
         while(iterOut != iterEnd) {
            Voxel position = iterOut.position();
-           Coordinate cOut = outputRaster->georeference()->pixel2Coord(Pixel_d(position.x(),(position.y())));
-           Coordinate cIn = inputRaster->coordinateSystem()->coord2coord(outputRaster->coordinateSystem(),cOut);
-           double v = interpolator.coord2value(cIn);
+           if ( position.y() < stripStart || position.y() > stripEnd) { // the input positions are computed for a strip of rows at a time
+               stripStart = position.y();
+               stripEnd = std::min(stripStart + STRIPSIZE - 1, box.max_corner().y());
+               Box2D<qint32> block(Pixel(xmin, stripStart), Pixel(box.max_corner().x(), stripEnd));
+               transformer.transform(block, strip);
+               prepareInterpolator(interpolator, strip, xsize, inputRaster->size());
+           }
+           const Pixel_d& pixIn = strip[(position.y() - stripStart) * xsize + position.x() - xmin];
+           double v = pixIn.isValid() ? interpolator.pix2value(Point3D<double>(pixIn.x(), pixIn.y(), 0)) : rUNDEF;
            *iterOut = range->ensure(v);
             ++iterOut;
         }
@@ -95,10 +146,24 @@ Ilwis::OperationImplementation::State ResampleRaster::prepare(ExecutionContext *
         _method = RasterInterpolator::ipBILINEAR;
     else if (  method.toLower() == "bicubic")
         _method =RasterInterpolator::ipBICUBIC;
+    else if (  method.toLower() == "lanczos")
+        _method =RasterInterpolator::ipLANCZOS;
+    else if (  method.toLower() == "average")
+        _method =RasterInterpolator::ipAVERAGE;
+    else if (  method.toLower() == "mode")
+        _method =RasterInterpolator::ipMODE;
     else {
         ERROR3(ERR_ILLEGAL_PARM_3,"method",method,"resample");
         return sPREPAREFAILED;
     }
+    if ( _expression.parameterCount() == 4) {
+        bool ok;
+        _tolerance = _expression.parm(3).value().toDouble(&ok);
+        if ( !ok || _tolerance < 0) {
+            ERROR3(ERR_ILLEGAL_PARM_3,"tolerance",_expression.parm(3).value(),"resample");
+            return sPREPAREFAILED;
+        }
+    }
 
     return sPREPARED;
 }
@@ -109,9 +174,9 @@ quint64 ResampleRaster::createMetadata()
     Resource resource(QUrl(url), itOPERATIONMETADATA);
     resource.addProperty("namespace","ilwis");
     resource.addProperty("longname","resample");
-    resource.addProperty("syntax","resample(inputgridcoverage,targetgeoref,nearestneighbour|bilinear|bicubic)");
+    resource.addProperty("syntax","resample(inputgridcoverage,targetgeoref,nearestneighbour|bilinear|bicubic|lanczos|average|mode[,tolerance])");
     resource.addProperty("description",TR("translates a rastercoverage from one geometry (coordinatesystem+georeference) to another"));
-    resource.addProperty("inparameters","3");
+    resource.addProperty("inparameters","3|4");
     resource.addProperty("pin_1_type", itRASTER);
     resource.addProperty("pin_1_name", TR("input rastercoverage"));
     resource.addProperty("pin_1_desc",TR("input rastercoverage with domain any domain"));
@@ -120,7 +185,10 @@ quint64 ResampleRaster::createMetadata()
     resource.addProperty("pin_2_desc",TR("the georeference to which the input coverage will be morphed"));
     resource.addProperty("pin_3_type", itSTRING);
     resource.addProperty("pin_3_name", TR("Resampling method"));
-    resource.addProperty("pin_3_desc",TR("The method used to aggregate pixels from the input map in the geometry of the output map"));
+    resource.addProperty("pin_3_desc",TR("The method used to aggregate pixels from the input map in the geometry of the output map; lanczos, average and mode are meant for down sampling"));
+    resource.addProperty("pin_4_type", itDOUBLE);
+    resource.addProperty("pin_4_name", TR("tolerance"));
+    resource.addProperty("pin_4_desc",TR("optional maximum error (in input pixels) of the approximated pixel positions; 0 computes every position exactly. Default is 0.125"));
     resource.addProperty("outparameters",1);
     resource.addProperty("pout_1_type", itRASTER);
     resource.addProperty("pout_1_name", TR("output rastercoverage"));
@@ -17,10 +17,13 @@ public:
 
 
 private:
+    void prepareInterpolator(RasterInterpolator& interpolator, const std::vector<Pixel_d>& strip, qint32 xsize, const Size& sourceSize) const;
+
     IIlwisObject _inputObj;
     IIlwisObject _outputObj;
     IGeoReference _targetGrf;
     Ilwis::RasterInterpolator::InterpolationMethod _method;
+    double _tolerance = 0.125;
 
 };
 }
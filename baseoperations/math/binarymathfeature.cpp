@@ -1,11 +1,15 @@
 #include <functional>
 #include <future>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 #include "kernel.h"
 #include "coverage.h"
 #include "numericrange.h"
 #include "numericdomain.h"
 #include "columndefinition.h"
 #include "table.h"
+#include "tablemerger.h"
 #include "attributerecord.h"
 #include "polygon.h"
 #include "geometry.h"
@@ -15,16 +19,148 @@
 #include "featurefactory.h"
 #include "featurecoverage.h"
 #include "featureiterator.h"
+#include "spatialindex.h"
+#include "coordinatetransformer.h"
 #include "symboltable.h"
 #include "OperationExpression.h"
 #include "operationmetadata.h"
 #include "operation.h"
+#include "operationhelperfeatures.h"
 #include "commandhandler.h"
 #include "binarymathfeature.h"
 
 using namespace Ilwis;
 using namespace BaseOperations;
 
+namespace {
+typedef boost::geometry::model::multi_polygon<Polygon> MultiPolygon;
+
+// the polygons of the features of a coverage in the target coordinate system, by position of the feature in the coverage
+struct PolygonSet {
+    std::vector<MultiPolygon> _polygons;
+    std::vector<quint64> _featureids;
+};
+
+// a part of the overlay with the positions of the features it comes from; iUNDEF if it is not covered by the other coverage
+struct Piece {
+    Polygon _polygon;
+    quint32 _position1;
+    quint32 _position2;
+};
+
+class AddPolygon : public boost::static_visitor<void> {
+public:
+    AddPolygon(MultiPolygon& polygons) : _polygons(polygons) {}
+
+    void operator()(const Polygon& pol) const {
+        _polygons.push_back(pol);
+    }
+    template<typename GeometryType> void operator()(const GeometryType&) const {} // only polygons take part in an overlay
+
+private:
+    MultiPolygon& _polygons;
+};
+
+void transform(const CoordinateTransformer& transformer, std::vector<Coordinate2d>& ring)
+{
+    std::vector<Coordinate> crds(ring.begin(), ring.end());
+    std::vector<Coordinate> converted;
+    if (!transformer.transform(crds, converted)) {
+        ring.clear();
+        return;
+    }
+    for(quint32 i = 0; i < ring.size(); ++i)
+        ring[i] = Coordinate2d(converted[i].x(), converted[i].y());
+}
+
+void loadPolygons(const IFeatureCoverage& fc, const ICoordinateSystem& csyTarget, PolygonSet& set)
+{
+    SPCoordinateTransformer transformer = CoordinateTransformer::transformer(fc->coordinateSystem(), csyTarget);
+    FeatureIterator iter(fc);
+    for(; iter != iter.end(); ++iter) {
+        SPFeatureI feature = *iter;
+        MultiPolygon polygons;
+        for(quint32 t = 0; t < feature->trackSize(); ++t)
+            feature->geometry(t).apply(AddPolygon(polygons));
+        if ( !transformer->isIdentity()) {
+            for(Polygon& pol : polygons) {
+                transform(*transformer, pol.outer());
+                for(auto& ring : pol.inners())
+                    transform(*transformer, ring);
+            }
+        }
+        boost::geometry::correct(polygons); // the clipping algorithms need closed rings in the orientation of the polygon type
+        set._polygons.push_back(std::move(polygons));
+        set._featureids.push_back(feature->featureid());
+    }
+}
+
+void addPieces(MultiPolygon& polygons, quint32 position1, quint32 position2, std::vector<Piece>& pieces)
+{
+    for(Polygon& pol : polygons) {
+        if ( boost::geometry::area(pol) != 0) // touching polygons give degenerate parts
+            pieces.push_back({std::move(pol), position1, position2});
+    }
+}
+
+/*
+ clips the polygons of the feature at a position against the polygons of the other coverage whose envelopes overlap them. Intersect adds the
+ common parts, subtract the part that is not covered by the other coverage. The positions of the pieces are in the order (first, second) of
+ the coverages of the operation, whichever of both is being iterated.
+ */
+void clip(const PolygonSet& set, const PolygonSet& other, const SpatialIndex& index, const CoordinateTransformer& toOther, quint32 position,
+          bool intersect, bool subtract, bool isFirst, std::vector<Piece>& pieces)
+{
+    const MultiPolygon& polygons = set._polygons[position];
+    if ( polygons.empty())
+        return;
+    Box2D<double> envelope;
+    boost::geometry::envelope(polygons, envelope);
+    std::vector<quint32> candidates = index.window(toOther.transform(envelope));
+    MultiPolygon rest = polygons;
+    for(quint32 candidate : candidates) {
+        if ( candidate >= other._polygons.size() || other._polygons[candidate].empty())
+            continue;
+        const MultiPolygon& polygons2 = other._polygons[candidate];
+        if ( intersect) {
+            MultiPolygon common;
+            boost::geometry::intersection(polygons, polygons2, common);
+            addPieces(common, isFirst ? position : candidate, isFirst ? candidate : position, pieces);
+        }
+        if ( subtract && !rest.empty()) {
+            MultiPolygon remaining;
+            boost::geometry::difference(rest, polygons2, remaining);
+            rest.swap(remaining);
+        }
+    }
+    if ( subtract)
+        addPieces(rest, isFirst ? position : iUNDEF, isFirst ? iUNDEF : position, pieces);
+}
+
+std::unordered_map<quint64, quint32> recordIndex(const ITable& tbl)
+{
+    std::unordered_map<quint64, quint32> index;
+    if ( !tbl.isValid())
+        return index;
+    std::vector<QVariant> ids = tbl->column(FEATUREIDCOLUMN);
+    for(quint32 rec = 0; rec < ids.size(); ++rec) {
+        bool ok;
+        quint64 id = ids[rec].toULongLong(&ok);
+        if ( ok)
+            index.insert({id, rec}); // the first record of a feature wins, as in AttributeRecord
+    }
+    return index;
+}
+
+std::vector<QVariant> attributes(const ITable& tbl, const std::unordered_map<quint64, quint32>& index, quint64 featureid)
+{
+    auto iter = index.find(featureid);
+    if ( iter == index.end())
+        return std::vector<QVariant>();
+    return tbl->record(iter->second);
+}
+}
+
 BinaryMathFeature::BinaryMathFeature()
 {
 }
@@ -39,12 +175,106 @@ bool BinaryMathFeature::execute(ExecutionContext *ctx, SymbolTable &symTable)
         if((_prepState = prepare(ctx, symTable)) != sPREPARED)
             return false;
 
-    //IFeatureCoverage outputFC = _outputFeatures.get<FeatureCoverage>();
-    IFeatureCoverage inputFC = _outputFeatures.get<FeatureCoverage>();
-    FeatureIterator iterIn(inputFC);
-    for_each(iterIn, iterIn.end(), [&](SPFeatureI feature){
-        _outputFeatures->newFeatureFrom(feature);
-    });
+    bool res = _operator == otPLUS ? addFeatures() : overlay(ctx);
+    if ( res && ctx != 0) {
+        OperationHelper::updateRanges(_attTable);
+        _outputFeatures->attributeTable(_attTable);
+        QVariant value;
+        value.setValue<IFeatureCoverage>(_outputFeatures);
+        ctx->addOutput(symTable, value, _outputFeatures->name(), itFEATURE,_outputFeatures->source());
+    }
+    return res;
+}
+
+bool BinaryMathFeature::addFeatures()
+{
+    quint32 idColumn = _attTable->columnIndex(FEATUREIDCOLUMN);
+    for(int set = 0; set < 2; ++set) {
+        const IFeatureCoverage& inputFC = set == 0 ? _inputFeatureSet1 : _inputFeatureSet2;
+        ITable inputTable = inputFC->attributeTable();
+        auto index = recordIndex(inputTable);
+        Features features;
+        FeatureIterator iterIn(inputFC);
+        for(; iterIn != iterIn.end(); ++iterIn) {
+            SPFeatureI feature = _outputFeatures->createFeatureFrom(*iterIn);
+            if ( feature.isNull())
+                continue;
+            std::vector<QVariant> rec = attributes(inputTable, index, (*iterIn)->featureid());
+            rec = set == 0 ? _merger.mergeRecords(rec, {}) : _merger.mergeRecords({}, rec);
+            rec.resize(std::max<quint32>(rec.size(), idColumn + 1));
+            rec[idColumn] = feature->featureid();
+            _attTable->record(NEW_RECORD, rec);
+            features.push_back(feature);
+        }
+        _outputFeatures->addFeatures(features);
+    }
+    return true;
+}
+
+bool BinaryMathFeature::overlay(ExecutionContext *ctx)
+{
+    PolygonSet set1, set2;
+    loadPolygons(_inputFeatureSet1, _csyTarget, set1);
+    loadPolygons(_inputFeatureSet2, _csyTarget, set2);
+
+    // each task collects its pieces; they become features in the order of the tasks, so the result does not depend on the scheduling
+    std::map<quint32, std::vector<Piece>> pieces;
+    std::mutex mutex;
+    auto pass = [&](IFeatureCoverage& inputFC, const PolygonSet& set, const IFeatureCoverage& otherFC, const PolygonSet& other,
+            bool intersect, bool subtract, bool isFirst) -> bool {
+        SPSpatialIndex index = otherFC->spatialIndex();
+        SPCoordinateTransformer toOther = CoordinateTransformer::transformer(_csyTarget, otherFC->coordinateSystem());
+        quint32 offset = isFirst ? 0 : set1._polygons.size(); // the second pass comes after the first
+        SubSetAsyncFunc clipFunc = [&](quint32 begin, quint32 end) -> bool {
+            std::vector<Piece> result;
+            for(quint32 position = begin; position < std::min<quint32>(end, set._polygons.size()); ++position)
+                clip(set, other, *index, *toOther, position, intersect, subtract, isFirst, result);
+            Locker lock(mutex);
+            pieces[offset + begin] = std::move(result);
+            return true;
+        };
+        return OperationHelperFeatures::execute(ctx, clipFunc, inputFC, _outputFeatures);
+    };
+
+    bool res = true;
+    switch(_operator) {
+    case otINTERSECT:
+        res = pass(_inputFeatureSet1, set1, _inputFeatureSet2, set2, true, false, true); break;
+    case otMINUS:
+        res = pass(_inputFeatureSet1, set1, _inputFeatureSet2, set2, false, true, true); break;
+    case otUNION:
+        res = pass(_inputFeatureSet1, set1, _inputFeatureSet2, set2, true, true, true) &&
+              pass(_inputFeatureSet2, set2, _inputFeatureSet1, set1, false, true, false);
+        break;
+    default:
+        return false;
+    }
+    if (!res)
+        return false;
+
+    ITable table1 = _inputFeatureSet1->attributeTable();
+    ITable table2 = _inputFeatureSet2->attributeTable();
+    auto index1 = recordIndex(table1);
+    auto index2 = recordIndex(table2);
+    quint32 idColumn = _attTable->columnIndex(FEATUREIDCOLUMN);
+    for(auto& task : pieces) {
+        Features features;
+        for(Piece& piece : task.second) {
+            SPFeatureI feature = _outputFeatures->createFeature(Geometry(piece._polygon));
+            std::vector<QVariant> rec1, rec2;
+            if ( piece._position1 != (quint32)iUNDEF)
+                rec1 = attributes(table1, index1, set1._featureids[piece._position1]);
+            if ( piece._position2 != (quint32)iUNDEF)
+                rec2 = attributes(table2, index2, set2._featureids[piece._position2]);
+            std::vector<QVariant> rec = _merger.mergeRecords(rec1, rec2);
+            rec.resize(std::max<quint32>(rec.size(), idColumn + 1));
+            rec[idColumn] = feature->featureid();
+            _attTable->record(NEW_RECORD, rec);
+            features.push_back(feature);
+        }
+        _outputFeatures->addFeatures(features);
+        task.second.clear();
+    }
     return true;
 }
 
@@ -65,6 +295,21 @@ OperationImplementation::State BinaryMathFeature::prepare(ExecutionContext *ctx,
         ERROR2(ERR_COULD_NOT_LOAD_2,featureCovName,"" );
         return sPREPAREFAILED;
     }
+    if ( _expression.parameterCount() > 2) {
+        QString oper = _expression.parm(2).value().toLower();
+        if ( oper == "add")
+            _operator = otPLUS;
+        else if ( oper == "difference" || oper == "substract")
+            _operator = otMINUS;
+        else if ( oper == "intersection")
+            _operator = otINTERSECT;
+        else if ( oper == "union")
+            _operator = otUNION;
+        else {
+            ERROR3(ERR_ILLEGAL_PARM_3,"operator",oper,"binarymathfeatures");
+            return sPREPAREFAILED;
+        }
+    }
     bool ok = false;
     if ( ctx->_masterCsy != sUNDEF) {
         ok = _csyTarget.prepare(ctx->_masterCsy);
@@ -81,17 +326,33 @@ OperationImplementation::State BinaryMathFeature::prepare(ExecutionContext *ctx,
     Box2D<double> envelope = addEnvelopes();
     _outputFeatures->setCoordinateSystem(_csyTarget);
     _outputFeatures->envelope(envelope);
-    //Table::mergeTables(_inputFeatureSet1->attributeTable(), _inputFeatureSet2->attributeTable());
     QString outname = _expression.parm(0,false).value();
     if ( outname != sUNDEF)
         _outputFeatures->setName(outname);
 
+    // add shares the columns that both tables have; the parts of an overlay keep the attributes of both features apart
+    QString url = "ilwis://internal/" + outname;
+    Resource tblResource(url, itFLATTABLE);
+    _attTable.prepare(tblResource);
+    int options = _operator == otPLUS ? TableMerger::moMERGECOLUMNS : TableMerger::moSEPARATECOLUMNS;
+    if (!_merger.mergeMetadataTables(_attTable, _inputFeatureSet1->attributeTable(), _inputFeatureSet2->attributeTable(), options)) {
+        ERROR1(ERR_NO_INITIALIZED_1, "output attribute table");
+        return sPREPAREFAILED;
+    }
+    if ( _attTable->columnIndex(FEATUREIDCOLUMN) == (quint32)iUNDEF) {
+        IDomain covdom;
+        if (!covdom.prepare("count")){
+            return sPREPAREFAILED;
+        }
+        _attTable->addColumn(FEATUREIDCOLUMN,covdom);
+    }
+
     return sPREPARED;
 }
 
 Box3D<double> BinaryMathFeature::addEnvelopes() const {
-    Box2D<double> envelope = _csyTarget->convertEnvelope(_inputFeatureSet1->coordinateSystem(),_inputFeatureSet1->envelope());
-    envelope += _csyTarget->convertEnvelope(_inputFeatureSet2->coordinateSystem(),_inputFeatureSet2->envelope());
+    Box2D<double> envelope = CoordinateTransformer::transformer(_inputFeatureSet1->coordinateSystem(), _csyTarget)->transform(_inputFeatureSet1->envelope());
+    envelope += CoordinateTransformer::transformer(_inputFeatureSet2->coordinateSystem(), _csyTarget)->transform(_inputFeatureSet2->envelope());
     return envelope;
 }
 
@@ -101,8 +362,8 @@ quint64 BinaryMathFeature::createMetadata()
     Resource resource(QUrl(url), itOPERATIONMETADATA);
     resource.addProperty("namespace","ilwis");
     resource.addProperty("longname","binarymathfeatures");
-    resource.addProperty("syntax","binarymathfeatures(featurecoverage1,featurescoverage2,add|substract)");
-    resource.addProperty("description",TR("generates a new featurecoverage that puts all the features of both coverages into one coverage"));
+    resource.addProperty("syntax","binarymathfeatures(featurecoverage1,featurescoverage2,add|difference|intersection|union)");
+    resource.addProperty("description",TR("generates a new featurecoverage that puts all the features of both coverages into one coverage, or that overlays the polygons of both coverages"));
     resource.addProperty("inparameters","3");
     resource.addProperty("pin_1_type", itFEATURE);
     resource.addProperty("pin_1_name", TR("input feature coverage"));
@@ -113,7 +374,7 @@ quint64 BinaryMathFeature::createMetadata()
     resource.addProperty("pin_3_type", itSTRING);
     resource.addProperty("pin_3_name", TR("Operator"));
     resource.addProperty("pin_3_domain","string");
-    resource.addProperty("pin_3_desc",TR("operator (add, substract) applied to the other 2 input operators"));
+    resource.addProperty("pin_3_desc",TR("operator applied to the other 2 input operators; add keeps all features, difference, intersection and union overlay the polygons"));
     resource.addProperty("outparameters",1);
     resource.addProperty("pout_1_type", itFEATURE);
     resource.addProperty("pout_1_name", TR("output featurecoverage"));
@@ -3,10 +3,17 @@
 
 namespace Ilwis {
 namespace BaseOperations{
+/*!
+ Combines two feature coverages. Add puts the features of both coverages in one coverage. The other operators overlay the polygons of the
+ coverages: intersection gives the parts that are covered by a polygon of both coverages, difference the parts of the polygons of the first
+ coverage that are not covered by the second, union both and the parts of the second coverage that are not covered by the first.
+ Candidate pairs of polygons are found through the spatial index of the other coverage and the polygons are clipped in parallel. Every part
+ becomes a feature; its attributes are the attributes of the features it comes from, in a table merged by TableMerger.
+ */
 class BinaryMathFeature : public OperationImplementation
 {
 public:
-    enum OperatorType{ otPLUS, otMINUS};
+    enum OperatorType{ otPLUS, otMINUS, otINTERSECT, otUNION};
     BinaryMathFeature();
     BinaryMathFeature(quint64 metaid, const Ilwis::OperationExpression &expr);
 
@@ -21,7 +28,13 @@ private:
     IFeatureCoverage _inputFeatureSet2;
     IFeatureCoverage _outputFeatures;
     ICoordinateSystem _csyTarget;
+    OperatorType _operator = otPLUS;
+    ITable _attTable;
+    TableMerger _merger;
+
     Box3D<double> addEnvelopes() const;
+    bool addFeatures();
+    bool overlay(ExecutionContext *ctx);
 };
 }
 }
@@ -21,7 +21,9 @@ SOURCES += core/kernel.cpp \
     core/abstractfactory.cpp \
     core/ilwisobjects/ilwisobject.cpp \
     core/ilwisobjects/geometry/coordinatesystem/coordinatesystem.cpp \
+    core/ilwisobjects/geometry/coordinatesystem/coordinatetransformer.cpp \
     core/ilwisobjects/geometry/georeference/georeference.cpp \
+    core/ilwisobjects/geometry/georeference/gridtransformer.cpp \
     core/ilwisobjects/geometry/georeference/simpelgeoreference.cpp \
     core/ilwisobjects/geometry/georeference/cornersgeoreference.cpp \
     core/ilwisobjects/coverage/coverage.cpp \
@@ -56,9 +58,13 @@ SOURCES += core/kernel.cpp \
     core/ilwisobjects/coverage/pixeliterator.cpp \
     core/util/numericrange.cpp \
     core/ilwisobjects/table/flattable.cpp \
+    core/ilwisobjects/table/columnstore.cpp \
+    core/ilwisobjects/table/columnindex.cpp \
     core/ilwisobjects/table/databasetable.cpp \
     core/ilwisobjects/table/columndefinition.cpp \
     core/ilwisobjects/coverage/featureiterator.cpp \
+    core/ilwisobjects/coverage/spatialindex.cpp \
+    core/ilwisobjects/coverage/geometrystore.cpp \
     core/ilwisobjects/table/basetable.cpp \
     core/ilwisobjects/table/attributerecord.cpp \
     core/ilwisobjects/coverage/geometry.cpp \
@@ -113,7 +119,9 @@ HEADERS += core/kernel.h\
     core/ilwisobjects/ilwisdata.h \
     core/ilwisobjects/ilwisobject.h \
     core/ilwisobjects/geometry/coordinatesystem/coordinatesystem.h \
+    core/ilwisobjects/geometry/coordinatesystem/coordinatetransformer.h \
     core/ilwisobjects/geometry/georeference/georeference.h \
+    core/ilwisobjects/geometry/georeference/gridtransformer.h \
     core/ilwisobjects/geometry/georeference/simpelgeoreference.h \
     core/util/boostext.h \
     core/ilwisobjects/geometry/georeference/cornersgeoreference.h \
@@ -161,9 +169,13 @@ HEADERS += core/kernel.h\
     core/ilwisobjects/coverage/grid.h \
     core/util/size.h \
     core/ilwisobjects/table/flattable.h \
+    core/ilwisobjects/table/columnstore.h \
+    core/ilwisobjects/table/columnindex.h \
     core/ilwisobjects/table/databasetable.h \
     core/ilwisobjects/table/columndefinition.h \
     core/ilwisobjects/coverage/featureiterator.h \
+    core/ilwisobjects/coverage/spatialindex.h \
+    core/ilwisobjects/coverage/geometrystore.h \
     core/ilwisobjects/table/basetable.h \
     core/ilwisobjects/table/attributerecord.h \
     core/ilwisobjects/coverage/featurefactory.h \
@@ -35,7 +35,7 @@ public:
     void envelope(const Box3D<double> &bnds);
 
     AttributeTable attributeTable(AttributeType attType=atCOVERAGE) const ;
-    void attributeTable(const ITable& tbl, AttributeType attType=atCOVERAGE );
+    virtual void attributeTable(const ITable& tbl, AttributeType attType=atCOVERAGE );
     NumericStatistics& statistics();
     const DataDefinition& datadefIndex() const;
     DataDefinition& datadefIndex();
@@ -13,7 +13,7 @@
 
 using namespace Ilwis;
 
-quint64 Feature::_idbase = 0;
+std::atomic<quint64> Feature::_idbase(0);
 
 SPFeatureI::SPFeatureI(FeatureInterface *f) : QSharedPointer<FeatureInterface>(f)
 {
@@ -1,6 +1,7 @@
 #ifndef FEATURE_H
 #define FEATURE_H
 
+#include <atomic>
 #include "Kernel_global.h"
 
 namespace Ilwis {
@@ -96,7 +97,7 @@ private:
     Feature(const SPAttributeRecord& rec);
     Feature& operator=(const Feature& f) ; // no assignment , _featureid is unique
 
-    static quint64 _idbase;
+    static std::atomic<quint64> _idbase; // features are created concurrently by parallel operations
     quint64 _featureid; // unique
     std::vector<SPFeatureNode> _track;
     SPAttributeRecord _record;
@@ -1,3 +1,4 @@
+#include <future>
 #include "kernel.h"
 #include "coverage.h"
 #include "numericrange.h"
@@ -12,9 +13,30 @@
 #include "abstractfactory.h"
 #include "featurefactory.h"
 #include "featurecoverage.h"
+#include "featureiterator.h"
+#include "spatialindex.h"
+#include "geometrystore.h"
 
 using namespace Ilwis;
 
+namespace {
+// the union of the envelopes of the geometries of a feature; undefined if none of them has coordinates
+Box2D<double> featureEnvelope(const SPFeatureI& feature)
+{
+    Box2D<double> env(Coordinate2d(rUNDEF, rUNDEF), Coordinate2d(rUNDEF, rUNDEF));
+    for(quint32 t = 0; t < feature->trackSize(); ++t) {
+        Box2D<double> box = feature->geometry(t).envelope();
+        if ( !box.isValid())
+            continue;
+        if ( env.isValid()) // a default box contains the origin, so it can not be used to start the union
+            env += box;
+        else
+            env = box;
+    }
+    return env;
+}
+}
+
 FeatureCoverage::FeatureCoverage() : _featureTypes(itUNKNOWN),_featureFactory(0)
 {
     _featureInfo.resize(3);
@@ -37,35 +59,83 @@ void FeatureCoverage::featureTypes(IlwisTypes types)
     _featureTypes = types;
 }
 
-SPFeatureI &FeatureCoverage::newFeature(const Geometry& geom) {
+void FeatureCoverage::attributeTable(const ITable &tbl, AttributeType attType)
+{
+    Coverage::attributeTable(tbl, attType);
+    _creationPrepared = false;
+}
+
+SPFeatureI FeatureCoverage::newFeature(const Geometry& geom) {
+    SPFeatureI feature = createFeature(geom);
     Locker lock(_mutex);
+    materialize();
     _featureTypes |= geom.ilwisType();
-    if ( _featureFactory == 0) {
-        _featureFactory = kernel()->factory<FeatureFactory>("FeatureFactory","ilwis");
-    }
-    _record.reset(new AttributeRecord(attributeTable(),FEATUREIDCOLUMN ));
+    _features.push_back(feature);
+    _spatialIndex.reset();
+    _envelopes.reset();
+    _geometries.reset();
+    return feature;
+}
+
+SPFeatureI FeatureCoverage::newFeatureFrom(const SPFeatureI& existingFeature) {
+    SPFeatureI feature = createFeatureFrom(existingFeature);
+    if ( !feature.isNull())
+        addFeatures({feature});
+    return feature;
+}
 
+SPFeatureI FeatureCoverage::createFeature(const Geometry &geom)
+{
+    if ( !_creationPrepared)
+        prepareFeatureCreation();
     CreateFeature create = _featureFactory->getCreator("feature");
-    IFeatureCoverage fcoverage;
-    fcoverage.set(this);
     FeatureInterface *f = create(this);
     f->set(geom);
-    SPFeatureI p(f);
-    _features.push_back(p);
-    return _features.back();
+    return SPFeatureI(f);
 }
 
-SPFeatureI FeatureCoverage::newFeatureFrom(const SPFeatureI& existingFeature) {
-    Locker lock(_mutex);
+SPFeatureI FeatureCoverage::createFeatureFrom(const SPFeatureI &existingFeature)
+{
     if ( existingFeature.isNull() || existingFeature->isValid() == false)
         return SPFeatureI();
-    SPFeatureI newFeature = new Feature(this);
-    for(int i=0; i < existingFeature->trackSize(); ++i)
-        newFeature->set(existingFeature->geometry(),i);
-    _features.push_back(newFeature);
-    quint32 cnt = featureCount(newFeature->ilwisType());
-    setFeatureCount(newFeature->ilwisType(),++cnt );
-    return _features.back();
+    if ( !_creationPrepared)
+        prepareFeatureCreation();
+    SPFeatureI feature = new Feature(this);
+    for(quint32 i=0; i < existingFeature->trackSize(); ++i)
+        feature->set(existingFeature->geometry(i),i);
+    return feature;
+}
+
+void FeatureCoverage::addFeatures(const Features &features)
+{
+    Locker lock(_mutex);
+    materialize();
+    for(const SPFeatureI& feature : features) {
+        if ( feature.isNull())
+            continue;
+        _features.push_back(feature);
+        IlwisTypes tp = feature->ilwisType();
+        setFeatureCount(tp, featureCount(tp) + 1);
+    }
+    _spatialIndex.reset();
+    _envelopes.reset();
+    _geometries.reset();
+}
+
+void FeatureCoverage::prepareFeatureCreation()
+{
+    Locker lock(_mutex);
+    if ( _featureFactory == 0) {
+        _featureFactory = kernel()->factory<FeatureFactory>("FeatureFactory","ilwis");
+    }
+    // all features share one record; it is only replaced when the coverage got another attribute table
+    ITable attTable = attributeTable();
+    quint64 tableId = attTable.isValid() ? attTable->id() : i64UNDEF;
+    if ( _record.isNull() || tableId != _recordTable) {
+        _record.reset(new AttributeRecord(attTable,FEATUREIDCOLUMN ));
+        _recordTable = tableId;
+    }
+    _creationPrepared = true;
 }
 
 
@@ -102,6 +172,143 @@ QSharedPointer<AttributeRecord> FeatureCoverage::record() const
     return _record;
 }
 
+std::shared_ptr<SpatialIndex> FeatureCoverage::spatialIndex()
+{
+    loadFeatures();
+    std::shared_ptr<const std::vector<Box2D<double>>> envelopesOfFeatures = envelopes();
+    Locker lock(_mutex);
+    if ( !_spatialIndex)
+        _spatialIndex.reset(new SpatialIndex(_features, *envelopesOfFeatures));
+    return _spatialIndex;
+}
+
+std::shared_ptr<const std::vector<Box2D<double>>> FeatureCoverage::envelopes()
+{
+    if ( !_storeOnly)
+        loadFeatures();
+    Locker lock(_mutex);
+    if ( _envelopes)
+        return _envelopes;
+
+    auto boxes = std::make_shared<std::vector<Box2D<double>>>();
+    if ( _storeOnly) { // straight from the vertices, without creating the features
+        boxes->reserve(_geometries->featureCount());
+        for(const FeatureView& view : *_geometries)
+            boxes->push_back(view.envelope());
+    } else {
+        boxes->resize(_features.size(), Box2D<double>(Coordinate2d(rUNDEF, rUNDEF), Coordinate2d(rUNDEF, rUNDEF)));
+        auto combine = [&](quint32 begin, quint32 end) {
+            for(quint32 i = begin; i < end; ++i) {
+                if ( !_features[i].isNull())
+                    (*boxes)[i] = featureEnvelope(_features[i]);
+            }
+        };
+        quint32 n = _features.size();
+        quint32 cores = n < 10000 ? 1 : std::max(1, QThread::idealThreadCount());
+        std::vector<std::future<void>> futures;
+        for(quint32 i = 1; i < cores; ++i)
+            futures.push_back(std::async(std::launch::async, combine, (quint64)n * i / cores, (quint64)n * (i + 1) / cores));
+        combine(0, n / cores);
+        for(auto& future : futures)
+            future.get();
+    }
+    _envelopes = boxes;
+    return _envelopes;
+}
+
+FeatureIterator FeatureCoverage::window(const Box2D<double> &box)
+{
+    return subset(spatialIndex()->window(box));
+}
+
+FeatureIterator FeatureCoverage::intersects(const Geometry &geom)
+{
+    return subset(spatialIndex()->intersects(geom));
+}
+
+FeatureIterator FeatureCoverage::nearest(const Coordinate2d &crd, quint32 count)
+{
+    return subset(spatialIndex()->nearest(crd, count));
+}
+
+FeatureIterator FeatureCoverage::subset(const std::vector<quint32> &positions)
+{
+    IFeatureCoverage fcoverage;
+    fcoverage.set(this);
+    FeatureIterator iter(fcoverage, positions);
+    // an empty subset means all features to the iterator, an empty selection is an iterator that is already at its end
+    return positions.size() == 0 ? iter.end() : iter;
+}
+
+std::shared_ptr<const GeometryStore> FeatureCoverage::geometries()
+{
+    if ( !_storeOnly)
+        loadFeatures();
+    Locker lock(_mutex);
+    if ( !_geometries) {
+        _geometries.reset(new GeometryStore());
+        for(const SPFeatureI& feature : _features) {
+            _geometries->newFeature();
+            if ( feature.isNull())
+                continue;
+            for(quint32 t = 0; t < feature->trackSize(); ++t)
+                _geometries->add(feature->geometry(t));
+        }
+    }
+    return _geometries;
+}
+
+void FeatureCoverage::setGeometries(const std::shared_ptr<GeometryStore> &store)
+{
+    Locker lock(_mutex);
+    _features.clear();
+    _spatialIndex.reset();
+    _envelopes.reset();
+    _geometries = store;
+    _storeOnly = store && store->featureCount() > 0;
+    quint32 counts[3] = {0, 0, 0};
+    if ( _storeOnly) {
+        for(const FeatureView& view : *store) {
+            IlwisTypes tp = view.ilwisType();
+            _featureTypes |= tp;
+            if ( tp != itUNKNOWN)
+                ++counts[tp == itPOINT ? 0 : tp == itLINE ? 1 : 2];
+        }
+    }
+    for(int i = 0; i < 3; ++i)
+        _featureInfo[i]._count = counts[i];
+}
+
+bool FeatureCoverage::loadFeatures()
+{
+    Locker loadLock(_loadMutex); // parallel iterators must not load the same features twice
+    {
+        Locker lock(_mutex);
+        if ( _storeOnly) {
+            materialize();
+            return true;
+        }
+    }
+    // loading adds the features through newFeature, which takes the lock itself
+    if ( _features.size() == 0 && !connector().isNull())
+        return connector()->loadBinaryData(this);
+    return true;
+}
+
+void FeatureCoverage::materialize()
+{
+    if ( !_storeOnly)
+        return;
+    _features.reserve(_geometries->featureCount());
+    for(const FeatureView& view : *_geometries) {
+        Feature *feature = new Feature(this);
+        for(quint32 part = 0; part < view.partCount(); ++part)
+            feature->set(view.geometry(part), part);
+        _features.push_back(SPFeatureI(feature));
+    }
+    _storeOnly = false;
+}
+
 void FeatureCoverage::copyTo(IlwisObject *obj)
 {
     Coverage::copyTo(obj);
@@ -109,6 +316,8 @@ void FeatureCoverage::copyTo(IlwisObject *obj)
     fcov->_featureTypes = _featureTypes;
     fcov->_featureInfo = _featureInfo;
     fcov->_features = _features;
+    fcov->_geometries = _geometries;
+    fcov->_storeOnly = _storeOnly;
 }
 
 quint32 FeatureCoverage::featureCount(IlwisTypes types, int ) const
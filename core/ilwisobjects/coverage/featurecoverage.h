@@ -2,6 +2,7 @@
 #define FEATURECOVERAGE_H
 
 #include <memory>
+#include <atomic>
 #include <unordered_map>
 #include "Kernel_global.h"
 
@@ -14,6 +15,8 @@ typedef std::vector<SPFeatureI> Features;
 class FeatureIterator;
 class FeatureFactory;
 class AttributeRecord;
+class SpatialIndex;
+class GeometryStore;
 
 struct FeatureInfo {
     quint32 _count;
@@ -30,13 +33,66 @@ public:
 
     IlwisTypes featureTypes() const;
     void featureTypes(IlwisTypes types);
-    SPFeatureI &newFeature(const Ilwis::Geometry &geom);
+    SPFeatureI newFeature(const Ilwis::Geometry &geom);
     SPFeatureI newFeatureFrom(const Ilwis::SPFeatureI &existingFeature);
+    using Coverage::attributeTable;
+    void attributeTable(const ITable& tbl, AttributeType attType=atCOVERAGE );
+    /*!
+     resolves the feature factory and the attribute record that all new features share. Parallel operations call it once before their
+     tasks start (\se OperationHelperFeatures::execute); createFeature and createFeatureFrom do it on first use and after the attribute
+     table was replaced, otherwise they take no lock
+     */
+    void prepareFeatureCreation();
+    /*!
+     creates a feature that is not yet part of the coverage. Features can be created from several threads at the same time; each thread
+     collects its features and they are added afterwards with addFeatures, in an order that does not depend on the scheduling of the threads.
+     The attribute table of the coverage must not be replaced while features are being created.
+     * \param geom the geometry of the feature
+     * \return the new feature
+     */
+    SPFeatureI createFeature(const Ilwis::Geometry &geom);
+    SPFeatureI createFeatureFrom(const Ilwis::SPFeatureI &existingFeature);
+    /*!
+     adds features that were created by createFeature or createFeatureFrom to the coverage, under one lock
+     */
+    void addFeatures(const Features& features);
     quint32 featureCount(IlwisTypes types=itFEATURE, int index=iUNDEF) const;
     void setFeatureCount(IlwisTypes types, quint32 cnt);
     IlwisTypes ilwisType() const;
     FeatureCoverage *copy();
     QSharedPointer<AttributeRecord> record() const;
+    /*!
+     returns the spatial index on the envelopes of the features. The index is build on first use and dropped when features are added
+     * \return the index, shared with the coverage
+     */
+    std::shared_ptr<SpatialIndex> spatialIndex();
+    /*!
+     returns the envelope of every feature, by position in the coverage; a feature without geometry has an undefined envelope. The envelopes
+     of the geometries are computed when they are set, this combines them per feature in one parallel pass on first use. Dropped when features are added.
+     */
+    std::shared_ptr<const std::vector<Box2D<double>>> envelopes();
+    /*!
+     iterates over the features whose envelope overlaps a box (\se SpatialIndex::window)
+     */
+    FeatureIterator window(const Box2D<double>& box);
+    /*!
+     iterates over the features that intersect a geometry (\se SpatialIndex::intersects)
+     */
+    FeatureIterator intersects(const Geometry& geom);
+    /*!
+     iterates over the features nearest to a position, the nearest first (\se SpatialIndex::nearest)
+     */
+    FeatureIterator nearest(const Coordinate2d& crd, quint32 count=1);
+    /*!
+     returns the geometries of all features in one compact store (\se GeometryStore); the index of a feature in the store is its position
+     in the coverage. For features that were added one by one the store is build on first use and dropped when features are added.
+     */
+    std::shared_ptr<const GeometryStore> geometries();
+    /*!
+     replaces the features of the coverage by the geometries of a store; the coverage takes over the store. This is the way to load large
+     sets of features: Feature objects are only created when the coverage is iterated with a FeatureIterator.
+     */
+    void setGeometries(const std::shared_ptr<GeometryStore>& store);
 
 protected:
     void copyTo(IlwisObject *obj);
@@ -47,7 +103,17 @@ private:
     FeatureFactory *_featureFactory;
     std::mutex _mutex2;
     QSharedPointer<AttributeRecord> _record;
-
+    std::shared_ptr<SpatialIndex> _spatialIndex;
+    std::shared_ptr<const std::vector<Box2D<double>>> _envelopes;
+    std::shared_ptr<GeometryStore> _geometries;
+    bool _storeOnly = false;
+    quint64 _recordTable = i64UNDEF;
+    std::atomic<bool> _creationPrepared{false}; // set when _featureFactory and _record are resolved for the current attribute table
+    std::mutex _loadMutex;
+
+    FeatureIterator subset(const std::vector<quint32>& positions);
+    bool loadFeatures();
+    void materialize();
 
 };
 
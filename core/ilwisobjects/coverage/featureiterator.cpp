@@ -1,4 +1,5 @@
 #include <iterator>
+#include <algorithm>
 
 #include "kernel.h"
 #include "coverage.h"
@@ -26,9 +27,19 @@ FeatureIterator::FeatureIterator(const IFeatureCoverage& fcoverage) : _fcoverage
 }
 
 FeatureIterator::FeatureIterator(const Ilwis::IFeatureCoverage &fcoverage, const std::vector<quint32> &subset) :
+    _fcoverage(fcoverage),
+    _isInitial(true)
+{
+    if ( subset.size() > 0)
+        _subset.reset(new std::vector<quint32>(subset));
+    init();
+}
+
+FeatureIterator::FeatureIterator(const IFeatureCoverage &fcoverage, quint32 begin, quint32 end) :
     _fcoverage(fcoverage),
     _isInitial(true),
-    _subset(subset)
+    _begin(begin),
+    _end(end)
 {
     init();
 }
@@ -39,6 +50,8 @@ FeatureIterator::FeatureIterator(const FeatureIterator &iter)
     _isInitial = iter._isInitial;
     _iterFeatures = iter._iterFeatures;
     _subset = iter._subset;
+    _begin = iter._begin;
+    _end = iter._end;
     _iterPosition = iter._iterPosition;
 }
 
@@ -111,19 +124,16 @@ FeatureIterator FeatureIterator::end()
 bool FeatureIterator::init()
 {
     if ( _isInitial)     {
-        _useVectorIter = _subset.size() == 0 || _subset.size() == _fcoverage->featureCount();
         _isInitial = false;
-        if ( _fcoverage->_features.size() == 0) {
-            bool ok = _fcoverage->connector()->loadBinaryData(_fcoverage.ptr());
-            if (!ok)
-                return false;
-        }
-        if ( _fcoverage->_features.size() > 0 ) {
+        if (!_fcoverage->loadFeatures())
+            return false;
+        _end = std::min(_end, (quint32)_fcoverage->_features.size());
+        if ( _subset) {
             _iterPosition = 0;
-            _iterFeatures = _fcoverage->_features.begin();
-            if ( _subset.size() > 0) {
-                _iterFeatures += _subset[_iterPosition];
-            }
+            _iterFeatures = _subset->size() > 0 && (*_subset)[0] < _end ? _fcoverage->_features.begin() + (*_subset)[0] : _fcoverage->_features.end();
+        } else {
+            _iterPosition = _begin;
+            _iterFeatures = _begin < _end ? _fcoverage->_features.begin() + _begin : _fcoverage->_features.end();
         }
     } else
         return false;
@@ -131,27 +141,21 @@ bool FeatureIterator::init()
 }
 
 bool FeatureIterator::move(qint32 distance) {
-    if (_useVectorIter){
-        _iterFeatures += distance;
-        if ( _iterFeatures == _fcoverage->_features.end()) {
-            _iterFeatures = _fcoverage->_features.end();
-            return false;
-        }
-    }else {
-        if ( (qint32)_iterPosition + distance < 0) {
-            _iterPosition = 0;
-            _iterFeatures = _fcoverage->_features.end();
-            return false;
-        }
-        _iterPosition += distance;
-        if ( _iterPosition >= _subset.size()) {
-            _iterPosition = _subset.size();
-            _iterFeatures = _fcoverage->_features.end();
-            return false;
-        }
-        _iterFeatures = _fcoverage->_features.begin() + _subset[_iterPosition];
-
+    qint64 first = _subset ? 0 : _begin;
+    qint64 last = _subset ? _subset->size() : _end;
+    qint64 position = (qint64)_iterPosition + distance;
+    if ( position < first || position >= last) {
+        _iterPosition = last;
+        _iterFeatures = _fcoverage->_features.end();
+        return false;
+    }
+    _iterPosition = position;
+    quint32 index = _subset ? (*_subset)[position] : position;
+    if ( index >= _end) { // a subset may refer to features that do not exist
+        _iterFeatures = _fcoverage->_features.end();
+        return false;
     }
+    _iterFeatures = _fcoverage->_features.begin() + index;
     return true;
 
 }
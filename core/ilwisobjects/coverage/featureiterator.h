@@ -1,14 +1,28 @@
 #ifndef FEATUREITERATOR_H
 #define FEATUREITERATOR_H
 
+#include <memory>
+
 namespace Ilwis {
 
+/*!
+ Iterates over the features of a feature coverage, over all of them, over a contiguous range of positions or over an explicit subset of
+ positions. A range costs nothing to pass around; an explicit subset is shared by the copies of an iterator, so copying an iterator never
+ copies the subset.
+ */
 class KERNELSHARED_EXPORT FeatureIterator  : public std::iterator<std::random_access_iterator_tag, int>
 {
 public:
     FeatureIterator();
     FeatureIterator(const Ilwis::IFeatureCoverage &fcoverage);
+    /*!
+     iterates over the features at the positions in subset, in the order of subset. An empty subset means all features
+     */
     FeatureIterator(const Ilwis::IFeatureCoverage &fcoverage, const std::vector<quint32>& subset);
+    /*!
+     iterates over the features at the positions begin up to (not including) end. The end is limited to the number of features
+     */
+    FeatureIterator(const Ilwis::IFeatureCoverage &fcoverage, quint32 begin, quint32 end);
     FeatureIterator(const FeatureIterator& iter);
     FeatureIterator& operator++() ;
     FeatureIterator operator++(int);
@@ -25,9 +39,10 @@ private:
     IFeatureCoverage _fcoverage;
     Features::iterator _iterFeatures;
     bool _isInitial;
-    std::vector<quint32> _subset;
-    quint32 _iterPosition = iUNDEF;
-    bool _useVectorIter = true;
+    std::shared_ptr<const std::vector<quint32>> _subset;
+    quint32 _begin = 0;
+    quint32 _end = iUNDEF;
+    quint32 _iterPosition = iUNDEF; // position in the subset or, without subset, in the features of the coverage
 };
 }
 
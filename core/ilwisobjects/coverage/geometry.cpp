@@ -11,8 +11,8 @@
 
 using namespace Ilwis;
 
-Geometry::Geometry(const GeometryType& geom) : _geometry(geom), _bounds(Coordinate2d(rUNDEF, rUNDEF), Coordinate2d(rUNDEF, rUNDEF)){
-
+Geometry::Geometry(const GeometryType& geom) : _geometry(geom){
+    computeEnvelope();
 }
 
 bool Geometry::isValid() const {
@@ -21,58 +21,56 @@ bool Geometry::isValid() const {
 }
 
 Box2D<double> Geometry::envelope() const{
-    if (!_bounds.isValid()) {
-        return const_cast<Geometry *>(this)->envelope();
-    }
     return _bounds;
 }
 
-Box2D<double> Geometry::envelope() {
-    if (!_bounds.isValid()) {
-        switch(_geometry.which()){
-        case 0:
-        {
-            Point2D<double> p = (boost::get<Point2D<> >(_geometry));
-            _bounds = Box2D<double>(p,p);
-            break;
-        }
-        case 1:
-        {
-            Point3D<double> p = (boost::get<Point2D<double> >(_geometry));
-            _bounds =  Box2D<double>(p,p);
-            break;
-        }
-        case 2:
-        {
-            Point3D<double> p = (boost::get<Point3D<double> >(_geometry));
-            _bounds =  Box2D<double>(p,p);
-            break;
-        }
-        case 3:
-        {
-            const Line2D<Coordinate2d>& line = (boost::get<Line2D<Coordinate2d> >(_geometry));
+void Geometry::computeEnvelope() {
+    _bounds = Box2D<double>(Coordinate2d(rUNDEF, rUNDEF), Coordinate2d(rUNDEF, rUNDEF));
+    switch(_geometry.which()){
+    case 0:
+    {
+        const Pixel& p = (boost::get<Pixel >(_geometry));
+        if ( p.isValid())
+            _bounds = Box2D<double>(Coordinate2d(p.x(), p.y()), Coordinate2d(p.x(), p.y()));
+        break;
+    }
+    case 1:
+    {
+        const Coordinate2d& p = (boost::get<Coordinate2d >(_geometry));
+        _bounds =  Box2D<double>(p,p);
+        break;
+    }
+    case 2:
+    {
+        const Coordinate& p = (boost::get<Coordinate >(_geometry));
+        _bounds =  Box2D<double>(Coordinate2d(p.x(), p.y()), Coordinate2d(p.x(), p.y()));
+        break;
+    }
+    case 3:
+    {
+        const Line2D<Coordinate2d>& line = (boost::get<Line2D<Coordinate2d> >(_geometry));
+        if ( line.size() > 0)
             _bounds = boost::geometry::return_envelope<Box2Dd>(line);
-            break;
-        }
-        case 4:
-        {
-            //TODO create line3d
-            const Line2D<Coordinate2d>& line = (boost::get<Line2D<Coordinate2d> >(_geometry));
-            _bounds = boost::geometry::return_envelope<Box2D<double> >(line);
-            break;
+        break;
+    }
+    case 4:
+    {
+        //TODO create line3d
+        const Line2D<Pixel>& line = (boost::get<Line2D<Pixel> >(_geometry));
+        if ( line.size() > 0) {
+            Box2D<qint32> box = boost::geometry::return_envelope<Box2Di>(line);
+            _bounds = Box2D<double>(Coordinate2d(box.min_corner().x(), box.min_corner().y()), Coordinate2d(box.max_corner().x(), box.max_corner().y()));
         }
-        case 5:
-        {
-            Polygon& pol = (boost::get<Polygon >(_geometry));
+        break;
+    }
+    case 5:
+    {
+        const Polygon& pol = (boost::get<Polygon >(_geometry));
+        if ( pol.outer().size() > 0)
             _bounds = boost::geometry::return_envelope<Box2D<double> >(pol);
-        }
-
-        case 6:
-        case 7:
-            return Box2D<double>();
-        }
+        break;
+    }
     }
-    return _bounds;
 }
 
 IlwisTypes Geometry::ilwisType() const {
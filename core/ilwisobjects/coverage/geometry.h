@@ -10,7 +10,7 @@ typedef boost::variant<Pixel, Coordinate2d, Coordinate, Line2D<Coordinate2d>, Li
 
 class KERNELSHARED_EXPORT Geometry {
 public:
-    Geometry() {}
+    Geometry() : _bounds(Coordinate2d(rUNDEF, rUNDEF), Coordinate2d(rUNDEF, rUNDEF)) {}
     Geometry(const GeometryType& geom) ;
 
     template<typename GeometryType> GeometryType toType() const{
@@ -19,10 +19,21 @@ public:
 
     template<typename GeometryType> void setGeometry(const GeometryType& geom) {
         _geometry = geom;
+        computeEnvelope();
+    }
+
+    /*!
+     applies a boost::static_visitor to the geometry, so code can handle each of the geometry types without testing for them one by one
+     */
+    template<typename Visitor> typename Visitor::result_type apply(const Visitor& visitor) const {
+        return boost::apply_visitor(visitor, _geometry);
     }
 
     bool isValid() const ;
-    Box2D<double> envelope() ;
+    /*!
+     returns the envelope of the geometry. It is computed when the geometry is set, so reading it is safe from several threads; a geometry
+     without coordinates has an undefined envelope
+     */
     Box2D<double> envelope() const;
 
     IlwisTypes ilwisType() const ;
@@ -31,6 +42,8 @@ public:
 private:
     GeometryType _geometry;
     Box2D<double> _bounds;
+
+    void computeEnvelope();
 };
 }
 
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <limits>
+#include "kernel.h"
+#include "geometries.h"
+#include "polygon.h"
+#include "geometry.h"
+#include "geometrystore.h"
+
+using namespace Ilwis;
+
+namespace {
+class AddGeometry : public boost::static_visitor<void> {
+public:
+    AddGeometry(GeometryStore& store) : _store(store) {}
+
+    void operator()(const Pixel& p) const {
+        _store.addPoint(p.x(), p.y());
+    }
+    void operator()(const Coordinate2d& p) const {
+        _store.addPoint(p.x(), p.y());
+    }
+    void operator()(const Coordinate& p) const {
+        _store.addPoint(p.x(), p.y());
+    }
+    void operator()(const Line2D<Coordinate2d>& line) const {
+        _store.addLine(line);
+    }
+    void operator()(const Line2D<Pixel>& line) const {
+        Line2D<Coordinate2d> converted;
+        for(const Pixel& p : line)
+            converted.push_back(Coordinate2d(p.x(), p.y()));
+        _store.addLine(converted);
+    }
+    void operator()(const Polygon& pol) const {
+        _store.addPolygon(pol);
+    }
+
+private:
+    GeometryStore& _store;
+};
+}
+
+FeatureView::FeatureView(const GeometryStore *store, quint32 index) : _store(store), _index(index)
+{
+}
+
+bool FeatureView::isValid() const
+{
+    return _store != 0 && _index < _store->featureCount();
+}
+
+quint32 FeatureView::index() const
+{
+    return _index;
+}
+
+quint32 FeatureView::partCount() const
+{
+    return _store->_featureOffsets[_index + 1] - _store->_featureOffsets[_index];
+}
+
+IlwisTypes FeatureView::ilwisType(quint32 part) const
+{
+    if ( part >= partCount())
+        return itUNKNOWN;
+    switch(_store->_partTypes[_store->_featureOffsets[_index] + part]){
+    case GeometryStore::ptPOINT:
+        return itPOINT;
+    case GeometryStore::ptLINE:
+        return itLINE;
+    case GeometryStore::ptPOLYGON:
+        return itPOLYGON;
+    }
+    return itUNKNOWN;
+}
+
+quint32 FeatureView::ringCount(quint32 part) const
+{
+    if ( part >= partCount())
+        return 0;
+    quint32 p = _store->_featureOffsets[_index] + part;
+    return _store->_partOffsets[p + 1] - _store->_partOffsets[p];
+}
+
+quint32 FeatureView::vertexCount(quint32 part, quint32 ring) const
+{
+    if ( ring >= ringCount(part))
+        return 0;
+    quint32 r = _store->_partOffsets[_store->_featureOffsets[_index] + part] + ring;
+    return _store->_ringOffsets[r + 1] - _store->_ringOffsets[r];
+}
+
+const double *FeatureView::x(quint32 part, quint32 ring) const
+{
+    if ( vertexCount(part, ring) == 0)
+        return 0;
+    return &_store->_x[firstVertex(part, ring)];
+}
+
+const double *FeatureView::y(quint32 part, quint32 ring) const
+{
+    if ( vertexCount(part, ring) == 0)
+        return 0;
+    return &_store->_y[firstVertex(part, ring)];
+}
+
+Coordinate2d FeatureView::vertex(quint32 i, quint32 part, quint32 ring) const
+{
+    if ( i >= vertexCount(part, ring))
+        return Coordinate2d();
+    quint32 v = firstVertex(part, ring) + i;
+    return Coordinate2d(_store->_x[v], _store->_y[v]);
+}
+
+Box2D<double> FeatureView::envelope() const
+{
+    Box2D<double> undefined(Coordinate2d(rUNDEF, rUNDEF), Coordinate2d(rUNDEF, rUNDEF));
+    if ( partCount() == 0)
+        return undefined;
+    // the vertices of a feature are consecutive, from the first vertex of its first part up to the first vertex of the next feature
+    quint32 first = _store->_ringOffsets[_store->_partOffsets[_store->_featureOffsets[_index]]];
+    quint32 last = _store->_ringOffsets[_store->_partOffsets[_store->_featureOffsets[_index + 1]]];
+    if ( first == last)
+        return undefined;
+    auto xrange = std::minmax_element(_store->_x.begin() + first, _store->_x.begin() + last);
+    auto yrange = std::minmax_element(_store->_y.begin() + first, _store->_y.begin() + last);
+    return Box2D<double>(Coordinate2d(*xrange.first, *yrange.first), Coordinate2d(*xrange.second, *yrange.second));
+}
+
+Geometry FeatureView::geometry(quint32 part) const
+{
+    switch(ilwisType(part)){
+    case itPOINT:
+        return Geometry(vertex(0, part));
+    case itLINE:
+    {
+        Line2D<Coordinate2d> line;
+        line.resize(vertexCount(part));
+        for(quint32 i = 0; i < line.size(); ++i)
+            line[i] = vertex(i, part);
+        return Geometry(line);
+    }
+    case itPOLYGON:
+    {
+        Polygon pol;
+        quint32 rings = ringCount(part);
+        if ( rings > 1)
+            pol.inners().resize(rings - 1);
+        for(quint32 r = 0; r < rings; ++r) {
+            auto& ring = r == 0 ? pol.outer() : pol.inners()[r - 1];
+            ring.resize(vertexCount(part, r));
+            for(quint32 i = 0; i < ring.size(); ++i)
+                ring[i] = vertex(i, part, r);
+        }
+        return Geometry(pol);
+    }
+    }
+    return Geometry();
+}
+
+quint32 FeatureView::firstVertex(quint32 part, quint32 ring) const
+{
+    return _store->_ringOffsets[_store->_partOffsets[_store->_featureOffsets[_index] + part] + ring];
+}
+
+//------------------------------------------------------------------------
+GeometryStore::GeometryStore()
+{
+    clear();
+}
+
+void GeometryStore::reserve(quint32 features, quint32 vertices)
+{
+    _x.reserve(vertices);
+    _y.reserve(vertices);
+    _featureOffsets.reserve(features + 1);
+    _partOffsets.reserve(features + 1);
+    _partTypes.reserve(features);
+    _ringOffsets.reserve(features + 1);
+}
+
+void GeometryStore::clear()
+{
+    _x.clear();
+    _y.clear();
+    _ringOffsets = {0};
+    _partOffsets = {0};
+    _featureOffsets = {0};
+    _partTypes.clear();
+}
+
+quint32 GeometryStore::newFeature()
+{
+    _featureOffsets.push_back(_partTypes.size());
+    return featureCount() - 1;
+}
+
+void GeometryStore::addPoint(double x, double y)
+{
+    _x.push_back(x);
+    _y.push_back(y);
+    _ringOffsets.push_back(_x.size());
+    endPart(ptPOINT);
+}
+
+void GeometryStore::addLine(const Line2D<Coordinate2d> &line)
+{
+    addRing(line);
+    endPart(ptLINE);
+}
+
+void GeometryStore::addPolygon(const Polygon &pol)
+{
+    addRing(pol.outer());
+    for(const auto& ring : pol.inners())
+        addRing(ring);
+    endPart(ptPOLYGON);
+}
+
+bool GeometryStore::add(const Geometry &geom)
+{
+    if ( featureCount() == 0)
+        return false;
+    geom.apply(AddGeometry(*this));
+    return true;
+}
+
+quint32 GeometryStore::featureCount() const
+{
+    return _featureOffsets.size() - 1;
+}
+
+quint32 GeometryStore::partCount() const
+{
+    return _partTypes.size();
+}
+
+quint32 GeometryStore::vertexCount() const
+{
+    return _x.size();
+}
+
+FeatureView GeometryStore::operator[](quint32 index) const
+{
+    return FeatureView(this, index);
+}
+
+GeometryStore::const_iterator GeometryStore::begin() const
+{
+    return const_iterator(FeatureView(this, 0));
+}
+
+GeometryStore::const_iterator GeometryStore::end() const
+{
+    return const_iterator(FeatureView(this, featureCount()));
+}
+
+void GeometryStore::addRing(const std::vector<Coordinate2d> &ring)
+{
+    for(const Coordinate2d& crd : ring) {
+        _x.push_back(crd.x());
+        _y.push_back(crd.y());
+    }
+    _ringOffsets.push_back(_x.size());
+}
+
+void GeometryStore::endPart(PartType type)
+{
+    _partTypes.push_back(type);
+    _partOffsets.push_back(_ringOffsets.size() - 1);
+    _featureOffsets.back() = _partTypes.size();
+}
@@ -0,0 +1,117 @@
+#ifndef GEOMETRYSTORE_H
+#define GEOMETRYSTORE_H
+
+#include <iterator>
+#include <memory>
+#include "Kernel_global.h"
+
+namespace Ilwis {
+
+class GeometryStore;
+
+/*!
+ A read only view on one feature of a GeometryStore. A view is two words (the store and the index of the feature) and can be copied
+ freely; it is valid as long as the store exists and no features are added to it. The parts of a feature are the geometries of its track,
+ the rings of a part are the outer ring and the holes of a polygon; points and lines have one ring.
+ */
+class KERNELSHARED_EXPORT FeatureView {
+public:
+    FeatureView(const GeometryStore *store=0, quint32 index=iUNDEF);
+
+    bool isValid() const;
+    quint32 index() const;
+    quint32 partCount() const;
+    IlwisTypes ilwisType(quint32 part=0) const;
+    quint32 ringCount(quint32 part=0) const;
+    quint32 vertexCount(quint32 part=0, quint32 ring=0) const;
+    /*!
+     the x coordinates of the vertices of a ring. The coordinates of a ring are consecutive, so the ring can be processed as a plain array
+     */
+    const double *x(quint32 part=0, quint32 ring=0) const;
+    const double *y(quint32 part=0, quint32 ring=0) const;
+    Coordinate2d vertex(quint32 i, quint32 part=0, quint32 ring=0) const;
+    Box2D<double> envelope() const;
+    /*!
+     creates a Geometry for a part. This copies the vertices, it is meant for code that works on Geometry objects
+     */
+    Geometry geometry(quint32 part=0) const;
+
+    FeatureView& operator++() { ++_index; return *this; }
+    bool operator==(const FeatureView& view) const { return _store == view._store && _index == view._index; }
+    bool operator!=(const FeatureView& view) const { return !operator==(view); }
+
+private:
+    const GeometryStore *_store;
+    quint32 _index;
+
+    quint32 firstVertex(quint32 part, quint32 ring) const;
+};
+
+/*!
+ Compact storage of the geometries of a feature coverage as a structure of arrays. The vertices of all features are stored in two flat
+ coordinate arrays; offset arrays divide them into rings, the rings into parts and the parts into features. A point costs some 30 bytes
+ and no allocations of its own, where a Feature with its track and geometry costs some 200 bytes in several allocations.
+ Only x and y are stored.
+ */
+class KERNELSHARED_EXPORT GeometryStore {
+public:
+    friend class FeatureView;
+
+    class const_iterator : public std::iterator<std::forward_iterator_tag, FeatureView> {
+    public:
+        const_iterator(const FeatureView& view) : _view(view) {}
+        const FeatureView& operator*() const { return _view; }
+        const FeatureView *operator->() const { return &_view; }
+        const_iterator& operator++() { ++_view; return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); ++_view; return temp; }
+        bool operator==(const const_iterator& iter) const { return _view == iter._view; }
+        bool operator!=(const const_iterator& iter) const { return _view != iter._view; }
+
+    private:
+        FeatureView _view;
+    };
+
+    GeometryStore();
+
+    void reserve(quint32 features, quint32 vertices);
+    void clear();
+    /*!
+     starts a new feature; the parts that are added after this belong to it
+     * \return the index of the new feature
+     */
+    quint32 newFeature();
+    void addPoint(double x, double y);
+    void addLine(const Line2D<Coordinate2d>& line);
+    void addPolygon(const Polygon& pol);
+    /*!
+     adds a geometry as a part of the last feature
+     * \param geom the geometry
+     * \return false if there is no feature yet
+     */
+    bool add(const Geometry& geom);
+
+    quint32 featureCount() const;
+    quint32 partCount() const;
+    quint32 vertexCount() const;
+    FeatureView operator[](quint32 index) const;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    enum PartType{ptPOINT, ptLINE, ptPOLYGON};
+
+    std::vector<double> _x;
+    std::vector<double> _y;
+    std::vector<quint32> _ringOffsets; // first vertex of each ring, the last element is the number of vertices
+    std::vector<quint32> _partOffsets; // first ring of each part, the last element is the number of rings
+    std::vector<quint32> _featureOffsets; // first part of each feature, the last element is the number of parts
+    std::vector<quint8> _partTypes;
+
+    void addRing(const std::vector<Coordinate2d>& ring);
+    void endPart(PartType type);
+};
+
+typedef std::shared_ptr<GeometryStore> SPGeometryStore;
+}
+
+#endif // GEOMETRYSTORE_H
@@ -199,6 +199,20 @@ inline double &Grid::value(quint32 block, int offset )  {
 
 
 
+void Grid::rowValues(quint32 y, quint32 z, std::vector<double> &values) {
+    values.assign(_size.xsize(), rUNDEF);
+    if ( y >= _size.ysize() || z >= _size.zsize())
+        return;
+    quint32 yoff = y % _maxLines;
+    quint32 block = _blocksPerBand * z + y / _maxLines;
+    if ( _blocks.size() > _inMemoryIndex && !update(block)) // else there is no cache and all blocks are in memory
+        return;
+    GridBlockInternal *gblock = _blocks[block];
+    const std::vector<quint32>& offsets = _offsets[yoff];
+    for(quint32 x = 0; x < values.size(); ++x)
+        values[x] = gblock->at(offsets[x]);
+}
+
 inline void Grid::setValue(quint32 block, int offset, double v ) {
     if ( _blocks.size() <= _inMemoryIndex) {
         _blocks[block]->at(offset) = v;
@@ -77,6 +77,14 @@ public:
     double& value(quint32 block, int offset );
     double value(const Voxel& pix) ;
     void setValue(quint32 block, int offset, double v );
+    /*!
+     copies all values of one row of the grid. The block containing the row is only looked up once, so this is much cheaper
+     than requesting the values of the row one by one
+     * \param y the row
+     * \param z the band
+     * \param values receives the values of the row; undefined values if the row is outside the grid
+     */
+    void rowValues(quint32 y, quint32 z, std::vector<double>& values);
 
     quint32 blocks() const;
     quint32 blocksPerBand() const;
@@ -1,5 +1,6 @@
 #include "kernel.h"
 #include "raster.h"
+#include "coordinatetransformer.h"
 #include "linerasterizer.h"
 #include "tranquilizer.h"
 #include "pixeliterator.h"
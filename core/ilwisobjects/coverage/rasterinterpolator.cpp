@@ -1,24 +1,50 @@
+#include <cmath>
+#include <algorithm>
 #include "kernel.h"
 #include "raster.h"
 #include "rasterinterpolator.h"
 
 using namespace Ilwis;
 
+#define LANCZOS_SIZE 3
+#define MAX_WINDOW (1 << 22)
+
+namespace {
+double lanczosWeight(double t) {
+    if ( t == 0)
+        return 1.0;
+    if ( std::abs(t) >= LANCZOS_SIZE)
+        return 0;
+    double pt = M_PI * t;
+    return LANCZOS_SIZE * std::sin(pt) * std::sin(pt / LANCZOS_SIZE) / (pt * pt);
+}
+}
+
 RasterInterpolator::RasterInterpolator(const IRasterCoverage& raster, int method) : _gcoverage(raster), _method(method) {
     _grid = _gcoverage->grid();
     _grf = _gcoverage->georeference();
     _valid = _grf.isValid() && _grid != 0;
+    _xsize = _gcoverage->size().xsize();
+    _ysize = _gcoverage->size().ysize();
+    for(int i = 0; i < 4; ++i)
+        _rowIndex[i] = _rowBand[i] = iUNDEF;
 }
 
 double RasterInterpolator::pix2value(const Point3D<double>& pix) {
     double v = rUNDEF;
     switch( _method) {
-    case 0: //nearestneighbour
-        return _grid->value(pix);
-    case 1: //bilinear
+    case ipNEARESTNEIGHBOUR:
+        return value((long)std::floor(pix.x()), (long)std::floor(pix.y()), (long)pix.z());
+    case ipBILINEAR:
         return bilinear(pix);
-    case 2: //bicubic
+    case ipBICUBIC:
         return bicubic(pix);
+    case ipLANCZOS:
+        return lanczos(pix);
+    case ipAVERAGE:
+        return average(pix, false);
+    case ipMODE:
+        return average(pix, true);
     }
     return v;
 
@@ -32,6 +58,67 @@ double RasterInterpolator::coord2value(const Coordinate &crd)
      return pix2value(pix);
 }
 
+void RasterInterpolator::setFootprint(double xsize, double ysize)
+{
+    _footprint[0] = std::max(1.0, xsize);
+    _footprint[1] = std::max(1.0, ysize);
+}
+
+long RasterInterpolator::margin() const
+{
+    double footprint = std::max(_footprint[0], _footprint[1]);
+    switch( _method) {
+    case ipNEARESTNEIGHBOUR:
+        return 0;
+    case ipBILINEAR:
+        return 1;
+    case ipBICUBIC:
+        return 2;
+    case ipLANCZOS:
+        return (long)std::ceil(LANCZOS_SIZE * footprint) + 1;
+    default:
+        return (long)std::ceil(footprint / 2) + 1;
+    }
+}
+
+bool RasterInterpolator::setWindow(const Box2D<qint32> &box, long z)
+{
+    long m = margin();
+    long x0 = box.min_corner().x() - m, x1 = box.max_corner().x() + m;
+    long y0 = box.min_corner().y() - m, y1 = box.max_corner().y() + m;
+    if ( x1 < x0 || y1 < y0 || (x1 - x0 + 1) * (y1 - y0 + 1) > MAX_WINDOW) {
+        clearWindow();
+        return false;
+    }
+    long width = x1 - x0 + 1;
+    _window.assign(width * (y1 - y0 + 1), rUNDEF);
+    // only the part of the window that overlaps the grid is copied, the rest remains undefined
+    long cx0 = std::max(0L, x0), cx1 = std::min(_xsize - 1, x1);
+    for(long y = std::max(0L, y0); y <= std::min(_ysize - 1, y1) && cx0 <= cx1; ++y) {
+        const double *values = row(y, z);
+        if ( values)
+            std::copy(values + cx0, values + cx1 + 1, _window.begin() + (y - y0) * width + cx0 - x0);
+    }
+    _windowX0 = x0; _windowX1 = x1;
+    _windowY0 = y0; _windowY1 = y1;
+    _windowBand = z;
+    return true;
+}
+
+void RasterInterpolator::clearWindow()
+{
+    _window.clear();
+    _windowX0 = _windowY0 = 0;
+    _windowX1 = _windowY1 = _windowBand = -1;
+}
+
+const double *RasterInterpolator::windowRow(long y, long z, long x0, long x1) const
+{
+    if ( z != _windowBand || y < _windowY0 || y > _windowY1 || x0 < _windowX0 || x1 > _windowX1)
+        return 0;
+    return &_window[(y - _windowY0) * (_windowX1 - _windowX0 + 1) + x0 - _windowX0];
+}
+
 double RasterInterpolator::bilinear(const Point3D<double>& pix) {
     double y = pix.y() - 0.5;
     double x = pix.x() - 0.5;
@@ -46,9 +133,20 @@ double RasterInterpolator::bilinear(const Point3D<double>& pix) {
     _weight[1] = (1 - deltaY) * deltaX;
     _weight[2] = deltaY * (1 - deltaX);
     _weight[3] = deltaY * deltaX;
+    long z = (long)pix.z();
+    double values[4];
+    const double *row0 = windowRow(_nbrows[0], z, _nbcols[0], _nbcols[1]);
+    const double *row1 = row0 ? windowRow(_nbrows[2], z, _nbcols[0], _nbcols[1]) : 0;
+    if ( row0 && row1) {
+        values[0] = row0[0]; values[1] = row0[1];
+        values[2] = row1[0]; values[3] = row1[1];
+    } else {
+        for (int i = 0; i < 4; ++i)
+            values[i] = value(_nbcols[i], _nbrows[i], z);
+    }
     double tot_weight=0.0, totValue=0.0;
     for (int i = 0; i < 4; ++i) {
-        double rVal = _grid->value({_nbcols[i],_nbrows[i], pix.z()});
+        double rVal = values[i];
         if (rVal != rUNDEF) {
             totValue +=  rVal * _weight[i];
             tot_weight += _weight[i];
@@ -90,10 +188,11 @@ double RasterInterpolator::bicubicPolynom(double values[], const double& delta)
 double RasterInterpolator::bicubicResult(long row, long column, long z, const double& deltaCol)
 {
   long i;
-  if ( row >= _gcoverage->size().ysize())
+  if ( row >= _ysize)
        return rUNDEF;
+  const double *values = windowRow(row, z, column - 1L, column + 2L);
   for( i=0; i<4; ++i){
-      _xvalues[i]= _grid->value({column-1L+i,row, z});
+      _xvalues[i]= values ? values[i] : value(column-1L+i, row, z);
   }
   if(resolveRealUndefs(_xvalues))
     return bicubicPolynom(_xvalues, deltaCol);
@@ -101,6 +200,83 @@ double RasterInterpolator::bicubicResult(long row, long column, long z, const do
   return rUNDEF;
 }
 
+double RasterInterpolator::lanczos(const Point3D<double> &pix)
+{
+    // the kernel is stretched by the footprint, so when down sampling all source pixels under an output pixel contribute
+    double x = pix.x() - 0.5;
+    double y = pix.y() - 0.5;
+    long z = (long)pix.z();
+    long x0 = (long)std::ceil(x - LANCZOS_SIZE * _footprint[0]), x1 = (long)std::floor(x + LANCZOS_SIZE * _footprint[0]);
+    long y0 = (long)std::ceil(y - LANCZOS_SIZE * _footprint[1]), y1 = (long)std::floor(y + LANCZOS_SIZE * _footprint[1]);
+    _weightsX.resize(x1 - x0 + 1);
+    _weightsY.resize(y1 - y0 + 1);
+    for(long i = x0; i <= x1; ++i)
+        _weightsX[i - x0] = lanczosWeight((i - x) / _footprint[0]);
+    for(long j = y0; j <= y1; ++j)
+        _weightsY[j - y0] = lanczosWeight((j - y) / _footprint[1]);
+
+    double totValue = 0, totWeight = 0;
+    for(long j = y0; j <= y1; ++j) {
+        double wy = _weightsY[j - y0];
+        if ( wy == 0)
+            continue;
+        const double *values = windowRow(j, z, x0, x1);
+        double rowValue = 0, rowWeight = 0;
+        for(long i = x0; i <= x1; ++i) {
+            double v = values ? values[i - x0] : value(i, j, z);
+            if ( v != rUNDEF) {
+                rowValue += _weightsX[i - x0] * v;
+                rowWeight += _weightsX[i - x0];
+            }
+        }
+        totValue += wy * rowValue;
+        totWeight += wy * rowWeight;
+    }
+    if ( std::abs(totWeight) < 0.1) // mostly undefined neighbourhood
+        return rUNDEF;
+    return totValue / totWeight;
+}
+
+double RasterInterpolator::average(const Point3D<double> &pix, bool mode)
+{
+    // the source pixels whose centers are within the footprint of the output pixel
+    long x0 = (long)std::ceil(pix.x() - _footprint[0] / 2 - 0.5), x1 = (long)std::ceil(pix.x() + _footprint[0] / 2 - 0.5) - 1;
+    long y0 = (long)std::ceil(pix.y() - _footprint[1] / 2 - 0.5), y1 = (long)std::ceil(pix.y() + _footprint[1] / 2 - 0.5) - 1;
+    long z = (long)pix.z();
+    _samples.clear();
+    for(long j = y0; j <= y1; ++j) {
+        const double *values = windowRow(j, z, x0, x1);
+        for(long i = x0; i <= x1; ++i) {
+            double v = values ? values[i - x0] : value(i, j, z);
+            if ( v != rUNDEF)
+                _samples.push_back(v);
+        }
+    }
+    if ( _samples.size() == 0)
+        return rUNDEF;
+    if ( !mode) {
+        double sum = 0;
+        for(double v : _samples)
+            sum += v;
+        return sum / _samples.size();
+    }
+    // most frequent value; on a tie the smallest value wins
+    std::sort(_samples.begin(), _samples.end());
+    double best = _samples[0];
+    quint32 bestCount = 0;
+    for(quint32 i = 0; i < _samples.size();) {
+        quint32 j = i;
+        while( j < _samples.size() && _samples[j] == _samples[i])
+            ++j;
+        if ( j - i > bestCount) {
+            bestCount = j - i;
+            best = _samples[i];
+        }
+        i = j;
+    }
+    return best;
+}
+
 bool RasterInterpolator::resolveRealUndefs(double values[])
 {
     if ( values[1]==rUNDEF){
@@ -119,3 +295,29 @@ bool RasterInterpolator::resolveRealUndefs(double values[])
     return true;
 }
 
+const double *RasterInterpolator::row(long y, long z)
+{
+    if ( y < 0 || y >= _ysize || z < 0)
+        return 0;
+    for(int i = 0; i < 4; ++i)
+        if ( _rowIndex[i] == y && _rowBand[i] == z)
+            return _rows[i].data();
+    // the cache is filled round robin; when moving to the next row the row that is replaced is the one that was read longest ago
+    int slot = _nextRow;
+    _nextRow = (_nextRow + 1) % 4;
+    _grid->rowValues(y, z, _rows[slot]);
+    _rowIndex[slot] = y;
+    _rowBand[slot] = z;
+    return _rows[slot].data();
+}
+
+double RasterInterpolator::value(long x, long y, long z)
+{
+    const double *values = windowRow(y, z, x, x);
+    if ( values)
+        return *values;
+    if ( x < 0 || x >= _xsize)
+        return rUNDEF;
+    values = row(y, z);
+    return values ? values[x] : rUNDEF;
+}
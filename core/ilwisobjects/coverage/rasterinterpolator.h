@@ -4,21 +4,49 @@
 namespace Ilwis {
 class Grid;
 
+/*!
+ Interpolates the values of a raster at (sub)pixel positions. The rows that were read last are cached in the interpolator, neighbouring
+ positions (as along a row of a resampled raster) are read from the cache instead of from the grid. When the positions of a whole block of
+ output pixels are known in advance (setWindow) the source values of that block, including the margin the method needs, are copied once
+ into a local buffer and all positions inside it are interpolated from the buffer.
+ As a consequence the raster must not change while the interpolator is used and an interpolator should not be shared between threads.
+
+ Lanczos, average and mode are meant for down sampling; they use the footprint (setFootprint) of an output pixel in source pixels.
+ */
 class KERNELSHARED_EXPORT RasterInterpolator
 {
 public:
-    enum InterpolationMethod{ipNEARESTNEIGHBOUR, ipBILINEAR, ipBICUBIC};
+    enum InterpolationMethod{ipNEARESTNEIGHBOUR, ipBILINEAR, ipBICUBIC, ipLANCZOS, ipAVERAGE, ipMODE};
 
     RasterInterpolator(const IRasterCoverage& raster, int method) ;
     double pix2value(const Point3D<double> &pix);
     double coord2value(const Coordinate& crd);
+    /*!
+     sets the size of an output pixel expressed in source pixels. Only used by the lanczos, average and mode methods; a size smaller than 1 is
+     treated as 1. Must be set before setWindow as it determines the margin of the window
+     */
+    void setFootprint(double xsize, double ysize);
+    /*!
+     copies the source values that are needed to interpolate the positions within a box into a local buffer.
+     * \param box the (inclusive) range of source pixels that will be interpolated; the margin needed by the method is added
+     * \param z the band
+     * \return false if the window would be too large; the interpolator then reads from its row cache
+     */
+    bool setWindow(const Box2D<qint32>& box, long z=0);
+    void clearWindow();
 
 private:
     double bilinear(const Point3D<double> &pix) ;
     double bicubic(const Point3D<double> &pix) ;
+    double lanczos(const Point3D<double> &pix) ;
+    double average(const Point3D<double> &pix, bool mode) ;
+    long margin() const;
+    const double *windowRow(long y, long z, long x0, long x1) const;
     double bicubicPolynom(double values[], const double &delta);
     double bicubicResult(long row, long column, long z, const double &deltaCol);
     bool resolveRealUndefs(double values[]);
+    double value(long x, long y, long z);
+    const double *row(long y, long z);
     long _nbrows[4], _nbcols[4];
     double _weight[4];
     double _yvalues[4], _xvalues[4];
@@ -27,6 +55,14 @@ private:
     IGeoReference _grf;
     int _method;
     bool _valid;
+    long _xsize, _ysize;
+    std::vector<double> _rows[4]; // enough for the four rows the bicubic interpolation needs
+    long _rowIndex[4], _rowBand[4];
+    int _nextRow = 0;
+    double _footprint[2] = {1.0, 1.0};
+    std::vector<double> _window;
+    long _windowX0 = 0, _windowY0 = 0, _windowX1 = -1, _windowY1 = -1, _windowBand = -1;
+    std::vector<double> _weightsX, _weightsY, _samples;
 };
 }
 
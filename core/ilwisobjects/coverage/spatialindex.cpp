@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <queue>
+#include <cmath>
+#include <limits>
+#include "kernel.h"
+#include "coverage.h"
+#include "columndefinition.h"
+#include "table.h"
+#include "attributerecord.h"
+#include "polygon.h"
+#include "geometry.h"
+#include "feature.h"
+#include "spatialindex.h"
+
+using namespace Ilwis;
+
+#define NODESIZE 16
+#define HILBERT_ORDER 16
+
+namespace {
+
+// position on the Hilbert curve of a cell of a (2^HILBERT_ORDER)^2 grid
+quint64 hilbert(quint32 x, quint32 y) {
+    quint64 n = 1 << HILBERT_ORDER, d = 0;
+    for(quint64 s = n / 2; s > 0; s /= 2) {
+        quint32 rx = (x & s) > 0;
+        quint32 ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if ( ry == 0) {
+            if ( rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+bool overlaps(const double *b, const Box2D<double>& box) {
+    return b[0] <= box.max_corner().x() && b[2] >= box.min_corner().x() && b[1] <= box.max_corner().y() && b[3] >= box.min_corner().y();
+}
+
+double distance(const double *b, const Coordinate2d& crd) {
+    double dx = std::max(0.0, std::max(b[0] - crd.x(), crd.x() - b[2]));
+    double dy = std::max(0.0, std::max(b[1] - crd.y(), crd.y() - b[3]));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// the geometries of the variant expressed in Coordinate2d so they can be combined in the boost algorithms
+struct Shape {
+    enum Kind{sPOINT, sLINE, sPOLYGON, sNONE};
+
+    Shape() : _kind(sNONE), _line(0), _polygon(0) {}
+
+    const Line2D<Coordinate2d>& line() const { return _line ? *_line : _ownLine; }
+
+    Kind _kind;
+    Coordinate2d _point;
+    const Line2D<Coordinate2d> *_line;
+    Line2D<Coordinate2d> _ownLine;
+    const Polygon *_polygon;
+};
+
+class ShapeOf : public boost::static_visitor<Shape> {
+public:
+    Shape operator()(const Pixel& p) const {
+        return point(p.x(), p.y());
+    }
+    Shape operator()(const Coordinate2d& p) const {
+        return point(p.x(), p.y());
+    }
+    Shape operator()(const Coordinate& p) const {
+        return point(p.x(), p.y());
+    }
+    Shape operator()(const Line2D<Coordinate2d>& line) const {
+        Shape shape;
+        shape._kind = Shape::sLINE;
+        shape._line = &line;
+        return shape;
+    }
+    Shape operator()(const Line2D<Pixel>& line) const {
+        Shape shape;
+        shape._kind = Shape::sLINE;
+        for(const Pixel& p : line)
+            shape._ownLine.push_back(Coordinate2d(p.x(), p.y()));
+        return shape;
+    }
+    Shape operator()(const Polygon& pol) const {
+        Shape shape;
+        shape._kind = Shape::sPOLYGON;
+        shape._polygon = &pol;
+        return shape;
+    }
+
+private:
+    Shape point(double x, double y) const {
+        Shape shape;
+        shape._kind = Shape::sPOINT;
+        shape._point = Coordinate2d(x, y);
+        return shape;
+    }
+};
+
+bool intersects(const Shape& s1, const Shape& s2) {
+    if ( s1._kind == Shape::sNONE || s2._kind == Shape::sNONE)
+        return false;
+    switch(s1._kind * 3 + s2._kind) {
+    case Shape::sPOINT * 3 + Shape::sPOINT:
+        return s1._point.x() == s2._point.x() && s1._point.y() == s2._point.y();
+    case Shape::sPOINT * 3 + Shape::sLINE:
+        return boost::geometry::intersects(s1._point, s2.line());
+    case Shape::sPOINT * 3 + Shape::sPOLYGON:
+        return boost::geometry::intersects(s1._point, *s2._polygon);
+    case Shape::sLINE * 3 + Shape::sLINE:
+        return boost::geometry::intersects(s1.line(), s2.line());
+    case Shape::sLINE * 3 + Shape::sPOLYGON:
+        return boost::geometry::intersects(s1.line(), *s2._polygon);
+    case Shape::sPOLYGON * 3 + Shape::sPOLYGON:
+        return boost::geometry::intersects(*s1._polygon, *s2._polygon);
+    default: // the symmetric cases
+        return intersects(s2, s1);
+    }
+}
+
+double distance(const Coordinate2d& crd, const Shape& shape) {
+    switch(shape._kind) {
+    case Shape::sPOINT:
+        return std::sqrt(std::pow(crd.x() - shape._point.x(), 2) + std::pow(crd.y() - shape._point.y(), 2));
+    case Shape::sLINE:
+        return boost::geometry::distance(crd, shape.line());
+    case Shape::sPOLYGON:
+        return boost::geometry::within(crd, *shape._polygon) ? 0 : boost::geometry::distance(crd, *shape._polygon);
+    default:
+        return std::numeric_limits<double>::max();
+    }
+}
+
+struct Candidate {
+    double _distance;
+    quint32 _level;
+    quint32 _index;
+    bool _exact;
+
+    bool operator<(const Candidate& other) const { // reversed, the priority queue must return the smallest distance first
+        return _distance > other._distance;
+    }
+};
+}
+
+SpatialIndex::SpatialIndex(const Features &features, const std::vector<Box2D<double>>& envelopes) : _features(features)
+{
+    std::vector<double> boxes;
+    std::vector<quint32> positions;
+    double xmin = std::numeric_limits<double>::max(), ymin = xmin, xmax = -xmin, ymax = -xmin;
+    for(quint32 i = 0; i < features.size() && i < envelopes.size(); ++i) {
+        const Box2D<double>& env = envelopes[i];
+        if ( features[i].isNull() || !env.isValid()) // features without geometry can not be found spatially
+            continue;
+        positions.push_back(i);
+        boxes.insert(boxes.end(), {env.min_corner().x(), env.min_corner().y(), env.max_corner().x(), env.max_corner().y()});
+        xmin = std::min(xmin, env.min_corner().x());
+        ymin = std::min(ymin, env.min_corner().y());
+        xmax = std::max(xmax, env.max_corner().x());
+        ymax = std::max(ymax, env.max_corner().y());
+    }
+
+    quint32 n = positions.size();
+    std::vector<std::pair<quint64, quint32>> order(n);
+    double cells = (1 << HILBERT_ORDER) - 1;
+    double sx = xmax > xmin ? cells / (xmax - xmin) : 0, sy = ymax > ymin ? cells / (ymax - ymin) : 0;
+    for(quint32 i = 0; i < n; ++i) {
+        const double *b = &boxes[4 * i];
+        quint32 hx = (quint32)(sx * ((b[0] + b[2]) / 2 - xmin));
+        quint32 hy = (quint32)(sy * ((b[1] + b[3]) / 2 - ymin));
+        order[i] = {hilbert(hx, hy), i};
+    }
+    std::sort(order.begin(), order.end());
+
+    _items.resize(n);
+    _bounds.reserve(4 * (n + n / (NODESIZE - 1) + 1));
+    for(quint32 i = 0; i < n; ++i) {
+        _items[i] = positions[order[i].second];
+        const double *b = &boxes[4 * order[i].second];
+        _bounds.insert(_bounds.end(), b, b + 4);
+    }
+    _levels.push_back(0);
+    _levels.push_back(n);
+    // each level groups NODESIZE consecutive entries of the level below it, until one root remains
+    while( entries(_levels.size() - 2) > 1) {
+        quint32 level = _levels.size() - 2;
+        quint32 count = entries(level);
+        for(quint32 first = 0; first < count; first += NODESIZE) {
+            double node[4] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                              -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max()};
+            for(quint32 child = first; child < std::min(count, first + NODESIZE); ++child) {
+                const double *b = bounds(level, child);
+                node[0] = std::min(node[0], b[0]);
+                node[1] = std::min(node[1], b[1]);
+                node[2] = std::max(node[2], b[2]);
+                node[3] = std::max(node[3], b[3]);
+            }
+            _bounds.insert(_bounds.end(), node, node + 4);
+        }
+        _levels.push_back(_bounds.size() / 4);
+    }
+}
+
+quint32 SpatialIndex::size() const
+{
+    return _items.size();
+}
+
+Box2D<double> SpatialIndex::envelope() const
+{
+    if ( _items.size() == 0)
+        return Box2D<double>();
+    const double *b = bounds(_levels.size() - 2, 0);
+    return Box2D<double>(Coordinate2d(b[0], b[1]), Coordinate2d(b[2], b[3]));
+}
+
+std::vector<quint32> SpatialIndex::window(const Box2D<double> &box) const
+{
+    std::vector<quint32> result;
+    if ( _items.size() == 0 || !box.isValid())
+        return result;
+    std::vector<std::pair<quint32, quint32>> stack = {{(quint32)_levels.size() - 2, 0}};
+    while(!stack.empty()) {
+        quint32 level = stack.back().first, index = stack.back().second;
+        stack.pop_back();
+        if ( !overlaps(bounds(level, index), box))
+            continue;
+        if ( level == 0) {
+            result.push_back(_items[index]);
+            continue;
+        }
+        for(quint32 child = index * NODESIZE; child < std::min(entries(level - 1), (index + 1) * NODESIZE); ++child)
+            stack.push_back({level - 1, child});
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<quint32> SpatialIndex::intersects(const Geometry &geom) const
+{
+    std::vector<quint32> result;
+    Shape shape = geom.apply(ShapeOf());
+    for(quint32 position : window(geom.envelope())) {
+        const SPFeatureI& feature = _features[position];
+        for(quint32 t = 0; t < feature->trackSize(); ++t) {
+            if ( ::intersects(shape, feature->geometry(t).apply(ShapeOf()))) {
+                result.push_back(position);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<quint32> SpatialIndex::nearest(const Coordinate2d &crd, quint32 count) const
+{
+    std::vector<quint32> result;
+    if ( _items.size() == 0 || !crd.isValid())
+        return result;
+    // best first search; the distance to a box is a lower bound for everything in it. A feature is only accepted after its exact distance
+    // has been computed and it again comes out first
+    std::priority_queue<Candidate> queue;
+    quint32 root = _levels.size() - 2;
+    queue.push({distance(bounds(root, 0), crd), root, 0, false});
+    while(!queue.empty() && result.size() < count) {
+        Candidate candidate = queue.top();
+        queue.pop();
+        if ( candidate._exact) {
+            result.push_back(_items[candidate._index]);
+        } else if ( candidate._level == 0) {
+            const SPFeatureI& feature = _features[_items[candidate._index]];
+            double dist = std::numeric_limits<double>::max();
+            for(quint32 t = 0; t < feature->trackSize(); ++t)
+                dist = std::min(dist, ::distance(crd, feature->geometry(t).apply(ShapeOf())));
+            queue.push({dist, 0, candidate._index, true});
+        } else {
+            quint32 level = candidate._level - 1;
+            for(quint32 child = candidate._index * NODESIZE; child < std::min(entries(level), (candidate._index + 1) * NODESIZE); ++child)
+                queue.push({distance(bounds(level, child), crd), level, child, false});
+        }
+    }
+    return result;
+}
+
+quint32 SpatialIndex::entries(quint32 level) const
+{
+    return _levels[level + 1] - _levels[level];
+}
+
+const double *SpatialIndex::bounds(quint32 level, quint32 index) const
+{
+    return &_bounds[4 * (_levels[level] + index)];
+}
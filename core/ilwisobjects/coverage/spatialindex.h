@@ -0,0 +1,62 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <memory>
+#include "Kernel_global.h"
+
+namespace Ilwis {
+
+/*!
+ A packed Hilbert R-tree on the envelopes of the features of a feature coverage. The features are sorted on the Hilbert value of the
+ centers of their envelopes and grouped bottom up in nodes of a fixed size, so the tree is balanced and its nodes are full. The index is
+ immutable once it is build; the coverage drops it when features are added and builds a new one when it is needed again.
+ Queries return the positions of the features in the coverage, which can be used directly as subset for a FeatureIterator.
+ */
+class KERNELSHARED_EXPORT SpatialIndex {
+public:
+    /*!
+     builds the index
+     * \param features the features of the coverage
+     * \param envelopes the envelope of each feature, by position (\se FeatureCoverage::envelopes); features with an undefined envelope are not indexed
+     */
+    SpatialIndex(const Features& features, const std::vector<Box2D<double>>& envelopes);
+
+    quint32 size() const;
+    Box2D<double> envelope() const;
+    /*!
+     selects the features whose envelope overlaps a box
+     * \param box the box in the coordinate system of the coverage
+     * \return the positions of the features in ascending order
+     */
+    std::vector<quint32> window(const Box2D<double>& box) const;
+    /*!
+     selects the features of which at least one geometry intersects a geometry. The envelopes select the candidates, the geometries
+     of the candidates are tested exactly.
+     * \param geom the geometry in the coordinate system of the coverage
+     * \return the positions of the features in ascending order
+     */
+    std::vector<quint32> intersects(const Geometry& geom) const;
+    /*!
+     selects the features that are closest to a position. The distance to a feature is the distance to the nearest of its geometries;
+     positions inside a polygon have distance 0.
+     * \param crd the position in the coordinate system of the coverage
+     * \param count the number of features to select
+     * \return the positions of the features, the nearest first
+     */
+    std::vector<quint32> nearest(const Coordinate2d& crd, quint32 count=1) const;
+
+private:
+    // the bounds of all entries of all levels, four values (xmin, ymin, xmax, ymax) per entry. Level 0 are the features, the last level the root
+    std::vector<double> _bounds;
+    std::vector<quint32> _levels;
+    std::vector<quint32> _items;
+    Features _features;
+
+    quint32 entries(quint32 level) const;
+    const double *bounds(quint32 level, quint32 index) const;
+};
+
+typedef std::shared_ptr<SpatialIndex> SPSpatialIndex;
+}
+
+#endif // SPATIALINDEX_H
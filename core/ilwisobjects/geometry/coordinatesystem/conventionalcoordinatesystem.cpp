@@ -1,3 +1,4 @@
+#include <cmath>
 #include "kernel.h"
 #include "geometries.h"
 #include "ilwisdata.h"
@@ -7,6 +8,7 @@
 #include "coordinatesystem.h"
 #include "conventionalcoordinatesystem.h"
 #include "proj4parameters.h"
+#include "coordinatetransformer.h"
 
 using namespace Ilwis;
 
@@ -34,7 +36,7 @@ LatLon ConventionalCoordinateSystem::coord2latlon(const Coordinate &crdSource) c
     LatLon pl = _projection->coord2latlon(crdSource);
     if (!pl.isValid())
         return llUNDEF;
-    if (abs(pl.lon()) > 90)
+    if (std::abs(pl.lat()) > 90)
         return llUNDEF;
     return pl;
 }
@@ -48,15 +50,53 @@ Coordinate ConventionalCoordinateSystem::latlon2coord(const LatLon &ll) const
 
 }
 
+bool ConventionalCoordinateSystem::coord2coord(const ICoordinateSystem &sourceCs, const std::vector<Coordinate> &crdSource, std::vector<Coordinate> &crdTarget) const
+{
+    if (sourceCs->isEqual(*this)) {
+        crdTarget = crdSource;
+        return true;
+    }
+    std::vector<LatLon> lls;
+    if (!sourceCs->coord2latlon(crdSource, lls))
+        return false;
+    return latlon2coord(lls, crdTarget);
+}
+
+bool ConventionalCoordinateSystem::coord2latlon(const std::vector<Coordinate> &crdSource, std::vector<LatLon> &llTarget) const
+{
+    if (!_projection->coord2latlon(crdSource, llTarget))
+        return false;
+    for(LatLon& pl : llTarget) {
+        if (pl.isValid() && std::abs(pl.lat()) > 90)
+            pl = llUNDEF;
+    }
+    return true;
+}
+
+bool ConventionalCoordinateSystem::latlon2coord(const std::vector<LatLon> &llSource, std::vector<Coordinate> &crdTarget) const
+{
+    return _projection->latlon2coord(llSource, crdTarget);
+}
 
 const std::unique_ptr<GeodeticDatum>& ConventionalCoordinateSystem::datum() const
 {
     return _datum;
 }
 
+bool ConventionalCoordinateSystem::canConvertToLatLon() const
+{
+    return _projection.isValid();
+}
+
+bool ConventionalCoordinateSystem::canConvertToCoordinate() const
+{
+    return _projection.isValid();
+}
+
 void ConventionalCoordinateSystem::setDatum(GeodeticDatum *datum)
 {
     _datum.reset(datum);
+    CoordinateTransformer::invalidate(id());
 }
 
 IEllipsoid ConventionalCoordinateSystem::ellipsoid() const
@@ -67,6 +107,7 @@ IEllipsoid ConventionalCoordinateSystem::ellipsoid() const
 void ConventionalCoordinateSystem::setEllipsoid(const IEllipsoid &ell)
 {
     _ellipsoid = ell;
+    CoordinateTransformer::invalidate(id());
 }
 
 bool ConventionalCoordinateSystem::isLatLon() const
@@ -89,6 +130,7 @@ bool ConventionalCoordinateSystem::isValid() const
 void ConventionalCoordinateSystem::setProjection(const IProjection &proj)
 {
     _projection = proj;
+    CoordinateTransformer::invalidate(id());
 }
 
 IProjection ConventionalCoordinateSystem::projection() const
@@ -103,6 +145,7 @@ bool ConventionalCoordinateSystem::prepare()
 
 bool ConventionalCoordinateSystem::prepare(const QString &parms)
 {
+    CoordinateTransformer::invalidate(id());
     Proj4Parameters proj4(parms);
 
     QString ell = proj4["ellps"];
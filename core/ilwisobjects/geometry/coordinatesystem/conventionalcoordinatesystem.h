@@ -14,6 +14,11 @@ public:
     Coordinate coord2coord(const ICoordinateSystem &sourceCs, const Coordinate& crdSource) const;
     LatLon coord2latlon(const Coordinate &crdSource) const;
     Coordinate latlon2coord(const LatLon& ll) const;
+    bool coord2coord(const ICoordinateSystem& sourceCs, const std::vector<Coordinate>& crdSource, std::vector<Coordinate>& crdTarget) const;
+    bool coord2latlon(const std::vector<Coordinate>& crdSource, std::vector<LatLon>& llTarget) const;
+    bool latlon2coord(const std::vector<LatLon>& llSource, std::vector<Coordinate>& crdTarget) const;
+    bool canConvertToLatLon() const;
+    bool canConvertToCoordinate() const;
     const std::unique_ptr<Ilwis::GeodeticDatum> &datum() const;
     void setDatum(Ilwis::GeodeticDatum *datum);
     IEllipsoid ellipsoid() const;
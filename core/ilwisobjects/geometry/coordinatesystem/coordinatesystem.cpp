@@ -1,13 +1,62 @@
 #include <QString>
+#include <cmath>
+#include <limits>
 
 #include "kernel.h"
 #include "geometries.h"
 #include "ilwisdata.h"
 //#include "domain.h"
 #include "coordinatesystem.h"
+#include "coordinatetransformer.h"
 
 using namespace Ilwis;
 
+#define ENVELOPE_MINSEGMENTS 8
+#define ENVELOPE_MAXSEGMENTS 512
+#define ENVELOPE_TOLERANCE 1e-6
+
+namespace {
+struct Extent {
+    Extent() : _minx(std::numeric_limits<double>::max()), _miny(std::numeric_limits<double>::max()),
+               _maxx(-std::numeric_limits<double>::max()), _maxy(-std::numeric_limits<double>::max()) {}
+
+    void add(const Coordinate& crd) {
+        if ( !crd.isValid())
+            return;
+        _minx = std::min(_minx, crd.x());
+        _miny = std::min(_miny, crd.y());
+        _maxx = std::max(_maxx, crd.x());
+        _maxy = std::max(_maxy, crd.y());
+    }
+
+    bool isValid() const {
+        return _minx <= _maxx && _miny <= _maxy;
+    }
+
+    bool isCloseTo(const Extent& other) const {
+        double tolerance = ENVELOPE_TOLERANCE * std::max(std::max(_maxx - _minx, _maxy - _miny), 1.0);
+        return std::abs(_minx - other._minx) <= tolerance && std::abs(_miny - other._miny) <= tolerance &&
+               std::abs(_maxx - other._maxx) <= tolerance && std::abs(_maxy - other._maxy) <= tolerance;
+    }
+
+    double _minx, _miny, _maxx, _maxy;
+};
+
+// the edges of the envelope as one ring, counter clockwise from the lower left corner
+void densifyEdges(const Box2D<double>& envelope, quint32 segments, std::vector<Coordinate>& ring) {
+    double x0 = envelope.min_corner().x(), y0 = envelope.min_corner().y();
+    double x1 = envelope.max_corner().x(), y1 = envelope.max_corner().y();
+    double dx = (x1 - x0) / segments, dy = (y1 - y0) / segments;
+    ring.resize(4 * segments);
+    for(quint32 i = 0; i < segments; ++i) {
+        ring[i] = Coordinate(x0 + i * dx, y0, 0);
+        ring[segments + i] = Coordinate(x1, y0 + i * dy, 0);
+        ring[2 * segments + i] = Coordinate(x1 - i * dx, y1, 0);
+        ring[3 * segments + i] = Coordinate(x0, y1 - i * dy, 0);
+    }
+}
+}
+
 CoordinateSystem::CoordinateSystem()
 {
 }
@@ -16,20 +65,94 @@ CoordinateSystem::CoordinateSystem(const Resource& resource) : IlwisObject(resou
 {
 }
 
+CoordinateSystem::~CoordinateSystem()
+{
+    CoordinateTransformer::invalidate(id());
+}
+
 Box2D<double> CoordinateSystem::convertEnvelope(const ICoordinateSystem &sourceCs, const Box2D<double> &envelope) const
 {
-    double rDX = envelope.width()/10.0;
-    double rDY = envelope.height()/10.0;
-    int iX, iY;
-    Coordinate cXY;
-    Box2D<double> env;
-    for ( cXY.x(envelope.min_corner().x()),iX = 0; iX <= 10; cXY += {rDX, 0}, ++iX) {
-        for (cXY.y(envelope.min_corner().y()),iY = 0; iY <= 10; cXY += {0,rDY} , ++iY ) {
-            Coordinate crdNew = coord2coord(sourceCs, cXY);
-            env += crdNew;
+    if ( !sourceCs.isValid() || !envelope.isValid())
+        return Box2D<double>();
+    if ( sourceCs->id() == id() || sourceCs->isEqual(*this))
+        return envelope;
+
+    std::vector<Coordinate> edges, converted;
+    Extent extent;
+    bool wraps = false;
+    for(quint32 segments = ENVELOPE_MINSEGMENTS; segments <= ENVELOPE_MAXSEGMENTS; segments *= 2) {
+        densifyEdges(envelope, segments, edges);
+        if (!coord2coord(sourceCs, edges, converted))
+            return Box2D<double>();
+        Extent next;
+        for(const Coordinate& crd : converted)
+            next.add(crd);
+        // a ring of latlon positions that jumps more than half the globe between neighbours crosses the antimeridian (or circles a pole)
+        if ( isLatLon()) {
+            const Coordinate *previous = 0;
+            for(const Coordinate& crd : converted) {
+                if ( !crd.isValid())
+                    continue;
+                if ( previous && std::abs(crd.x() - previous->x()) > 180)
+                    wraps = true;
+                previous = &crd;
+            }
         }
+        bool converged = extent.isValid() && next.isValid() && extent.isCloseTo(next);
+        extent = next;
+        if ( converged)
+            break;
     }
-    return env;
+    if ( !extent.isValid())
+        return Box2D<double>();
+
+    // the extremes of a smooth conversion lie on the edges of the envelope, except for the poles that may be inside it
+    if ( sourceCs->canConvertToCoordinate() && canConvertToCoordinate()) {
+        for(double lat : {90.0, -90.0}) {
+            LatLon pole(Degrees(lat), Degrees(0));
+            Coordinate crd = sourceCs->latlon2coord(pole);
+            if ( !crd.isValid() ||
+                 crd.x() < envelope.min_corner().x() || crd.x() > envelope.max_corner().x() ||
+                 crd.y() < envelope.min_corner().y() || crd.y() > envelope.max_corner().y())
+                continue;
+            extent.add(latlon2coord(pole));
+            wraps = wraps || isLatLon();
+        }
+    }
+    if ( wraps) {
+        extent._minx = -180;
+        extent._maxx = 180;
+    }
+    return Box2D<double>(Coordinate2d(extent._minx, extent._miny), Coordinate2d(extent._maxx, extent._maxy));
+}
+
+bool CoordinateSystem::isLatLon() const
+{
+    return false;
+}
+
+bool CoordinateSystem::coord2coord(const ICoordinateSystem &sourceCs, const std::vector<Coordinate> &crdSource, std::vector<Coordinate> &crdTarget) const
+{
+    crdTarget.resize(crdSource.size());
+    for(quint32 i = 0; i < crdSource.size(); ++i)
+        crdTarget[i] = coord2coord(sourceCs, crdSource[i]);
+    return true;
+}
+
+bool CoordinateSystem::coord2latlon(const std::vector<Coordinate> &crdSource, std::vector<LatLon> &llTarget) const
+{
+    llTarget.resize(crdSource.size());
+    for(quint32 i = 0; i < crdSource.size(); ++i)
+        llTarget[i] = coord2latlon(crdSource[i]);
+    return true;
+}
+
+bool CoordinateSystem::latlon2coord(const std::vector<LatLon> &llSource, std::vector<Coordinate> &crdTarget) const
+{
+    crdTarget.resize(llSource.size());
+    for(quint32 i = 0; i < llSource.size(); ++i)
+        crdTarget[i] = latlon2coord(llSource[i]);
+    return true;
 }
 
 bool CoordinateSystem::canConvertToLatLon() const
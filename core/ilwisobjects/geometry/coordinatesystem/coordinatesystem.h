@@ -15,11 +15,31 @@ class KERNELSHARED_EXPORT CoordinateSystem : public IlwisObject
 public:
     CoordinateSystem();
     CoordinateSystem(const Ilwis::Resource &resource);
+    ~CoordinateSystem();
 
     virtual Coordinate coord2coord(const ICoordinateSystem& sourceCs, const Coordinate& crdSource) const =0;
     virtual LatLon coord2latlon(const Coordinate &crdSource) const =0;
     virtual Coordinate latlon2coord(const LatLon& ll) const = 0;
+    /*!
+     converts a set of coordinates in one call. Implementations that can transform arrays (e.g. proj4) do so in one pass instead of point by point.
+     Points that can not be converted become undefined.
+     * \param sourceCs coordinate system of the input coordinates
+     * \param crdSource the coordinates to convert
+     * \param crdTarget receives the converted coordinates; it has the same size as crdSource
+     * \return false if the conversion failed as a whole
+     */
+    virtual bool coord2coord(const ICoordinateSystem& sourceCs, const std::vector<Coordinate>& crdSource, std::vector<Coordinate>& crdTarget) const;
+    virtual bool coord2latlon(const std::vector<Coordinate>& crdSource, std::vector<LatLon>& llTarget) const;
+    virtual bool latlon2coord(const std::vector<LatLon>& llSource, std::vector<Coordinate>& crdTarget) const;
+    /*!
+     converts an envelope to this coordinate system. The edges of the envelope are densified until the converted envelope no longer grows;
+     poles that lie inside the envelope are included and an envelope that crosses the antimeridian of a latlon system covers all longitudes.
+     * \param sourceCs coordinate system of the envelope
+     * \param envelope the envelope to convert
+     * \return the envelope in this coordinate system; an invalid box if none of the edge points could be converted
+     */
     virtual Ilwis::Box2D<double> convertEnvelope(const ICoordinateSystem& sourceCs, const Ilwis::Box2D<double>& envelope) const;
+    virtual bool isLatLon() const;
     virtual bool canConvertToLatLon() const;
     virtual bool canConvertToCoordinate() const;
     virtual Coordinate inverseCoordinateConversion(const CoordinateSystem& cs, const Coordinate& crd) const;
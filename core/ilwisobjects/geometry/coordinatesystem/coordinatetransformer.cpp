@@ -0,0 +1,172 @@
+#include <map>
+#include <list>
+#include <mutex>
+#include "kernel.h"
+#include "geometries.h"
+#include "ilwisdata.h"
+#include "coordinatesystem.h"
+#include "coordinatetransformer.h"
+
+using namespace Ilwis;
+
+#define MAX_CACHED_TRANSFORMERS 1024
+
+namespace {
+struct CachedPair {
+    bool _identity;
+    bool _viaLatLon;
+    std::list<std::pair<quint64, quint64>>::iterator _use;
+};
+
+// the pairs are ordered on use, most recent first; the last one is removed when the cache is full
+struct TransformerCache {
+    std::map<std::pair<quint64, quint64>, CachedPair> _pairs;
+    std::list<std::pair<quint64, quint64>> _uses;
+};
+
+// both are deliberately never deleted; coordinate systems that are deleted at exit still invalidate their entries
+std::mutex& cacheMutex() {
+    static std::mutex *mutex = new std::mutex();
+    return *mutex;
+}
+
+TransformerCache& cache() {
+    static TransformerCache *transformers = new TransformerCache();
+    return *transformers;
+}
+}
+
+CoordinateTransformer::CoordinateTransformer() : _identity(false), _viaLatLon(false)
+{
+}
+
+CoordinateTransformer::CoordinateTransformer(const ICoordinateSystem &source, const ICoordinateSystem &target, bool identity, bool viaLatLon) :
+    _source(source),
+    _target(target),
+    _identity(identity),
+    _viaLatLon(viaLatLon)
+{
+}
+
+CoordinateTransformer::CoordinateTransformer(const ICoordinateSystem &source, const ICoordinateSystem &target) :
+    _source(source),
+    _target(target),
+    _identity(false),
+    _viaLatLon(false)
+{
+    if ( isValid()) {
+        _identity = _source == _target || _source->isEqual(*_target.ptr());
+        // the equivalence test is done once here; the coordinate systems themselves repeat it on every conversion
+        _viaLatLon = !_identity && _source->canConvertToLatLon() && _target->canConvertToCoordinate();
+    }
+}
+
+bool CoordinateTransformer::isValid() const
+{
+    return _source.isValid() && _target.isValid();
+}
+
+bool CoordinateTransformer::isIdentity() const
+{
+    return _identity;
+}
+
+const ICoordinateSystem &CoordinateTransformer::source() const
+{
+    return _source;
+}
+
+const ICoordinateSystem &CoordinateTransformer::target() const
+{
+    return _target;
+}
+
+Coordinate CoordinateTransformer::transform(const Coordinate &crd) const
+{
+    if ( _identity)
+        return crd;
+    if ( !isValid())
+        return Coordinate();
+    if ( _viaLatLon) {
+        LatLon ll = _source->coord2latlon(crd);
+        return ll.isValid() ? _target->latlon2coord(ll) : Coordinate();
+    }
+    return _target->coord2coord(_source, crd);
+}
+
+bool CoordinateTransformer::transform(const std::vector<Coordinate> &crdSource, std::vector<Coordinate> &crdTarget) const
+{
+    if ( _identity) {
+        crdTarget = crdSource;
+        return true;
+    }
+    if ( !isValid())
+        return false;
+    bool ok;
+    if ( _viaLatLon) {
+        std::vector<LatLon> lls;
+        ok = _source->coord2latlon(crdSource, lls) && _target->latlon2coord(lls, crdTarget);
+    } else
+        ok = _target->coord2coord(_source, crdSource, crdTarget);
+    if ( ok)
+        return true;
+    // a batch can fail as a whole on a single bad point (e.g. in proj4); the points are then converted one by one so only the bad ones become undefined
+    crdTarget.resize(crdSource.size());
+    for(quint32 i = 0; i < crdSource.size(); ++i)
+        crdTarget[i] = crdSource[i].isValid() ? transform(crdSource[i]) : Coordinate();
+    return true;
+}
+
+Box2D<double> CoordinateTransformer::transform(const Box2D<double> &envelope) const
+{
+    if ( _identity)
+        return envelope;
+    if ( !isValid())
+        return Box2D<double>();
+    return _target->convertEnvelope(_source, envelope);
+}
+
+SPCoordinateTransformer CoordinateTransformer::transformer(const ICoordinateSystem &source, const ICoordinateSystem &target)
+{
+    if ( !source.isValid() || !target.isValid())
+        return SPCoordinateTransformer(new CoordinateTransformer(source, target));
+
+    std::pair<quint64, quint64> key(source->id(), target->id());
+    TransformerCache& transformers = cache();
+    {
+        Locker lock(cacheMutex());
+        auto iter = transformers._pairs.find(key);
+        if ( iter != transformers._pairs.end()) {
+            CachedPair& pair = (*iter).second;
+            transformers._uses.splice(transformers._uses.begin(), transformers._uses, pair._use);
+            return SPCoordinateTransformer(new CoordinateTransformer(source, target, pair._identity, pair._viaLatLon));
+        }
+    }
+    // preparing is done outside the lock, it may be expensive. Two threads preparing the same pair is harmless; the last one wins
+    SPCoordinateTransformer trans(new CoordinateTransformer(source, target));
+    Locker lock(cacheMutex());
+    auto iter = transformers._pairs.find(key);
+    if ( iter != transformers._pairs.end()) {
+        transformers._uses.erase((*iter).second._use);
+        transformers._pairs.erase(iter);
+    } else if ( transformers._pairs.size() >= MAX_CACHED_TRANSFORMERS) {
+        transformers._pairs.erase(transformers._uses.back());
+        transformers._uses.pop_back();
+    }
+    transformers._uses.push_front(key);
+    transformers._pairs[key] = {trans->_identity, trans->_viaLatLon, transformers._uses.begin()};
+    return trans;
+}
+
+void CoordinateTransformer::invalidate(quint64 csyId)
+{
+    TransformerCache& transformers = cache();
+    Locker lock(cacheMutex());
+    for(auto iter = transformers._pairs.begin(); iter != transformers._pairs.end();) {
+        if ( (*iter).first.first == csyId || (*iter).first.second == csyId) {
+            transformers._uses.erase((*iter).second._use);
+            iter = transformers._pairs.erase(iter);
+        } else
+            ++iter;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef COORDINATETRANSFORMER_H
+#define COORDINATETRANSFORMER_H
+
+#include "Kernel_global.h"
+
+namespace Ilwis {
+
+class CoordinateTransformer;
+typedef std::shared_ptr<CoordinateTransformer> SPCoordinateTransformer;
+
+/*!
+ Converts coordinates from one coordinate system to another. The pair of coordinate systems is resolved once; when both are the same
+ the conversion is a copy. Conversions of sets of coordinates are done in one call through the batch interface of the coordinate systems
+ (\se CoordinateSystem::coord2coord).
+ How a pair of coordinate systems converts is kept in a process wide cache keyed on their ids (\se transformer). The cache holds no
+ references to the coordinate systems; a coordinate system that is modified or deleted removes the entries it is part of and the least
+ recently used entries are removed when the cache is full.
+ */
+class KERNELSHARED_EXPORT CoordinateTransformer
+{
+public:
+    CoordinateTransformer();
+    CoordinateTransformer(const ICoordinateSystem& source, const ICoordinateSystem& target);
+
+    bool isValid() const;
+    bool isIdentity() const;
+    const ICoordinateSystem& source() const;
+    const ICoordinateSystem& target() const;
+
+    Coordinate transform(const Coordinate& crd) const;
+    /*!
+     converts a set of coordinates from the source to the target system
+     * \param crdSource coordinates in the source system
+     * \param crdTarget receives the coordinates in the target system; points that can not be converted are undefined. When the batch conversion
+     fails as a whole the points are converted one by one.
+     * \return false if the transformer is invalid
+     */
+    bool transform(const std::vector<Coordinate>& crdSource, std::vector<Coordinate>& crdTarget) const;
+    Box2D<double> transform(const Box2D<double>& envelope) const;
+
+    /*!
+     returns a prepared transformer for a pair of coordinate systems. The pair is resolved on first use; later calls reuse the cached result.
+     * \param source coordinate system of the input coordinates
+     * \param target coordinate system of the output coordinates
+     * \return the transformer; it is never null but may be invalid if one of the systems is invalid
+     */
+    static SPCoordinateTransformer transformer(const ICoordinateSystem& source, const ICoordinateSystem& target);
+    /*!
+     removes all cache entries that have the coordinate system as source or target. Called when a coordinate system is modified or deleted.
+     Transformers that are already in use keep working with the state they were prepared with.
+     */
+    static void invalidate(quint64 csyId);
+
+private:
+    CoordinateTransformer(const ICoordinateSystem& source, const ICoordinateSystem& target, bool identity, bool viaLatLon);
+
+    ICoordinateSystem _source;
+    ICoordinateSystem _target;
+    bool _identity;
+    bool _viaLatLon;
+};
+}
+
+#endif // COORDINATETRANSFORMER_H
@@ -42,6 +42,28 @@ LatLon Projection::coord2latlon(const Coordinate &crd) const
 
 }
 
+bool Projection::latlon2coord(const std::vector<LatLon> &llSource, std::vector<Coordinate> &crdTarget) const
+{
+    if ( _implementation.isNull()) { // derived projections (e.g. the null projection) only implement the single point version
+        crdTarget.resize(llSource.size());
+        for(quint32 i = 0; i < llSource.size(); ++i)
+            crdTarget[i] = latlon2coord(llSource[i]);
+        return true;
+    }
+    return _implementation->latlon2coord(llSource, crdTarget);
+}
+
+bool Projection::coord2latlon(const std::vector<Coordinate> &crdSource, std::vector<LatLon> &llTarget) const
+{
+    if ( _implementation.isNull()) {
+        llTarget.resize(crdSource.size());
+        for(quint32 i = 0; i < crdSource.size(); ++i)
+            llTarget[i] = coord2latlon(crdSource[i]);
+        return true;
+    }
+    return _implementation->coord2latlon(crdSource, llTarget);
+}
+
 bool Projection::prepare(const QString &parms)
 {
     return _implementation->prepare(parms);
@@ -24,6 +24,11 @@ public:
 
     virtual Coordinate latlon2coord(const LatLon&) const;
     virtual LatLon coord2latlon(const Coordinate&) const;
+    /*!
+     converts a set of points in one call (\se CoordinateSystem::coord2latlon). Points that can not be converted become undefined
+     */
+    virtual bool latlon2coord(const std::vector<LatLon>& llSource, std::vector<Coordinate>& crdTarget) const;
+    virtual bool coord2latlon(const std::vector<Coordinate>& crdSource, std::vector<LatLon>& llTarget) const;
 
     bool prepare(const QString& parms);
     bool prepare();
@@ -12,6 +12,7 @@
 #include "conventionalcoordinatesystem.h"
 #include "ProjectionImplementation.h"
 #include "proj4parameters.h"
+#include "coordinatetransformer.h"
 
 using namespace Ilwis;
 
@@ -34,6 +35,22 @@ ProjectionImplementation::ProjectionImplementation(const QString &type) :
     _parameters[Projection::pvLON0] =  0;
 }
 
+bool ProjectionImplementation::latlon2coord(const std::vector<LatLon> &llSource, std::vector<Coordinate> &crdTarget) const
+{
+    crdTarget.resize(llSource.size());
+    for(quint32 i = 0; i < llSource.size(); ++i)
+        crdTarget[i] = latlon2coord(llSource[i]);
+    return true;
+}
+
+bool ProjectionImplementation::coord2latlon(const std::vector<Coordinate> &crdSource, std::vector<LatLon> &llTarget) const
+{
+    llTarget.resize(crdSource.size());
+    for(quint32 i = 0; i < crdSource.size(); ++i)
+        llTarget[i] = coord2latlon(crdSource[i]);
+    return true;
+}
+
 QString ProjectionImplementation::type() const
 {
     return _projtype;
@@ -55,6 +72,8 @@ QVariant ProjectionImplementation::parameter(Projection::ProjectionParamValue ty
 void ProjectionImplementation::setParameter(Projection::ProjectionParamValue type, const QVariant &value)
 {
     _parameters[type] = value;
+    if ( _coordinateSystem)
+        CoordinateTransformer::invalidate(_coordinateSystem->id());
 }
 
 
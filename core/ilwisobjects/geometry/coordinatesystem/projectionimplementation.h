@@ -17,6 +17,8 @@ public:
 
     virtual Coordinate latlon2coord(const LatLon&) const = 0;
     virtual LatLon coord2latlon(const Coordinate&) const = 0;
+    virtual bool latlon2coord(const std::vector<LatLon>& llSource, std::vector<Coordinate>& crdTarget) const;
+    virtual bool coord2latlon(const std::vector<Coordinate>& crdSource, std::vector<LatLon>& llTarget) const;
     virtual bool prepare(const QString& parms="")=0;
     virtual QString type() const;
     virtual void setCoordinateSystem(ConventionalCoordinateSystem *csy);
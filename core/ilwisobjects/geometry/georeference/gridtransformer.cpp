@@ -0,0 +1,215 @@
+#include "kernel.h"
+#include "ilwisdata.h"
+#include "geometries.h"
+#include "coordinatesystem.h"
+#include "coordinatetransformer.h"
+#include "georeference.h"
+#include "georefimplementation.h"
+#include "simpelgeoreference.h"
+#include "gridtransformer.h"
+
+using namespace Ilwis;
+
+GridTransformer::GridTransformer(const IGeoReference &target, const IGeoReference &source, double tolerance, quint32 cellSize) :
+    _target(target),
+    _source(source),
+    _tolerance(tolerance),
+    _cellSize(std::max((quint32)4, cellSize))
+{
+    if ( !isValid())
+        return;
+    _transformer = *CoordinateTransformer::transformer(_target->coordinateSystem(), _source->coordinateSystem());
+    if ( _transformer.isIdentity() && _target->grfType<SimpelGeoReference>() && _source->grfType<SimpelGeoReference>()) {
+        // the composition of two affine transformations is affine, three positions determine it. The two other positions are taken
+        // some distance away from the origin to keep the rounding errors in the steps small
+        double d = _cellSize;
+        std::vector<Pixel_d> sources;
+        if ( exact({Pixel_d(0,0), Pixel_d(d,0), Pixel_d(0,d)}, sources) && sources[0].isValid() && sources[1].isValid() && sources[2].isValid()) {
+            _origin = sources[0];
+            _stepX = Pixel_d((sources[1].x() - _origin.x()) / d, (sources[1].y() - _origin.y()) / d);
+            _stepY = Pixel_d((sources[2].x() - _origin.x()) / d, (sources[2].y() - _origin.y()) / d);
+            _affine = true;
+        }
+    }
+}
+
+bool GridTransformer::isValid() const
+{
+    return _target.isValid() && _source.isValid();
+}
+
+bool GridTransformer::isExact() const
+{
+    return _tolerance <= 0 || _transformer.isIdentity();
+}
+
+bool GridTransformer::isAffine() const
+{
+    return _affine;
+}
+
+bool GridTransformer::transform(const Box2D<qint32> &block, std::vector<Pixel_d> &pixels) const
+{
+    qint32 bx0 = block.min_corner().x();
+    qint32 by0 = block.min_corner().y();
+    qint32 bx1 = block.max_corner().x();
+    qint32 by1 = block.max_corner().y();
+    pixels.assign((bx1 - bx0 + 1) * (by1 - by0 + 1), Pixel_d());
+    if ( !isValid())
+        return false;
+    if ( _affine) {
+        fillAffine(block, pixels);
+        return true;
+    }
+    if ( isExact())
+        return fillExact(bx0, by0, bx1, by1, block, pixels);
+
+    // the sparse grid of control points; the last row and column of control points are on the edge of the block
+    auto controlPositions = [&](qint32 first, qint32 last) -> std::vector<qint32> {
+        std::vector<qint32> positions;
+        for(qint32 pos = first; pos < last; pos += _cellSize)
+            positions.push_back(pos);
+        positions.push_back(last);
+        if ( positions.size() == 1)
+            positions.push_back(last);
+        return positions;
+    };
+    std::vector<qint32> xs = controlPositions(bx0, bx1);
+    std::vector<qint32> ys = controlPositions(by0, by1);
+    std::vector<Pixel_d> targets;
+    targets.reserve(xs.size() * ys.size());
+    for(qint32 y : ys)
+        for(qint32 x : xs)
+            targets.push_back(Pixel_d(x, y));
+    std::vector<Pixel_d> controlPoints;
+    if (!exact(targets, controlPoints))
+        return false;
+
+    quint32 columns = xs.size();
+    for(quint32 j = 0; j + 1 < ys.size(); ++j) {
+        for(quint32 i = 0; i + 1 < xs.size(); ++i) {
+            Cell cell;
+            cell._x0 = xs[i]; cell._x1 = xs[i + 1];
+            cell._y0 = ys[j]; cell._y1 = ys[j + 1];
+            cell._corners[0] = controlPoints[j * columns + i];
+            cell._corners[1] = controlPoints[j * columns + i + 1];
+            cell._corners[2] = controlPoints[(j + 1) * columns + i];
+            cell._corners[3] = controlPoints[(j + 1) * columns + i + 1];
+            if (!fill(cell, block, pixels))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool GridTransformer::exact(const std::vector<Pixel_d> &targetPixels, std::vector<Pixel_d> &sourcePixels) const
+{
+    std::vector<Coordinate> targetCrds(targetPixels.size());
+    for(quint32 i = 0; i < targetPixels.size(); ++i)
+        targetCrds[i] = _target->pixel2Coord(targetPixels[i]);
+    std::vector<Coordinate> sourceCrds;
+    if (!_transformer.transform(targetCrds, sourceCrds))
+        return false;
+    sourcePixels.resize(targetPixels.size());
+    for(quint32 i = 0; i < sourceCrds.size(); ++i)
+        sourcePixels[i] = sourceCrds[i].isValid() ? _source->coord2Pixel(sourceCrds[i]) : Pixel_d();
+    return true;
+}
+
+bool GridTransformer::fillExact(qint32 x0, qint32 y0, qint32 x1, qint32 y1, const Box2D<qint32> &block, std::vector<Pixel_d> &pixels) const
+{
+    qint32 width = block.max_corner().x() - block.min_corner().x() + 1;
+    std::vector<Pixel_d> targets;
+    targets.reserve((x1 - x0 + 1) * (y1 - y0 + 1));
+    for(qint32 y = y0; y <= y1; ++y)
+        for(qint32 x = x0; x <= x1; ++x)
+            targets.push_back(Pixel_d(x, y));
+    std::vector<Pixel_d> sources;
+    if (!exact(targets, sources))
+        return false;
+    quint32 i = 0;
+    for(qint32 y = y0; y <= y1; ++y)
+        for(qint32 x = x0; x <= x1; ++x)
+            pixels[(y - block.min_corner().y()) * width + x - block.min_corner().x()] = sources[i++];
+    return true;
+}
+
+void GridTransformer::fillAffine(const Box2D<qint32> &block, std::vector<Pixel_d> &pixels) const
+{
+    qint32 bx0 = block.min_corner().x();
+    qint32 bx1 = block.max_corner().x();
+    quint32 i = 0;
+    for(qint32 y = block.min_corner().y(); y <= block.max_corner().y(); ++y) {
+        // every row starts from the origin so rounding errors of the additions don't accumulate over rows
+        double sx = _origin.x() + bx0 * _stepX.x() + y * _stepY.x();
+        double sy = _origin.y() + bx0 * _stepX.y() + y * _stepY.y();
+        for(qint32 x = bx0; x <= bx1; ++x) {
+            pixels[i++] = Pixel_d(sx, sy);
+            sx += _stepX.x();
+            sy += _stepX.y();
+        }
+    }
+}
+
+Pixel_d GridTransformer::interpolate(const Cell &cell, double x, double y) const
+{
+    double tx = cell._x1 != cell._x0 ? (x - cell._x0) / (cell._x1 - cell._x0) : 0;
+    double ty = cell._y1 != cell._y0 ? (y - cell._y0) / (cell._y1 - cell._y0) : 0;
+    double w0 = (1 - tx) * (1 - ty), w1 = tx * (1 - ty), w2 = (1 - tx) * ty, w3 = tx * ty;
+    return Pixel_d(w0 * cell._corners[0].x() + w1 * cell._corners[1].x() + w2 * cell._corners[2].x() + w3 * cell._corners[3].x(),
+                   w0 * cell._corners[0].y() + w1 * cell._corners[1].y() + w2 * cell._corners[2].y() + w3 * cell._corners[3].y());
+}
+
+bool GridTransformer::fill(const Cell &cell, const Box2D<qint32> &block, std::vector<Pixel_d> &pixels) const
+{
+    qint32 w = cell._x1 - cell._x0;
+    qint32 h = cell._y1 - cell._y0;
+    if ( w <= 2 || h <= 2) // too small to subdivide; computing it exactly is cheap
+        return fillExact(cell._x0, cell._y0, cell._x1, cell._y1, block, pixels);
+
+    bool cornersValid = true;
+    for(const Pixel_d& corner : cell._corners)
+        cornersValid = cornersValid && corner.isValid();
+    if ( !cornersValid && w * h <= 256) // (partly) outside the domain of the projection; no interpolation possible
+        return fillExact(cell._x0, cell._y0, cell._x1, cell._y1, block, pixels);
+
+    qint32 xm = cell._x0 + w / 2;
+    qint32 ym = cell._y0 + h / 2;
+    std::vector<Pixel_d> tests = {Pixel_d(xm, ym), Pixel_d(xm, cell._y0), Pixel_d(xm, cell._y1), Pixel_d(cell._x0, ym), Pixel_d(cell._x1, ym)};
+    std::vector<Pixel_d> exacts;
+    if (!exact(tests, exacts))
+        return false;
+
+    bool withinTolerance = cornersValid;
+    for(quint32 i = 0; i < tests.size() && withinTolerance; ++i) {
+        if ( !exacts[i].isValid()) {
+            withinTolerance = false;
+            break;
+        }
+        Pixel_d approx = interpolate(cell, tests[i].x(), tests[i].y());
+        double dx = approx.x() - exacts[i].x();
+        double dy = approx.y() - exacts[i].y();
+        withinTolerance = dx * dx + dy * dy <= _tolerance * _tolerance;
+    }
+
+    if ( withinTolerance) {
+        qint32 width = block.max_corner().x() - block.min_corner().x() + 1;
+        for(qint32 y = cell._y0; y <= cell._y1; ++y)
+            for(qint32 x = cell._x0; x <= cell._x1; ++x)
+                pixels[(y - block.min_corner().y()) * width + x - block.min_corner().x()] = interpolate(cell, x, y);
+        return true;
+    }
+
+    // subdivide in four; the test points are the corners that the sub cells share
+    const Pixel_d& center = exacts[0], &top = exacts[1], &bottom = exacts[2], &left = exacts[3], &right = exacts[4];
+    Cell sub[4] = {
+        {cell._x0, cell._y0, xm, ym, {cell._corners[0], top, left, center}},
+        {xm, cell._y0, cell._x1, ym, {top, cell._corners[1], center, right}},
+        {cell._x0, ym, xm, cell._y1, {left, center, cell._corners[2], bottom}},
+        {xm, ym, cell._x1, cell._y1, {center, right, bottom, cell._corners[3]}}
+    };
+    for(const Cell& subcell : sub)
+        if (!fill(subcell, block, pixels))
+            return false;
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef GRIDTRANSFORMER_H
+#define GRIDTRANSFORMER_H
+
+#include "Kernel_global.h"
+
+namespace Ilwis {
+
+/*!
+ Computes for the pixels of a target grid the (sub)pixel positions in a source grid, e.g. when resampling a raster. When both grids use the
+ same coordinate system every pixel is computed exactly; no coordinate conversions are needed. Else the positions are approximated: the exact
+ transformation is only computed at control points, between them positions are bilinearly interpolated. Cells in which the interpolation error
+ at the test points exceeds the tolerance are recursively subdivided, so the error stays (approximately) within the tolerance.
+ When both grids use the same coordinate system and both georeferences are affine (corners georeferences), the mapping between the grids is
+ itself affine; the positions of a row are then computed incrementally with two additions per pixel.
+ */
+class KERNELSHARED_EXPORT GridTransformer
+{
+public:
+    /*!
+     * \param target georeference of the grid that is computed
+     * \param source georeference of the grid whose pixel positions are needed
+     * \param tolerance maximum allowed error in source pixels. A tolerance of 0 computes every pixel exactly
+     * \param cellSize size (in target pixels) of the initial cells of the control point grid
+     */
+    GridTransformer(const IGeoReference& target, const IGeoReference& source, double tolerance=0.125, quint32 cellSize=64);
+
+    bool isValid() const;
+    bool isExact() const;
+    bool isAffine() const;
+    /*!
+     computes the source pixel positions of a block of target pixels
+     * \param block the target pixels; corners are inclusive
+     * \param pixels receives the positions row by row; pixels that have no position in the source grid are undefined
+     * \return false if the transformation failed
+     */
+    bool transform(const Box2D<qint32>& block, std::vector<Pixel_d>& pixels) const;
+
+private:
+    struct Cell {
+        qint32 _x0, _y0, _x1, _y1;
+        Pixel_d _corners[4]; // (x0,y0), (x1,y0), (x0,y1), (x1,y1)
+    };
+
+    bool exact(const std::vector<Pixel_d>& targetPixels, std::vector<Pixel_d>& sourcePixels) const;
+    bool fillExact(qint32 x0, qint32 y0, qint32 x1, qint32 y1, const Box2D<qint32>& block, std::vector<Pixel_d>& pixels) const;
+    bool fill(const Cell& cell, const Box2D<qint32>& block, std::vector<Pixel_d>& pixels) const;
+    Pixel_d interpolate(const Cell& cell, double x, double y) const;
+    void fillAffine(const Box2D<qint32>& block, std::vector<Pixel_d>& pixels) const;
+
+    IGeoReference _target;
+    IGeoReference _source;
+    CoordinateTransformer _transformer;
+    double _tolerance;
+    quint32 _cellSize;
+    bool _affine = false;
+    Pixel_d _origin; // source position of target pixel (0,0)
+    Pixel_d _stepX;  // change of the source position per target column
+    Pixel_d _stepY;  // change of the source position per target row
+};
+}
+
+#endif // GRIDTRANSFORMER_H
@@ -15,6 +15,21 @@
 
 using namespace Ilwis;
 
+#define INVERSE_TOLERANCE 1e-4 // in pixels
+#define INVERSE_MAXITER 10
+
+namespace {
+// evaluates the polynomial 1, X, Y, XY, XX, YY, XXX, XXY, XYY, YYY (the term order of MathHelper::findPolynom)
+void polynom(const std::vector<Coefficient>& coef, quint32 terms, double x, double y, double& u, double& v) {
+    const double products[] = {1, x, y, x * y, x * x, y * y, x * x * x, x * x * y, x * y * y, y * y * y};
+    u = v = 0;
+    for(quint32 i = 0; i < terms; ++i) {
+        u += coef[i].x * products[i];
+        v += coef[i].y * products[i];
+    }
+}
+}
+
 PlanarCTPGeoReference::PlanarCTPGeoReference() : CTPGeoReference("planartiepoints")
 {
 }
@@ -43,7 +58,7 @@ Coordinate PlanarCTPGeoReference::pixel2Coord(const Pixel_d &pix) const
           // used in the following conversion function:
       case tFULLSECONDORDER:
       case tTHIRDORDER:
-        crdInv = const_cast<PlanarCTPGeoReference *>(this)->crdInverseOfHigherOrder(pixd);
+        crdInv = crdInverseOfHigherOrder(pixd);
         c +=  {crdInv.x(), crdInv.y(), crdInv.z()}; // shift back to true position, (crd was already == crdAvg)
         break;
     }
@@ -57,30 +72,15 @@ Pixel_d PlanarCTPGeoReference::coord2Pixel(const Coordinate &crd) const
     Coordinate c = crd;
     Pixel_d rc(_avgPix.x, _avgPix.y);
     c -= {_avgCrd.x, _avgCrd.y};
-    double X2, Y2, XY;
-    switch (_transformation) {
-    case tTHIRDORDER:
-    case tFULLSECONDORDER:
-        X2 = c.x() * c.x();
-        Y2 = c.y() * c.y();
-    case tSECONDORDER:
-        XY = c.x() * c.y();
-        break;
-    default:
-        break;
-    }
+    double col, row;
     switch (_transformation) {
     case tTHIRDORDER:
-        rc += {(_colrowCoef[6].x * crd.x() + _colrowCoef[7].x * crd.y()) * X2 + (_colrowCoef[8].x * crd.x() + _colrowCoef[9].x * crd.y()) * Y2,
-                (_colrowCoef[6].y * crd.x() + _colrowCoef[7].y * crd.y()) * X2 +(_colrowCoef[8].y * crd.x() + _colrowCoef[9].x * crd.y()) * Y2};
     case tFULLSECONDORDER:
-        rc += {_colrowCoef[4].x * X2 + _colrowCoef[5].x * Y2, _colrowCoef[4].y * X2 + _colrowCoef[5].y * Y2};
     case tSECONDORDER:
-        rc += {_colrowCoef[3].x * XY,_colrowCoef[3].y * XY};
     case tAFFINE:
     case tCONFORM:
-        rc += {_colrowCoef[0].x, _colrowCoef[0].y};
-        rc += {_colrowCoef[1].x * crd.x() + _colrowCoef[2].x * crd.y(), _colrowCoef[1].y * crd.x() + _colrowCoef[2].y * crd.y()};
+        polynom(_colrowCoef, terms(), c.x(), c.y(), col, row);
+        rc += {col, row};
         break;
     case tPROJECTIVE:
         rc.x( rc.x() + (_colrowCoef[0].x * crd.x() + _colrowCoef[1].x * crd.y() + _colrowCoef[2].x) /
@@ -108,7 +108,7 @@ Coordinate PlanarCTPGeoReference::crdInverseOfAffine(const Pixel_d& pix) const
     //    detY = (Row -h)a - (Col -c)f
     // yields X = detX/det and Y = detY / det  provided  det <> 0
     double a = _colrowCoef[1].x;
-    double b = _colrowCoef[2].y;
+    double b = _colrowCoef[2].x;
     double c = _colrowCoef[0].x;
     double f = _colrowCoef[1].y;
     double g = _colrowCoef[2].y;
@@ -162,63 +162,38 @@ Coordinate PlanarCTPGeoReference::crdInverseOfProjective(const Pixel_d& pix) con
 }
 
 
-Coordinate PlanarCTPGeoReference::crdInverseOfHigherOrder(const Pixel_d& pix)
+Coordinate PlanarCTPGeoReference::crdInverseOfHigherOrder(const Pixel_d& pix) const
 {
     // Solving the following Coord2RowCol 3rd oreder equations for X and Y:
     // Col = c0 + c1X + c2Y + c3XY + c4XX + c5YY + c6XXX + c7XXY + c8XYY + c9YYY  (I )
     // Row = r0 + r1X + r2Y + r3XY + r4XX + r5YY + r6XXX + r7XXY + r8XYY + r9YYY  (II)
     // 2nd order if c6 == c7 == c8 == c9 == r6 == r7 == r8 == r9 == 0
-    Coordinate crdNext = Coordinate(0,0,0);     // initial crd guess
-    std::vector<double> nextPix { _colrowCoef[0].x, _colrowCoef[0].y }; // initial column and row
-    Pixel_d deltaPix = pix;
-    deltaPix -= nextPix;
-    makeJacobianMatrix(crdNext, _jacobian);// linear appr matrix of Coord2RowCol in (0,0)
-
-    double detJ = _jacobian.determinant();
-    if (abs(detJ) < EPS10)
-        return crdUNDEF;
-    else  {
-        _jacobian = _jacobian.inverse();
+    // The inverse polynomial (RowCol2Coord) that was fitted on the same tiepoints in compute() gives the first approximation; it is
+    // checked against the forward equations and, if it is not within the tolerance, improved by Newton iterations.
+    // Nothing in the georeference is changed, so this can be called from several threads at the same time
+    quint32 n = terms();
+    double x, y;
+    polynom(_xyCoef, n, pix.x(), pix.y(), x, y);
+    Eigen::Matrix2d jacobian;
+    for(int iCount = 0; iCount < INVERSE_MAXITER; ++iCount) {
+        double col, row;
+        polynom(_colrowCoef, n, x, y, col, row);
+        double deltaCol = pix.x() - col;
+        double deltaRow = pix.y() - row;
+        if ( deltaCol * deltaCol + deltaRow * deltaRow <= INVERSE_TOLERANCE * INVERSE_TOLERANCE)
+            return Coordinate(x, y, 0);
+        makeJacobianMatrix(Coordinate(x, y, 0), jacobian); // linear appr matrix of Coord2RowCol in (x,y)
+        if (std::abs(jacobian.determinant()) < EPS10)
+            return crdUNDEF;
+        Eigen::Matrix2d inverse = jacobian.inverse();
+        //improvement of crd found (linear approx) using inverse Jacobian matrix
+        x += inverse(0,0) * deltaCol + inverse(0,1) * deltaRow;
+        y += inverse(1,0) * deltaCol + inverse(1,1) * deltaRow;
     }
-    auto addJac = [&]()->std::vector<double>{
-            std::vector<double> delta = {_jacobian(0,0) * deltaPix.x() + _jacobian(0,1) * deltaPix.y(),
-            _jacobian(1,0) * deltaPix.x() + _jacobian(1,1) * deltaPix.y(),0};
-            return delta;
-    };
-
-    crdNext += addJac();
-
-    // crdNext is now 1st appr of RowCol2Coord(rRow, rCol,crd)
-    double gapStart = pixelSize() * 2;
-    Coordinate crdTrue;
-    Coordinate crdGap(gapStart,gapStart);
-    Coordinate crd0(0,0);
-    int iCount = 0;
-//    while ( !crdGap.isNear(crd0, gapStart * 2) && iCount < 10) {
-//        makeJacobianMatrix(crdNext, _jacobian);
-//        detJ = _jacobian.determinant();
-//        if (std::abs(detJ) < EPS10)
-//            return crdUNDEF;
-//        else  {
-//            _jacobian = _jacobian.inverse();
-//        }
-//        deltaPix -= nextPix;
-//        //improvement of crd found (linear approx) using inverse Jacobian matrix
-//        crdNext += addJac();
-//        crdTrue = Coordinate(crdNext.x() + _avgCrd.x, crdNext.y() + _avgCrd.y);
-//        nextPix = coord2Pixel(crdTrue);
-//        crdGap = deltaPix;
-//        nextPix[0] -= _avgPix.x;
-//        nextPix[1] -= _avgPix.y;
-
-//        iCount++;
-//    }
-    if (iCount < 10)
-        return crdNext;
     return crdUNDEF;
 }
 
-void PlanarCTPGeoReference::makeJacobianMatrix(const Coordinate &crdIn , Eigen::Matrix2d& rmJ)
+void PlanarCTPGeoReference::makeJacobianMatrix(const Coordinate &crdIn , Eigen::Matrix2d& rmJ) const
 {                     // Jacobian for 2nd/3rd order inversion
      //double	c0 = coeffCol[0];
     double	c1 = _colrowCoef[1].x;
@@ -247,7 +222,7 @@ void PlanarCTPGeoReference::makeJacobianMatrix(const Coordinate &crdIn , Eigen::
     rmJ(0,1) = c2 + c3 * x;
     rmJ(1,0) = r1 + r3 * y;
     rmJ(1,1) = r2 + r3 * x;
-    if (_transformation == tFULLSECONDORDER) {
+    if (_transformation == tFULLSECONDORDER || _transformation == tTHIRDORDER) {
         rmJ(0,0) +=  2 * c4 * x;
         rmJ(0,1) +=  2 * c5 * y;
         rmJ(1,0) +=  2 * r4 * x;
@@ -408,6 +383,12 @@ quint32 PlanarCTPGeoReference::minnr() const
   };
 }
 
+quint32 PlanarCTPGeoReference::terms() const
+{
+    // the conform transformation is determined by 2 points but uses the same 3 terms as the affine transformation
+    return _transformation == tCONFORM ? 3 : minnr();
+}
+
 bool PlanarCTPGeoReference::isValid() const
 {
     return false;
@@ -20,7 +20,6 @@ public:
     static QString typeName();
 
 private:
-    Eigen::Matrix2d _jacobian;
     double _sigma;
     Transformation _transformation;
     std::vector<Coefficient> _colrowCoef;
@@ -30,9 +29,10 @@ private:
 
     Coordinate crdInverseOfAffine(const Pixel_d &pix) const;
     Coordinate crdInverseOfProjective(const Pixel_d &pix) const;
-    Coordinate crdInverseOfHigherOrder(const Pixel_d &pix);
-    void makeJacobianMatrix(const Coordinate &crdIn, Eigen::Matrix2d &rmJ);
+    Coordinate crdInverseOfHigherOrder(const Pixel_d &pix) const;
+    void makeJacobianMatrix(const Coordinate &crdIn, Eigen::Matrix2d &rmJ) const;
     quint32 minnr() const;
+    quint32 terms() const;
 
 
 };
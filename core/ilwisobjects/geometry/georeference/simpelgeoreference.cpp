@@ -59,7 +59,7 @@ double SimpelGeoReference::pixelSize() const
 }
 
 std::vector<double> SimpelGeoReference::matrix() const {
-    return {_a11,_a21,_a21,_a22};
+    return {_a11,_a12,_a21,_a22};
 }
 
 std::vector<double> SimpelGeoReference::support() const {
@@ -2,6 +2,7 @@
 #include <functional>
 #include <future>
 #include <memory>
+#include <cmath>
 #include "kernel.h"
 #include "raster.h"
 #include "columndefinition.h"
@@ -60,3 +61,21 @@ void OperationHelper::initialize(const IIlwisObject &inputObject, Ilwis::IIlwisO
         }
     }
 }
+
+void OperationHelper::updateRanges(ITable &tbl)
+{
+    for(int i=0; i < tbl->columns(); ++i ){
+        ColumnDefinition& def = tbl->columndefinition(i);
+        if ( def.datadef().domain()->valueType() & itNUMERIC) {
+            ContainerStatistics<double> stats;
+            std::vector<QVariant> values = tbl->column(i);
+            std::vector<double> vec(values.size());
+            for(int i=0; i < vec.size(); ++i) {
+                vec[i] = values[i].toDouble();
+            }
+            stats.calculate(vec.begin(), vec.end());
+            NumericRange *rng = new NumericRange(stats[NumericStatistics::pMIN], stats[NumericStatistics::pMAX], std::pow(10,-stats.significantDigits()));
+            def.datadef().range(rng);
+        }
+    }
+}
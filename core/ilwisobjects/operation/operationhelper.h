@@ -1,12 +1,19 @@
 #ifndef OPERATIONHELPER_H
 #define OPERATIONHELPER_H
 
+#include "table.h"
+
 namespace Ilwis {
 class KERNELSHARED_EXPORT OperationHelper
 {
 public:
     OperationHelper();
     static void initialize(const IIlwisObject &inputObject, Ilwis::IIlwisObject &outputObject, IlwisTypes tp, quint64 what);
+    /*!
+     sets the ranges of the numeric columns of a table to the range of their values. Operations that write their output records after the
+     parallel part of the operation call this when the records are complete.
+     */
+    static void updateRanges(ITable& tbl);
 };
 }
 
@@ -21,6 +21,9 @@
 
 using namespace Ilwis;
 
+#define CHUNKS_PER_THREAD 8
+#define MIN_CHUNK_SIZE 256u
+
 OperationHelperFeatures::OperationHelperFeatures()
 {
 }
@@ -37,22 +40,24 @@ IIlwisObject OperationHelperFeatures::initialize(const IIlwisObject &inputObject
     return obj;
 }
 
-int OperationHelperFeatures::subdivideTasks(ExecutionContext *ctx, const IFeatureCoverage &fcov, std::vector<std::vector<quint32>> &subsets)
+int OperationHelperFeatures::subdivideTasks(ExecutionContext *ctx, const IFeatureCoverage &fcov, std::vector<FeatureRange> &chunks)
 {
-    int nofFeatures = fcov->featureCount();
-    int cores = std::min(QThread::idealThreadCount(),nofFeatures);
+    quint32 nofFeatures = fcov->featureCount();
+    int cores = std::min(QThread::idealThreadCount(),(int)nofFeatures);
     if (nofFeatures < 1000 || ctx->_threaded == false)
         cores = 1;
 
-    int block = 0;
-    subsets.resize(cores);
-    int blockBoundary = nofFeatures / cores;
-    for(int i=0; i<nofFeatures ; ++i) {
-        subsets[block].push_back(i);
-        if ( (i!= 0 && i % blockBoundary == 0) && block != cores - 1) { // last block maybe indefinitly big, catches rounding errors
-            ++block;
-        }
+    // some chunks per thread; a chunk must be big enough that fetching it costs nothing compared to processing it
+    quint32 chunkSize = cores == 1 ? nofFeatures : std::max(nofFeatures / (cores * CHUNKS_PER_THREAD), MIN_CHUNK_SIZE);
+    chunks.clear();
+    for(quint32 begin = 0; begin < nofFeatures; begin += chunkSize) {
+        chunks.push_back(FeatureRange(begin, std::min(begin + chunkSize, nofFeatures)));
     }
+    // the last chunk is open ended; the feature count of a coverage may lag behind its features. The iterator limits it to the real number
+    if ( chunks.size() == 0)
+        chunks.push_back(FeatureRange(0, iUNDEF));
+    else
+        chunks.back().second = iUNDEF;
 
     return cores;
 }
@@ -1,75 +1,83 @@
 #ifndef OPERATIONHELPERFEATURES_H
 #define OPERATIONHELPERFEATURES_H
 
+#include <atomic>
+
 namespace Ilwis {
 
-typedef  std::function<bool(const std::vector<quint32>&)> SubSetAsyncFunc;
+/*!
+ a task of a feature operation; it processes the features at the positions begin up to (not including) end of the input coverage
+ */
+typedef  std::function<bool(quint32 begin, quint32 end)> SubSetAsyncFunc;
+typedef std::pair<quint32, quint32> FeatureRange;
 
 class KERNELSHARED_EXPORT OperationHelperFeatures
 {
 public:
     OperationHelperFeatures();
     static IIlwisObject initialize(const IIlwisObject &inputObject, IlwisTypes tp, quint64 what);
-    static int subdivideTasks(ExecutionContext *ctx, const IFeatureCoverage& raster, std::vector<std::vector<quint32> > &subsets);
+    /*!
+     divides the features of a coverage in contiguous chunks. There are more chunks than threads so the load can be balanced while
+     the operation runs.
+     * \return the number of threads that should process the chunks
+     */
+    static int subdivideTasks(ExecutionContext *ctx, const IFeatureCoverage& fcov, std::vector<FeatureRange> &chunks);
     template<typename T> static bool execute(ExecutionContext* ctx, T func, IFeatureCoverage& inputFC, IFeatureCoverage& outputFC){
-        std::vector<std::vector<quint32>> subsets;
+        std::vector<FeatureRange> chunks;
 
-        int cores = OperationHelperFeatures::subdivideTasks(ctx,inputFC, subsets);
+        int cores = OperationHelperFeatures::subdivideTasks(ctx,inputFC, chunks);
         if ( cores == iUNDEF)
             return false;
+        if ( outputFC.isValid())
+            outputFC->prepareFeatureCreation();
 
-        std::vector<std::future<bool>> futures(cores);
-        bool res = true;
-
-        for(int i =0; i < cores; ++i) {
-            futures[i] = std::async(std::launch::async, func, subsets[i]);
-        }
-
-        for(int i =0; i < cores; ++i) {
-            res &= futures[i].get();
-        }
-
-        return true;
+        return runTasks(func, chunks, cores);
     }
 
     template<typename T> static bool execute(ExecutionContext* ctx, T func, IFeatureCoverage& inputFC, IFeatureCoverage& outputFC, ITable& tbl){
-        std::vector<std::vector<quint32>> subsets;
+        std::vector<FeatureRange> chunks;
 
-        int cores = OperationHelperFeatures::subdivideTasks(ctx,inputFC, subsets);
+        int cores = OperationHelperFeatures::subdivideTasks(ctx,inputFC, chunks);
         if ( cores == iUNDEF)
             return false;
+        if ( outputFC.isValid())
+            outputFC->prepareFeatureCreation();
+
+        bool res = runTasks(func, chunks, cores);
+
+        if ( res && outputFC.isValid()) {
+            //TODO better handling for multiple feature types
+            if ( !tbl.isValid())
+                return false;
+            OperationHelper::updateRanges(tbl);
+        }
+        return res;
+    }
+
+private:
+    template<typename T> static bool runTasks(T& func, const std::vector<FeatureRange>& chunks, int cores) {
+        // a thread takes the next chunk when it is done with its current one, so threads that get expensive features do not hold up the others
+        std::atomic<quint32> next(0);
+        auto worker = [&]() -> bool {
+            bool ok = true;
+            for(quint32 chunk = next++; chunk < chunks.size(); chunk = next++) {
+                ok &= func(chunks[chunk].first, chunks[chunk].second);
+            }
+            return ok;
+        };
 
         std::vector<std::future<bool>> futures(cores);
         bool res = true;
 
         for(int i =0; i < cores; ++i) {
-            futures[i] = std::async(std::launch::async, func, subsets[i]);
+            futures[i] = std::async(std::launch::async, worker);
         }
 
         for(int i =0; i < cores; ++i) {
             res &= futures[i].get();
         }
 
-        if ( res && outputFC.isValid()) {
-            //TODO better handling for multiple feature types
-            if ( !tbl.isValid())
-                return false;
-            for(int i=0; i < tbl->columns(); ++i ){
-                ColumnDefinition& def = tbl->columndefinition(i);
-                if ( def.datadef().domain()->valueType() & itNUMERIC) {
-                    ContainerStatistics<double> stats;
-                    std::vector<QVariant> values = tbl->column(i);
-                    std::vector<double> vec(values.size());
-                    for(int i=0; i < vec.size(); ++i) {
-                        vec[i] = values[i].toDouble();
-                    }
-                    stats.calculate(vec.begin(), vec.end());
-                    NumericRange *rng = new NumericRange(stats[NumericStatistics::pMIN], stats[NumericStatistics::pMAX], std::pow(10,-stats.significantDigits()));
-                    def.datadef().range(rng);
-                }
-            }
-        }
-        return true;
+        return res;
     }
 };
 }
@@ -6,6 +6,8 @@
 #include "columndefinition.h"
 #include "connectorinterface.h"
 #include "table.h"
+#include "basetable.h"
+#include "flattable.h"
 #include "attributerecord.h"
 
 using namespace Ilwis;
@@ -18,6 +20,28 @@ AttributeRecord::AttributeRecord(const ITable &attTable, const QString &keyColum
 {
 }
 
+AttributeRecord::AttributeRecord(const AttributeRecord &rec) :
+    _coverageTable(rec._coverageTable),
+    _indexTable(rec._indexTable),
+    _keyColumn(rec._keyColumn),
+    _coverageIndex(rec._coverageIndex),
+    _verticalIndex(rec._verticalIndex)
+{
+}
+
+AttributeRecord &AttributeRecord::operator=(const AttributeRecord &rec)
+{
+    if ( this == &rec)
+        return *this;
+    Locker lock(_mutex);
+    _coverageTable = rec._coverageTable;
+    _indexTable = rec._indexTable;
+    _keyColumn = rec._keyColumn;
+    _coverageIndex = rec._coverageIndex;
+    _verticalIndex = rec._verticalIndex;
+    return *this;
+}
+
 quint32 AttributeRecord::columns(bool coverages) const
 {
     if ( coverages) {
@@ -60,23 +84,39 @@ QVariant AttributeRecord::cellByKey(quint64 key, const QString& col, int index)
         return QVariant();
     }
     if ( index == -1) {
-        if ( _coverageIndex.size() == 0) {
-            indexKeyColumn();
+        std::shared_ptr<const HashColumnIndex> keyIndex;
+        {
+            Locker lock(_mutex);
+            bool flat = _coverageTable->ilwisType() == itFLATTABLE;
+            if ( flat && _coverageIndex) {
+                // taken from the table on every lookup; the table drops the index on every write to the key column and rebuilds it when asked
+                IFlatTable flattable = _coverageTable.get<FlatTable>();
+                _coverageIndex = std::static_pointer_cast<const HashColumnIndex>(flattable->index(_coverageTable->columnIndex(_keyColumn), ColumnIndex::ciHASH));
+            } else if ( !_coverageIndex || (!flat && _coverageIndex->records() != _coverageTable->records()))
+                indexKeyColumn();
+            keyIndex = _coverageIndex;
         }
-        auto iter = _coverageIndex.find(key);
-        if ( iter == _coverageIndex.end()) {
+        if ( !keyIndex)
+            return QVariant();
+        quint32 rec = keyIndex->record(key);
+        if ( rec == (quint32)iUNDEF) {
             return QVariant();
         }
-        return _coverageTable->cell(col,(*iter).second);
+        return _coverageTable->cell(col,rec);
     } else {
-        if ( _verticalIndex[index].size() == 0) {
-            indexVerticalIndex(index);
-        }
-        auto iter = _coverageIndex.find(key);
-        if ( iter == _coverageIndex.end()) {
-            return QVariant();
+        quint32 rec;
+        {
+            Locker lock(_mutex);
+            if ( _verticalIndex[index].size() == 0) {
+                indexVerticalIndex(index);
+            }
+            auto iter = _verticalIndex[index].find(key);
+            if ( iter == _verticalIndex[index].end()) {
+                return QVariant();
+            }
+            rec = (*iter).second;
         }
-        return _indexTable->cell(col,(*iter).second);
+        return _indexTable->cell(col,rec);
     }
     return QVariant();
 }
@@ -88,6 +128,44 @@ QVariant AttributeRecord::cellByIndex(quint64 index, quint32 colIndex, int )
     return QVariant();
 }
 
+bool AttributeRecord::projectColumn(const QString &col, std::vector<double> &values, quint32 maxKey) const
+{
+    if ( !isValid())
+        return false;
+    std::vector<QVariant> keys = _coverageTable->column(_keyColumn);
+    std::vector<QVariant> data = _coverageTable->column(col);
+    if ( keys.size() == 0 || data.size() != keys.size())
+        return false;
+
+    // undefined keys (iUNDEF or rUNDEF, depending on the column) have no place in the projection
+    auto toKey = [](const QVariant& var) -> quint32 {
+        bool ok;
+        double key = var.toDouble(&ok);
+        if ( !ok || isNumericalUndef(key) || key < 0 || key >= (double)(quint32)iUNDEF)
+            return iUNDEF;
+        return (quint32)key;
+    };
+    quint32 largest = 0;
+    for(const QVariant& var : keys) {
+        quint32 key = toKey(var);
+        if ( key != (quint32)iUNDEF)
+            largest = std::max(largest, key);
+    }
+    if ( largest > maxKey)
+        return false;
+
+    values.assign(largest + 1, rUNDEF);
+    for(qint32 rec = keys.size() - 1; rec >= 0; --rec) { // backwards; for duplicate keys the first record wins, as in cellByKey
+        quint32 key = toKey(keys[rec]);
+        if ( key == (quint32)iUNDEF)
+            continue;
+        bool ok;
+        double v = data[rec].toDouble(&ok);
+        values[key] = ok && !isNumericalUndef(v) ? v : rUNDEF;
+    }
+    return true;
+}
+
 void AttributeRecord::indexVerticalIndex(int index){
     quint32 rec = 0;
     std::vector<QVariant> values = _indexTable->column(_keyColumn);
@@ -98,19 +176,32 @@ void AttributeRecord::indexVerticalIndex(int index){
 }
 
 void AttributeRecord::indexKeyColumn(){
-    quint32 rec = 0;
-    std::vector<QVariant> values = _coverageTable->column(_keyColumn);
-    for(const QVariant& val : values) {
-        _coverageIndex[val.toInt()] = rec++;
+    _coverageIndex.reset();
+    quint32 colIndex = _coverageTable->columnIndex(_keyColumn);
+    if ( colIndex == (quint32)iUNDEF)
+        return;
+    if ( _coverageTable->ilwisType() == itFLATTABLE) {
+        IFlatTable flattable = _coverageTable.get<FlatTable>();
+        flattable->createIndex(_keyColumn, ColumnIndex::ciHASH);
+        _coverageIndex = std::static_pointer_cast<const HashColumnIndex>(flattable->index(colIndex, ColumnIndex::ciHASH));
+        return;
     }
+    // other tables keep no indexes, the keys are copied to a private column store to build one
+    std::unique_ptr<ColumnStore> store(ColumnStore::create(_coverageTable->columndefinition(colIndex)));
+    std::vector<QVariant> values = _coverageTable->column(colIndex);
+    store->resize(values.size());
+    for(quint32 rec = 0; rec < values.size(); ++rec)
+        store->setValue(rec, values[rec]);
+    _coverageIndex.reset(new HashColumnIndex(store.get()));
 }
 
 void AttributeRecord::setTable(const ITable &tbl, const QString& keyColumn, int indexCount)
 {
+    Locker lock(_mutex);
     if ( indexCount == -1) {
         _coverageTable = tbl;
         _keyColumn = keyColumn;
-        _coverageIndex.clear();
+        _coverageIndex.reset();
     } else {
         _verticalIndex.resize(indexCount);
         _indexTable = tbl;
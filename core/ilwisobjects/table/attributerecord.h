@@ -7,17 +7,36 @@
 
 
 namespace Ilwis {
+class HashColumnIndex;
+
+/*!
+ Gives access to the attributes of the elements of a coverage through their key (raw value or feature id). The index on the key column
+ is owned by the attribute table (\se FlatTable::createIndex) so all records on the same table, e.g. one per thread, share it; the table
+ rebuilds it after the key column is changed. Tables that keep no indexes get a private index that is rebuilt when the number of records
+ changes. Lookups can be done from several threads at the same time.
+ */
 class KERNELSHARED_EXPORT AttributeRecord
 {
 public:
     AttributeRecord();
     AttributeRecord(const ITable& attTable, const QString& keyColumn);
+    AttributeRecord(const AttributeRecord& rec);
+    AttributeRecord& operator=(const AttributeRecord& rec);
 
     quint32 columns(bool coverages=true) const;
     ColumnDefinition columndefinition(const QString& nme, bool coverages=true) const;
     quint32 columnIndex(const QString& nme, bool coverages=true) const;
     QVariant cellByKey(quint64 key, const QString &col, int index=-1);
     QVariant cellByIndex(quint64 index, quint32 colIndex, int zindex=-1);
+    /*!
+     projects a numeric column on the keys of the attribute table. The result is a dense array in which the value that belongs to key k is at position k.
+     Reclassifying by attribute then becomes a simple array lookup. The projection is a copy; it doesnt follow later changes of the table
+     * \param col name of the column
+     * \param values receives the values; keys without a record (or with an undefined value) get rUNDEF
+     * \param maxKey the projection fails if the largest key is larger than this
+     * \return false if the column doesnt exist or the keys are too sparse to project them on an array
+     */
+    bool projectColumn(const QString& col, std::vector<double>& values, quint32 maxKey=1 << 24) const;
     void setTable(const ITable& tbl, const QString& keyColumn, int indexCount=-1);
     bool isValid() const;
 private:
@@ -26,8 +45,9 @@ private:
     ITable _coverageTable;
     ITable _indexTable;
     QString _keyColumn;
-    std::unordered_map<quint32, quint32> _coverageIndex;
+    std::shared_ptr<const HashColumnIndex> _coverageIndex;
     std::vector<std::unordered_map<quint32, quint32>> _verticalIndex;
+    std::mutex _mutex; // the indexes are build on first use, and one record is shared by all features of a coverage
 
 };
 
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cmath>
+#include "kernel.h"
+#include "ilwisdata.h"
+#include "domain.h"
+#include "columnstore.h"
+#include "columnindex.h"
+
+using namespace Ilwis;
+
+SelectionBitmap::SelectionBitmap(quint32 sz, bool value) : _size(sz)
+{
+    _bits.resize((sz + 63) / 64, value ? ~0ULL : 0ULL);
+    if ( value && sz % 64 != 0) // bits beyond the size are always zero
+        _bits.back() = (1ULL << (sz % 64)) - 1;
+}
+
+quint32 SelectionBitmap::size() const
+{
+    return _size;
+}
+
+quint32 SelectionBitmap::words() const
+{
+    return _bits.size();
+}
+
+void SelectionBitmap::set(quint32 index, bool yesno)
+{
+    if ( index >= _size)
+        return;
+    if ( yesno)
+        _bits[index / 64] |= 1ULL << (index % 64);
+    else
+        _bits[index / 64] &= ~(1ULL << (index % 64));
+}
+
+bool SelectionBitmap::test(quint32 index) const
+{
+    if ( index >= _size)
+        return false;
+    return (_bits[index / 64] & (1ULL << (index % 64))) != 0;
+}
+
+void SelectionBitmap::combine(const SelectionBitmap &bits, LogicalOperator oper)
+{
+    if ( bits._size != _size)
+        return;
+    quint32 n = _bits.size();
+    switch(oper){
+    case loNONE:
+        _bits = bits._bits; break;
+    case loAND:
+        for(quint32 i=0; i < n; ++i)
+            _bits[i] &= bits._bits[i];
+        break;
+    case loOR:
+        for(quint32 i=0; i < n; ++i)
+            _bits[i] |= bits._bits[i];
+        break;
+    case loXOR:
+        for(quint32 i=0; i < n; ++i)
+            _bits[i] ^= bits._bits[i];
+        break;
+    default:
+        std::fill(_bits.begin(), _bits.end(), 0ULL);
+    }
+}
+
+std::vector<quint32> SelectionBitmap::indexes() const
+{
+    std::vector<quint32> result;
+    for(quint32 w=0; w < _bits.size(); ++w) {
+        quint64 word = _bits[w];
+        quint32 rec = w * 64;
+        while( word != 0) { // skips empty words and stops after the last set bit of a word
+            if ( word & 1ULL)
+                result.push_back(rec);
+            word >>= 1;
+            ++rec;
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------
+SortedColumnIndex::SortedColumnIndex(const ColumnStore *store) : _size(0)
+{
+    if ( store == 0)
+        return;
+    _size = store->size();
+    std::vector<std::pair<double, quint32>> pairs;
+    pairs.reserve(_size);
+    if ( store->storageType() == ColumnStore::stNUMERIC) {
+        const NumericColumnStore *numbers = static_cast<const NumericColumnStore *>(store);
+        for(quint32 rec = 0; rec < _size; ++rec) {
+            double v = numbers->at(rec);
+            if ( v != rUNDEF)
+                pairs.push_back({v, rec});
+        }
+    } else if ( store->storageType() == ColumnStore::stRAW) {
+        const RawColumnStore *raws = static_cast<const RawColumnStore *>(store);
+        for(quint32 rec = 0; rec < _size; ++rec) {
+            quint32 raw = raws->at(rec);
+            if ( raw != raws->undefined())
+                pairs.push_back({(double)raw, rec});
+        }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [](const std::pair<double, quint32>& p1, const std::pair<double, quint32>& p2){
+        return p1.first < p2.first;
+    });
+    _values.resize(pairs.size());
+    _records.resize(pairs.size());
+    for(quint32 i = 0; i < pairs.size(); ++i) {
+        _values[i] = pairs[i].first;
+        _records[i] = pairs[i].second;
+    }
+}
+
+ColumnIndex::IndexType SortedColumnIndex::indexType() const
+{
+    return ciSORTED;
+}
+
+quint32 SortedColumnIndex::records() const
+{
+    return _size;
+}
+
+bool SortedColumnIndex::select(LogicalOperator oper, double value, SelectionBitmap &bits) const
+{
+    if ( value == rUNDEF) // nothing compares to undefined
+        return true;
+    auto begin = _values.begin();
+    auto end = _values.end();
+    switch(oper){
+    case loEQ:
+        begin = std::lower_bound(_values.begin(), _values.end(), value);
+        end = std::upper_bound(begin, _values.end(), value);
+        break;
+    case loLESS:
+        end = std::lower_bound(_values.begin(), _values.end(), value); break;
+    case loLESSEQ:
+        end = std::upper_bound(_values.begin(), _values.end(), value); break;
+    case loGREATER:
+        begin = std::upper_bound(_values.begin(), _values.end(), value); break;
+    case loGREATEREQ:
+        begin = std::lower_bound(_values.begin(), _values.end(), value); break;
+    default:
+        return false;
+    }
+    quint32 first = begin - _values.begin();
+    quint32 last = end - _values.begin();
+    for(quint32 i = first; i < last; ++i)
+        bits.set(_records[i]);
+    return true;
+}
+
+//------------------------------------------------------------------------
+HashColumnIndex::HashColumnIndex(const ColumnStore *store) : _size(0)
+{
+    if ( store == 0)
+        return;
+    _size = store->size();
+    std::vector<std::pair<quint64, quint32>> pairs;
+    pairs.reserve(_size);
+    if ( store->storageType() == ColumnStore::stNUMERIC) {
+        const NumericColumnStore *numbers = static_cast<const NumericColumnStore *>(store);
+        for(quint32 rec = 0; rec < _size; ++rec) {
+            double v = numbers->at(rec);
+            if ( v != rUNDEF && v >= 0 && v == std::floor(v))
+                pairs.push_back({(quint64)v, rec});
+        }
+    } else if ( store->storageType() == ColumnStore::stRAW || store->storageType() == ColumnStore::stSTRING) {
+        const TypedColumnStore<quint32> *keys = static_cast<const TypedColumnStore<quint32> *>(store);
+        for(quint32 rec = 0; rec < _size; ++rec) {
+            quint32 key = keys->at(rec);
+            if ( key != keys->undefined())
+                pairs.push_back({key, rec});
+        }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [](const std::pair<quint64, quint32>& p1, const std::pair<quint64, quint32>& p2){
+        return p1.first < p2.first;
+    });
+    _records.resize(pairs.size());
+    _ranges.reserve(pairs.size());
+    quint32 first = 0;
+    for(quint32 i = 0; i < pairs.size(); ++i) {
+        _records[i] = pairs[i].second;
+        if ( i + 1 == pairs.size() || pairs[i + 1].first != pairs[i].first) {
+            _ranges[pairs[i].first] = {first, i + 1};
+            first = i + 1;
+        }
+    }
+}
+
+ColumnIndex::IndexType HashColumnIndex::indexType() const
+{
+    return ciHASH;
+}
+
+quint32 HashColumnIndex::records() const
+{
+    return _size;
+}
+
+quint32 HashColumnIndex::record(quint64 key) const
+{
+    auto iter = _ranges.find(key);
+    if ( iter == _ranges.end())
+        return iUNDEF;
+    return _records[(*iter).second.first];
+}
+
+quint32 HashColumnIndex::count(quint64 key) const
+{
+    auto iter = _ranges.find(key);
+    if ( iter == _ranges.end())
+        return 0;
+    return (*iter).second.second - (*iter).second.first;
+}
+
+bool HashColumnIndex::select(quint64 key, SelectionBitmap &bits) const
+{
+    auto iter = _ranges.find(key);
+    if ( iter == _ranges.end())
+        return false;
+    for(quint32 i = (*iter).second.first; i < (*iter).second.second; ++i)
+        bits.set(_records[i]);
+    return true;
+}
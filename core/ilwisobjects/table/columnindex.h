@@ -0,0 +1,108 @@
+#ifndef COLUMNINDEX_H
+#define COLUMNINDEX_H
+
+#include <memory>
+#include <unordered_map>
+#include "Kernel_global.h"
+
+namespace Ilwis {
+
+class ColumnStore;
+
+/*!
+ A set of records stored as one bit per record. Selections on tables are computed as bitmaps so that conditions can be combined
+ 64 records at a time.
+ */
+class KERNELSHARED_EXPORT SelectionBitmap {
+public:
+    SelectionBitmap(quint32 sz=0, bool value=false);
+
+    quint32 size() const;
+    quint32 words() const;
+    quint64& word(quint32 w) { return _bits[w]; }
+    quint64 word(quint32 w) const { return _bits[w]; }
+    void set(quint32 index, bool yesno=true);
+    bool test(quint32 index) const;
+    /*!
+     combines this bitmap with another bitmap of the same size.
+     * \param bits the other bitmap
+     * \param oper loNONE replaces the current bits, loAND, loOR and loXOR combine them bitwise
+     */
+    void combine(const SelectionBitmap& bits, LogicalOperator oper);
+    /*!
+     \return the record numbers of all bits that are set, in ascending order
+     */
+    std::vector<quint32> indexes() const;
+
+private:
+    std::vector<quint64> _bits;
+    quint32 _size;
+};
+
+/*!
+ Base class for the (optional) indexes on the columns of a FlatTable. An index is immutable once it is build; when the column changes
+ the table drops the index and builds a new one when it is needed again. This means that an index can be shared freely between threads.
+ */
+class KERNELSHARED_EXPORT ColumnIndex {
+public:
+    enum IndexType{ciSORTED=1, ciHASH=2};
+
+    virtual ~ColumnIndex() {}
+    virtual IndexType indexType() const = 0;
+    virtual quint32 records() const = 0;
+};
+
+/*!
+ Index on the numeric values of a column (numeric values or item raws) sorted in ascending order. Supports equality and range selections.
+ Undefined values are not part of the index.
+ */
+class KERNELSHARED_EXPORT SortedColumnIndex : public ColumnIndex {
+public:
+    SortedColumnIndex(const ColumnStore *store);
+
+    IndexType indexType() const;
+    quint32 records() const;
+    /*!
+     selects all records that satisfy 'value-of-record oper value'
+     * \param oper one of the operators loEQ, loLESS, loLESSEQ, loGREATER, loGREATEREQ
+     * \param value right hand side of the condition
+     * \param bits bitmap in which the bits of the selected records are set
+     * \return false if the operator can not be handled by the index
+     */
+    bool select(LogicalOperator oper, double value, SelectionBitmap& bits) const;
+
+private:
+    std::vector<double> _values;
+    std::vector<quint32> _records;
+    quint32 _size;
+};
+
+/*!
+ Index on the keys of a column. Keys are the raws of item columns, the dictionary keys of string columns or the positive whole numbers of numeric columns.
+ Records with the same key are stored consecutively so all records of a key can be retrieved at once.
+ */
+class KERNELSHARED_EXPORT HashColumnIndex : public ColumnIndex {
+public:
+    HashColumnIndex(const ColumnStore *store);
+
+    IndexType indexType() const;
+    quint32 records() const;
+    /*!
+     returns the first record that has the key
+     * \param key the key to look for
+     * \return the record number or iUNDEF if the key is not in the index
+     */
+    quint32 record(quint64 key) const;
+    quint32 count(quint64 key) const;
+    bool select(quint64 key, SelectionBitmap& bits) const;
+
+private:
+    std::vector<quint32> _records;
+    std::unordered_map<quint64, std::pair<quint32, quint32>> _ranges;
+    quint32 _size;
+};
+
+typedef std::shared_ptr<ColumnIndex> SPColumnIndex;
+}
+
+#endif // COLUMNINDEX_H
@@ -0,0 +1,206 @@
+#include "kernel.h"
+#include "ilwisdata.h"
+#include "domain.h"
+#include "range.h"
+#include "domainitem.h"
+#include "itemrange.h"
+#include "datadefinition.h"
+#include "columndefinition.h"
+#include "columnstore.h"
+
+using namespace Ilwis;
+
+ColumnStore *ColumnStore::create(const ColumnDefinition &def)
+{
+    IDomain dom = def.datadef().domain();
+    if ( !dom.isValid())
+        return new VariantColumnStore();
+
+    IlwisTypes tp = dom->ilwisType();
+    if ( hasType(tp, itNUMERICDOMAIN))
+        return new NumericColumnStore();
+    if ( hasType(tp, itITEMDOMAIN))
+        return new RawColumnStore(dom);
+    if ( hasType(tp, itTEXTDOMAIN))
+        return new StringColumnStore();
+
+    return new VariantColumnStore();
+}
+
+//------------------------------------------------------------------------
+NumericColumnStore::NumericColumnStore() : TypedColumnStore<double>(rUNDEF)
+{
+}
+
+ColumnStore::StorageType NumericColumnStore::storageType() const
+{
+    return stNUMERIC;
+}
+
+QVariant NumericColumnStore::value(quint32 rec) const
+{
+    if ( rec >= _data.size())
+        return QVariant();
+    return _data[rec];
+}
+
+void NumericColumnStore::setValue(quint32 rec, const QVariant &var)
+{
+    if ( rec >= _data.size())
+        return;
+    bool ok = var.isValid();
+    double v = ok ? var.toDouble(&ok) : rUNDEF;
+    _data[rec] = ok ? v : rUNDEF;
+}
+
+ColumnStore *NumericColumnStore::clone() const
+{
+    return new NumericColumnStore(*this);
+}
+
+//------------------------------------------------------------------------
+RawColumnStore::RawColumnStore(const IDomain& dom) : TypedColumnStore<quint32>(iUNDEF), _domain(dom)
+{
+}
+
+ColumnStore::StorageType RawColumnStore::storageType() const
+{
+    return stRAW;
+}
+
+QVariant RawColumnStore::value(quint32 rec) const
+{
+    if ( rec >= _data.size() || _data[rec] == _undefined)
+        return QVariant();
+    return _data[rec];
+}
+
+void RawColumnStore::setValue(quint32 rec, const QVariant &var)
+{
+    if ( rec >= _data.size())
+        return;
+    if ( !var.isValid()) {
+        _data[rec] = _undefined;
+        return;
+    }
+    bool ok;
+    quint32 raw = var.toUInt(&ok);
+    if ( !ok && _domain.isValid()) { // the value might be the name of an item instead of its raw value
+        SPItemRange rng = _domain->range<ItemRange>();
+        if ( !rng.isNull()) {
+            SPDomainItem item = rng->item(var.toString());
+            ok = !item.isNull();
+            if ( ok)
+                raw = item->raw();
+        }
+    }
+    _data[rec] = ok ? raw : _undefined;
+}
+
+ColumnStore *RawColumnStore::clone() const
+{
+    return new RawColumnStore(*this);
+}
+
+//------------------------------------------------------------------------
+StringColumnStore::StringColumnStore() : TypedColumnStore<quint32>(iUNDEF)
+{
+}
+
+StringColumnStore::StringColumnStore(const StringColumnStore &store) : TypedColumnStore<quint32>(store)
+{
+    Locker lock(store._mutex);
+    _dictionary = store._dictionary;
+    _keys = store._keys;
+}
+
+ColumnStore::StorageType StringColumnStore::storageType() const
+{
+    return stSTRING;
+}
+
+QVariant StringColumnStore::value(quint32 rec) const
+{
+    if ( rec >= _data.size() || _data[rec] == _undefined)
+        return QVariant();
+    Locker lock(_mutex);
+    return _dictionary[_data[rec]];
+}
+
+void StringColumnStore::setValue(quint32 rec, const QVariant &var)
+{
+    if ( rec >= _data.size())
+        return;
+    if ( !var.isValid()) {
+        _data[rec] = _undefined;
+        return;
+    }
+    QString txt = var.toString();
+    quint32 key;
+    {
+        Locker lock(_mutex);
+        auto iter = _keys.find(txt);
+        if ( iter == _keys.end()) {
+            iter = _keys.insert(txt, _dictionary.size());
+            _dictionary.push_back(txt);
+        }
+        key = iter.value();
+    }
+    _data[rec] = key;
+}
+
+ColumnStore *StringColumnStore::clone() const
+{
+    return new StringColumnStore(*this);
+}
+
+quint32 StringColumnStore::key(const QString &txt) const
+{
+    Locker lock(_mutex);
+    auto iter = _keys.find(txt);
+    if ( iter == _keys.end())
+        return iUNDEF;
+    return iter.value();
+}
+
+QString StringColumnStore::text(quint32 key) const
+{
+    Locker lock(_mutex);
+    if ( key < (quint32)_dictionary.size())
+        return _dictionary[key];
+    return sUNDEF;
+}
+
+quint32 StringColumnStore::keyCount() const
+{
+    Locker lock(_mutex);
+    return _dictionary.size();
+}
+
+//------------------------------------------------------------------------
+VariantColumnStore::VariantColumnStore() : TypedColumnStore<QVariant>(QVariant())
+{
+}
+
+ColumnStore::StorageType VariantColumnStore::storageType() const
+{
+    return stVARIANT;
+}
+
+QVariant VariantColumnStore::value(quint32 rec) const
+{
+    if ( rec >= _data.size())
+        return QVariant();
+    return _data[rec];
+}
+
+void VariantColumnStore::setValue(quint32 rec, const QVariant &var)
+{
+    if ( rec < _data.size())
+        _data[rec] = var;
+}
+
+ColumnStore *VariantColumnStore::clone() const
+{
+    return new VariantColumnStore(*this);
+}
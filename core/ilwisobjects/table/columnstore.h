@@ -0,0 +1,159 @@
+#ifndef COLUMNSTORE_H
+#define COLUMNSTORE_H
+
+#include <memory>
+#include <mutex>
+#include "Kernel_global.h"
+
+namespace Ilwis {
+
+class ColumnDefinition;
+
+/*!
+ A read only view on the native values of a column. The view points directly into the storage of the column, nothing is copied.
+ The view is only valid as long as the column it was taken from is not resized (e.g. by adding records).
+ */
+template<typename T> class ColumnView {
+public:
+    ColumnView() : _begin(0), _size(0) {}
+    ColumnView(const T *begin, quint32 sz) : _begin(begin), _size(sz) {}
+
+    const T *begin() const { return _begin; }
+    const T *end() const { return _begin + _size; }
+    const T& operator[](quint32 index) const { return _begin[index]; }
+    quint32 size() const { return _size; }
+    bool isValid() const { return _begin != 0 && _size != 0; }
+
+private:
+    const T *_begin;
+    quint32 _size;
+};
+
+/*!
+ The storage of one column of a table. Values are kept in a native typed array that is choosen from the domain of the column
+ - numeric domains are stored as doubles, undefined values are rUNDEF
+ - item domains are stored as the raw values of the items, undefined values are iUNDEF
+ - text domains are stored as an index in a dictionary of unique strings
+ - all other domains fall back to QVariants
+ */
+class KERNELSHARED_EXPORT ColumnStore {
+public:
+    enum StorageType{stNUMERIC, stRAW, stSTRING, stVARIANT};
+
+    virtual ~ColumnStore() {}
+
+    virtual StorageType storageType() const = 0;
+    virtual quint32 size() const = 0;
+    virtual void resize(quint32 n) = 0;
+    virtual QVariant value(quint32 rec) const = 0;
+    virtual void setValue(quint32 rec, const QVariant& var) = 0;
+    virtual ColumnStore *clone() const = 0;
+
+    /*!
+     creates a column storage that matches the domain of the column definition
+     * \param def the definition of the column
+     * \return a new (empty) column storage. The caller owns the pointer
+     */
+    static ColumnStore *create(const ColumnDefinition& def);
+};
+
+template<typename T> class TypedColumnStore : public ColumnStore {
+public:
+    TypedColumnStore(const T& undefined) : _undefined(undefined) {}
+
+    quint32 size() const {
+        return _data.size();
+    }
+
+    void resize(quint32 n) {
+        _data.resize(n, _undefined);
+    }
+
+    ColumnView<T> view() const {
+        if ( _data.size() == 0)
+            return ColumnView<T>();
+        return ColumnView<T>(&_data[0], _data.size());
+    }
+
+    const T& at(quint32 rec) const {
+        return _data[rec];
+    }
+
+    T& at(quint32 rec) {
+        return _data[rec];
+    }
+
+    const T& undefined() const {
+        return _undefined;
+    }
+
+protected:
+    std::vector<T> _data;
+    T _undefined;
+};
+
+class KERNELSHARED_EXPORT NumericColumnStore : public TypedColumnStore<double> {
+public:
+    NumericColumnStore();
+
+    StorageType storageType() const;
+    QVariant value(quint32 rec) const;
+    void setValue(quint32 rec, const QVariant& var);
+    ColumnStore *clone() const;
+};
+
+class KERNELSHARED_EXPORT RawColumnStore : public TypedColumnStore<quint32> {
+public:
+    RawColumnStore(const IDomain& dom=IDomain());
+
+    StorageType storageType() const;
+    QVariant value(quint32 rec) const;
+    void setValue(quint32 rec, const QVariant& var);
+    ColumnStore *clone() const;
+
+private:
+    IDomain _domain;
+};
+
+/*!
+ Stores strings as indexes in a dictionary of unique strings. Columns with many repeating values (names, labels) only store each string once.
+ The dictionary is shared by all records, so it is guarded by a mutex; threads can write different records of the column at the same time.
+ */
+class KERNELSHARED_EXPORT StringColumnStore : public TypedColumnStore<quint32> {
+public:
+    StringColumnStore();
+    StringColumnStore(const StringColumnStore& store);
+
+    StorageType storageType() const;
+    QVariant value(quint32 rec) const;
+    void setValue(quint32 rec, const QVariant& var);
+    ColumnStore *clone() const;
+    /*!
+     returns the dictionary index of a string
+     * \param text the string to look for
+     * \return the index or iUNDEF if the string doesnt occur in the column
+     */
+    quint32 key(const QString& text) const;
+    QString text(quint32 key) const;
+    quint32 keyCount() const;
+
+private:
+    QStringList _dictionary;
+    QHash<QString, quint32> _keys;
+    mutable std::mutex _mutex;
+};
+
+class KERNELSHARED_EXPORT VariantColumnStore : public TypedColumnStore<QVariant> {
+public:
+    VariantColumnStore();
+
+    StorageType storageType() const;
+    QVariant value(quint32 rec) const;
+    void setValue(quint32 rec, const QVariant& var);
+    ColumnStore *clone() const;
+};
+
+typedef std::shared_ptr<ColumnStore> SPColumnStore;
+}
+
+#endif // COLUMNSTORE_H
@@ -34,6 +34,7 @@ void DatabaseTable::drop() {
             kernel()->issues()->logSql(db.lastError());
         }
     }
+    _statements.clear();
     _dataloaded = false;
     _sqlCreateDone = false;
 }
@@ -95,6 +96,7 @@ bool DatabaseTable::addColumn(const QString &name, const IDomain &domain){
             kernel()->issues()->logSql(db.lastError());
             return false;
         }
+        _statements.clear(); // prepared statements refer to the old layout of the table
     }
     return true;
 }
@@ -103,23 +105,24 @@ std::vector<QVariant> DatabaseTable::record(quint32 n) const {
     if (!const_cast<DatabaseTable *>(this)->initLoad())
         return std::vector<QVariant>();
 
-    QSqlQuery db(_database);
-    QString query = QString("Select * from %1 where record_index=%2 ").arg(internalName().arg(n));
-    if ( db.exec(query)){
+    QSqlQuery& db = statement(QString("Select %1 from %2 where record_index=?").arg(columnList(0, _columns), internalName()));
+    db.bindValue(0, n);
+    if ( db.exec()){
         if ( db.next()) {
             QSqlRecord rec = db.record();
             std::vector<QVariant> values(rec.count());
             for(int i = 0; i < rec.count(); ++i) {
                 values[i] = rec.value(i);
             }
+            db.finish();
             return values;
 
 
         } else{
             kernel()->issues()->log(TR("Invalid record number in record query"));
         }
-        kernel()->issues()->logSql(db.lastError());
     }
+    kernel()->issues()->logSql(db.lastError());
     return std::vector<QVariant>();
 }
 
@@ -127,51 +130,27 @@ void DatabaseTable::record(quint32 rec, const std::vector<QVariant> &vars, quint
 {
     if (!const_cast<DatabaseTable *>(this)->initLoad())
         return ;
-     QSqlQuery db(_database);
-    if ( rec >= _rows || rec == iUNDEF) {
-        QString stmt = QString("INSERT INTO %1 " ).arg(internalName());
-        QString columnPart;
-        QString valuePart;
-        for(int count=0; count < vars.size(); ++count) {
-            QString dataType = valueType2DataType(_columnDefinitionsByIndex[offset + count].datadef().domain()->valueType());
-            bool needQuotes = dataType == "TEXT";
-
-            if ( count > 0) {
-                columnPart += ",";
-                valuePart += ",";
-            }
-            columnPart +=  _columnDefinitionsByIndex[offset + count].name();
-            if ( needQuotes )
-                valuePart += QString("'%1'").arg(vars[count].toString());
-            else
-                valuePart += QString("%1").arg(vars[count].toString());
-        }
-        stmt += "(" + columnPart + ")" + "VALUES(" + valuePart + ")";
-        if ( !db.exec(stmt)){
-            kernel()->issues()->logSql(db.lastError());
-            return ;
-        }
+    if ( offset >= _columns)
+        return;
+    quint32 count = std::min((quint32)vars.size(), _columns - offset);
+    bool isNew = rec >= _rows || rec == iUNDEF;
+    QString stmt;
+    if ( isNew) {
+        rec = _rows;
+        stmt = QString("INSERT INTO %1 (%2,record_index) VALUES(%3?)").arg(internalName(), columnList(offset, count), QString("?,").repeated(count));
+    } else {
+        stmt = QString("UPDATE %1 SET %2 where record_index=?").arg(internalName(), columnList(offset, count, "=?"));
     }
-    else if ( rec < _rows) {
-        QString stmt = QString("UPDATE %1 SET " ).arg(internalName());
-        QString rest;
-        for(int count=0; count < vars.size(); ++count) {
-            int index = offset + count;
-            QString dataType = valueType2DataType(_columnDefinitionsByIndex[index].datadef().domain()->valueType());
-            bool needQuotes = dataType == "TEXT";
-            if ( count > 0)
-                rest += ",";
-            if ( needQuotes )
-                rest += QString(" %1='%2' ").arg( _columnDefinitionsByIndex[index].name()).arg(vars[count].toString());
-            else
-                rest += QString(" %1=%2 ").arg( _columnDefinitionsByIndex[index].name()).arg(vars[count].toString());
-        }
-        stmt += rest + QString(" where record_index=%1").arg(rec);
-        if ( !db.exec(stmt)){
-            kernel()->issues()->logSql(db.lastError());
-            return ;
-        }
+    QSqlQuery& db = statement(stmt);
+    for(quint32 i=0; i < count; ++i)
+        db.bindValue(i, vars[i]);
+    db.bindValue(count, rec);
+    if ( !db.exec()){
+        kernel()->issues()->logSql(db.lastError());
+        return ;
     }
+    if ( isNew)
+        ++_rows;
 }
 
 QVariant DatabaseTable::cell(quint32 index, quint32 rec) const{
@@ -189,23 +168,18 @@ QVariant DatabaseTable::cell(const QString& col, quint32 rec) const{
     quint32 index = columnIndex(col);
     if ( index == iUNDEF)
         return QVariant();
-    QSqlQuery db(_database);
-    QString stmt = QString("Select * from %1 where record_index=%2 ").arg(col).arg(rec);
-    if ( db.exec(stmt)){
+    QSqlQuery& db = statement(QString("Select %1 from %2 where record_index=?").arg(col, internalName()));
+    db.bindValue(0, rec);
+    if ( db.exec()){
         if ( db.next()) {
-            QSqlRecord rec = db.record();
-            QVariant value;
-            for(int i = 0; i < rec.count(); ++i) {
-                value = rec.value(i);
-            }
+            QVariant value = db.value(0);
+            db.finish();
             return value;
-
-
         } else{
             kernel()->issues()->log(TR("Invalid record number in record query"));
         }
-        kernel()->issues()->logSql(db.lastError());
     }
+    kernel()->issues()->logSql(db.lastError());
     return QVariant();
 
 }
@@ -222,45 +196,29 @@ void DatabaseTable::cell(const QString &col, quint32 rec, const QVariant &var)
 {
     if (!const_cast<DatabaseTable *>(this)->initLoad())
         return ;
-    QString stmt;
     const ColumnDefinition& def = _columnDefinitionsByName[col];
     QString dataType = valueType2DataType(def.datadef().domain()->valueType());
     if ( dataType == sUNDEF) {
         kernel()->issues()->log(TR("Invalid datatype in column definition"));
         return;
     }
-    if ( rec >= _rows){
-        stmt = QString("INSERT INTO %1 " ).arg(internalName());
-        QString columnPart;
-        QString valuePart;
-
-        bool needQuotes = dataType == "TEXT";
-
-        columnPart +=  def.name();
-        if ( needQuotes )
-            valuePart += QString("'%1'").arg(var.toString());
-        else
-            valuePart += QString("%1").arg(var.toString());
-        stmt += "(" + columnPart + ")" + "VALUES(" + valuePart + ")";
-     } else if ( rec < _rows) {
-        stmt = QString("UPDATE %1 SET " ).arg(internalName());
-        QString rest;
-
-        bool needQuotes = dataType == "TEXT";
-        if ( needQuotes )
-            rest += QString(" %1='%2' ").arg( def.name()).arg(var.toString());
-        else
-            rest += QString(" %1=%2 ").arg( def.name()).arg(var.toString());
-        stmt += rest + QString(" where record_index=%1").arg(rec);
+    bool isNew = rec >= _rows;
+    QString stmt;
+    if ( isNew){
+        rec = _rows;
+        stmt = QString("INSERT INTO %1 (%2,record_index) VALUES(?,?)" ).arg(internalName(), def.name());
+    } else {
+        stmt = QString("UPDATE %1 SET %2=? where record_index=?" ).arg(internalName(), def.name());
     }
-    QSqlQuery db(_database);
-    if ( !db.exec(stmt)){
+    QSqlQuery& db = statement(stmt);
+    db.bindValue(0, var);
+    db.bindValue(1, rec);
+    if ( !db.exec()){
         kernel()->issues()->logSql(db.lastError());
         return ;
     }
-
-
-
+    if ( isNew)
+        ++_rows;
 }
 
 std::vector<QVariant> DatabaseTable::column(quint32 index) const {
@@ -277,10 +235,12 @@ std::vector<QVariant> DatabaseTable::column(const QString& nme)  const{
         return std::vector<QVariant>();
 
     QSqlQuery db(_database);
-    QString query = QString("Select %1 from %2").arg(nme,internalName());
+    db.setForwardOnly(true);
+    QString query = QString("Select %1 from %2 order by record_index").arg(nme,internalName());
     if ( db.exec(query)){
         if ( db.next()) {
             std::vector<QVariant> values;
+            values.reserve(_rows);
             do {
                 values.push_back(db.value(0)) ;
             } while(db.next());
@@ -310,55 +270,104 @@ void DatabaseTable::column(const QString &nme, const std::vector<QVariant> &vars
     if (!const_cast<DatabaseTable *>(this)->initLoad())
         return ;
 
+    writeColumn(nme, vars, offset);
+}
+
+bool DatabaseTable::writeColumn(const QString &nme, const std::vector<QVariant> &vars, quint32 offset)
+{
     quint32 index = columnIndex(nme);
     if ( index == iUNDEF)
-        return ;
+        return false;
     _rows = numberOfExistingRecords();
-    int outside = offset + vars.size() - _rows;
-    int inside = offset + vars.size() - outside;
-    QSqlQuery db(_database);
-    QString dataType = valueType2DataType(_columnDefinitionsByName[nme].datadef().domain()->valueType());
-    bool needQuotes = dataType == "TEXT";
-    qint32 count = 0;
-    if ( inside > 0) {
-        QString stmt = QString("UPDATE %1 SET " ).arg(internalName());
-        for(count=0; count < vars.size(); ++count) {
-            QString rest;
-            if ( needQuotes )
-                rest += QString(" %1='%2' ").arg( _columnDefinitionsByIndex[index].name()).arg(vars[count].toString());
-            else
-                rest += QString(" %1=%2 ").arg( _columnDefinitionsByIndex[index].name()).arg(vars[count].toString());
-            QString query = stmt + rest + QString(" where record_index=%1").arg(offset + count);
-            if ( !db.exec(query)){
-                kernel()->issues()->logSql(db.lastError());
-                return ;
-            }
+    QVariantList updateValues, updateRecords, insertValues, insertRecords;
+    for(quint32 count=0; count < vars.size(); ++count) {
+        quint32 rec = offset + count;
+        if ( rec < _rows) {
+            updateValues << vars[count];
+            updateRecords << rec;
+        } else {
+            insertValues << vars[count];
+            insertRecords << rec;
         }
-
     }
-    if ( outside > 0) {
-        QString stmt = QString("INSERT INTO %1 " ).arg(internalName());
-        for(count=0; count < vars.size(); ++count) {
-            QString rest;
-            if ( needQuotes )
-                rest += QString("(%1,record_index) VALUES('%2', %3)").arg( _columnDefinitionsByIndex[index].name()).
-                        arg(vars[count].toString()).
-                        arg(_rows + count);
-            else
-                rest += QString("(%1,record_index) VALUES(%2, %3)").arg( _columnDefinitionsByIndex[index].name()).
-                        arg(vars[count].toString()).
-                        arg(_rows + count);
-
-            QString query = stmt + rest;
-            if ( !db.exec(query)){
-                kernel()->issues()->logSql(db.lastError());
-                return ;
-            }
+    // all records are written in one transaction with one prepared statement per kind of write
+    beginBatch();
+    if ( updateValues.size() > 0) {
+        QSqlQuery& db = statement(QString("UPDATE %1 SET %2=? where record_index=?").arg(internalName(), nme));
+        db.bindValue(0, updateValues);
+        db.bindValue(1, updateRecords);
+        if ( !db.execBatch()){
+            kernel()->issues()->logSql(db.lastError());
+            endBatch();
+            return false;
         }
+    }
+    if ( insertValues.size() > 0) {
+        QSqlQuery& db = statement(QString("INSERT INTO %1 (%2,record_index) VALUES(?,?)").arg(internalName(), nme));
+        db.bindValue(0, insertValues);
+        db.bindValue(1, insertRecords);
+        if ( !db.execBatch()){
+            kernel()->issues()->logSql(db.lastError());
+            endBatch();
+            return false;
+        }
+    }
+    if ( !endBatch())
+        return false;
+    _rows = std::max(_rows, offset + (quint32)vars.size());
+    return true;
+}
 
+bool DatabaseTable::beginBatch()
+{
+    if ( _batchLevel++ > 0)
+        return true;
+    if (!_database.transaction()) {
+        kernel()->issues()->logSql(_database.lastError());
+        return false;
     }
-    _rows = _rows + std::max(0,outside);
+    return true;
+}
+
+bool DatabaseTable::endBatch()
+{
+    if ( _batchLevel == 0)
+        return false;
+    if ( --_batchLevel > 0)
+        return true;
+    if (!_database.commit()) {
+        kernel()->issues()->logSql(_database.lastError());
+        _database.rollback();
+        return false;
+    }
+    return true;
+}
+
+QSqlQuery &DatabaseTable::statement(const QString &sql) const
+{
+    auto iter = _statements.find(sql);
+    if ( iter == _statements.end()) {
+        QSqlQuery query(_database);
+        query.setForwardOnly(true);
+        if (!query.prepare(sql))
+            kernel()->issues()->logSql(query.lastError());
+        iter = _statements.insert(sql, query);
+    }
+    return iter.value();
+}
 
+QString DatabaseTable::columnList(quint32 first, quint32 count, const QString& postfix) const
+{
+    QString names;
+    for(quint32 col = first; col < first + count; ++col) {
+        auto iter = _columnDefinitionsByIndex.find(col);
+        if ( iter == _columnDefinitionsByIndex.end())
+            continue;
+        if ( names != "")
+            names += ",";
+        names += iter.value().name() + postfix;
+    }
+    return names;
 }
 
 bool DatabaseTable::prepare()
@@ -1,6 +1,8 @@
 #ifndef DATABASETABLE_H
 #define DATABASETABLE_H
 
+#include <QSqlQuery>
+#include <QSqlError>
 #include "Kernel_global.h"
 
 namespace Ilwis {
@@ -43,21 +45,16 @@ public:
             return false;
         }
 
-        QString vt = valueType2DataType(dom->valueType());
-        QString stmt;
-
-        _columnDefinitionsByName[col] = ColumnDefinition(col,dom,_columns);
-        _columnDefinitionsByIndex = _columnDefinitionsByName[col];
-        _columns++;
-
-        if ( vt == "Text")
-            stmt = "Insert into %1 (%2) values('?')";
-        else
-            stmt = "Insert into %1 (%2) values(?)";
-        return executeStatement(stmt,col,values);
-
-        return true;
-
+        // a new table has nothing to load yet (and can't be loaded before it has a column)
+        if ( (_columns > 0 || _rows > 0) && !initLoad())
+            return false;
+        // the column is added to the sql table; records that exist get their value through an update, only the ones beyond are inserted
+        if (!addColumn(col, dom))
+            return false;
+        std::vector<QVariant> vars(values.size());
+        for(int i=0 ; i<values.size(); ++i)
+            vars[i] = values[i];
+        return writeColumn(col, vars, 0);
     }
 
     template<class T> bool updateColumn(const QString& col, const QVector<T>& values){
@@ -68,17 +65,23 @@ public:
         IDomain dom = _columnDefinitionsByName[col].datadef().domain();
         if (!dom.isValid()) {
             kernel()->issues()->log(TR(ERR_INVALID_PROPERTY_IN_4).arg("domain", "table", "column",col));
-            return sUNDEF;
+            return false;
         }
-        IlwisTypes ty = dom->valueType();
-        QString query = "Update %1 set %2=" ;
-        if ( ty < 256)
-            query += "?";
-        else if ( ty == itSTRING) //TODO other value cases
-               query = "'?'";
-        return executeStatement(query,col, values);
+        return executeStatement("Update %1 set %2=? where record_index=?",col, values);
     }
 
+    /*!
+     starts a batch of writes. All writes until the matching endBatch() are done in one transaction, which is far faster than a transaction per
+     statement. Batches may be nested; only the outermost batch commits.
+     * \return false if the transaction could not be started
+     */
+    bool beginBatch();
+    /*!
+     ends a batch of writes (\se beginBatch). When the outermost batch ends the transaction is committed.
+     * \return false if the commit failed; the transaction is then rolled back
+     */
+    bool endBatch();
+
     /*!
     \se Ilwis::Table
      */
@@ -115,6 +118,8 @@ public:
 private:
     QSqlDatabase _database;
     bool _sqlCreateDone;
+    quint32 _batchLevel = 0;
+    mutable QHash<QString, QSqlQuery> _statements;
 
     QString valueType2DataType(IlwisTypes ty) {
         QString vType=sUNDEF;
@@ -135,27 +140,81 @@ private:
     }
 
     template<class T> bool executeStatement(const QString& stmt, const QString& col, const QVector<T>& values) {
-        QSqlQuery db(_database);
-        QString query = stmt.arg(internalName(), col);
-        db.prepare(query);
+        QSqlQuery& db = statement(stmt.arg(internalName(), col));
         QVariantList varlist;
+        QVariantList records;
         for(int i=0 ; i<values.size(); ++i){
             varlist << values[i];
+            records << i;
         }
-        db.addBindValue(varlist);
-        if (!db.execBatch()) {
+        db.bindValue(0, varlist);
+        db.bindValue(1, records);
+        beginBatch();
+        bool ok = db.execBatch();
+        if (!ok)
             kernel()->issues()->logSql(db.lastError());
-            return false;
-        }
-
-        return true;
+        return endBatch() && ok;
     }
 
+    bool writeColumn(const QString& nme, const std::vector<QVariant>& vars, quint32 offset);
+    QSqlQuery& statement(const QString& sql) const;
+    QString columnList(quint32 first, quint32 count, const QString &postfix="") const;
     quint32 numberOfExistingRecords();
     bool initLoad();
 
 };
 typedef IlwisData<DatabaseTable> IDBTable;
+
+/*!
+ Reads a column of a database table block by block into a typed buffer. The column is read with one forward only query; each call
+ of next() fetches the following block. Scanning a column this way avoids a query (and QVariant vector) per record or per column.
+ */
+template<typename T> class DatabaseColumnCursor {
+public:
+    /*!
+     * \param table the table to read from
+     * \param col the name of the column
+     * \param undefined the value used for NULL values in the column
+     * \param blockSize the number of records read per block
+     */
+    DatabaseColumnCursor(const DatabaseTable *table, const QString& col, const T& undefined, quint32 blockSize=4096) :
+        _query(table->database()),
+        _undefined(undefined),
+        _blockSize(blockSize),
+        _offset(0)
+    {
+        _query.setForwardOnly(true);
+        _values.reserve(blockSize);
+        if (!_query.exec(QString("Select %1 from %2 order by record_index").arg(col, table->internalName())))
+            kernel()->issues()->logSql(_query.lastError());
+    }
+
+    /*!
+     fetches the next block
+     * \return false if there are no more records
+     */
+    bool next() {
+        _offset += _values.size();
+        _values.clear();
+        if ( !_query.isActive())
+            return false;
+        while(_values.size() < _blockSize && _query.next()) {
+            QVariant var = _query.value(0);
+            _values.push_back(var.isNull() ? _undefined : var.value<T>());
+        }
+        return _values.size() > 0;
+    }
+
+    const std::vector<T>& values() const { return _values; }
+    quint32 offset() const { return _offset; }
+
+private:
+    QSqlQuery _query;
+    T _undefined;
+    quint32 _blockSize;
+    quint32 _offset;
+    std::vector<T> _values;
+};
 }
 
 
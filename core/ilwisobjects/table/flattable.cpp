@@ -22,18 +22,27 @@ FlatTable::FlatTable(const Resource& resource) : BaseTable(resource){
 
 FlatTable::~FlatTable()
 {
-    _datagrid.clear();
+    _columnStores.clear();
 }
 
 bool FlatTable::createTable()
 {
     if(!BaseTable::createTable())
         return false;
-    for(unsigned int i=0; i < _rows; ++i)
-        _datagrid.push_back(std::vector<QVariant>(_columnDefinitionsByIndex.size()));
+    for(SPColumnStore& store : _columnStores)
+        store->resize(_rows);
+    invalidateIndexes();
     return true;
 }
 
+void FlatTable::setRows(quint32 r)
+{
+    BaseTable::setRows(r);
+    for(SPColumnStore& store : _columnStores)
+        store->resize(_rows);
+    invalidateIndexes();
+}
+
 bool FlatTable::prepare()
 {
     return Table::prepare();
@@ -49,9 +58,11 @@ bool FlatTable::addColumn(const QString &name, const IDomain &domain)
     bool ok = BaseTable::addColumn(name, domain);
     if(!ok)
         return false;
-    for(std::vector<QVariant>& row : _datagrid) {
-        row.push_back(QVariant());
-    }
+    SPColumnStore store(ColumnStore::create(_columnDefinitionsByName[name]));
+    store->resize(_rows);
+    _columnStores.push_back(store);
+    Locker lock(_indexMutex);
+    _requestedIndexes.push_back(0);
     return true;
 
 }
@@ -61,13 +72,21 @@ bool FlatTable::addColumn(const ColumnDefinition &def)
     bool ok = BaseTable::addColumn(def);
     if(!ok)
         return false;
-    for(std::vector<QVariant>& row : _datagrid) {
-        row.push_back(QVariant());
-    }
+    SPColumnStore store(ColumnStore::create(def));
+    store->resize(_rows);
+    _columnStores.push_back(store);
+    Locker lock(_indexMutex);
+    _requestedIndexes.push_back(0);
     return true;
 }
 
-
+void FlatTable::newRecord()
+{
+    ++_rows;
+    for(SPColumnStore& store : _columnStores)
+        store->resize(_rows);
+    invalidateIndexes();
+}
 
 std::vector<QVariant> FlatTable::column(quint32 index) const {
     if (!const_cast<FlatTable *>(this)->initLoad())
@@ -76,9 +95,10 @@ std::vector<QVariant> FlatTable::column(quint32 index) const {
     if ( !isColumnIndexValid(index))
         return std::vector<QVariant>();
 
+    const ColumnStore *store = _columnStores[index].get();
     std::vector<QVariant> data(records());
     for(quint32 i=0; i < _rows; ++i) {
-        data[i] = _datagrid[i][index];
+        data[i] = store->value(i);
     }
     return data;
 }
@@ -108,16 +128,18 @@ void FlatTable::column(const QString &nme, const std::vector<QVariant> &vars, qu
     quint32 index = columnIndex(nme);
     if ( !isColumnIndexValid(index))
         return ;
+    if ( offset + vars.size() > _rows) {
+        _rows = offset + vars.size();
+        for(SPColumnStore& store : _columnStores)
+            store->resize(_rows);
+        invalidateIndexes();
+    }
+    ColumnStore *store = _columnStores[index].get();
     quint32 rec = offset;
     for(const QVariant& var : vars) {
-        if ( rec < _rows)
-            _datagrid[rec++][index] = var;
-        else {
-            _datagrid.push_back(std::vector<QVariant>(_columnDefinitionsByIndex.size()));
-            _datagrid[rec++][index] = var;
-            _rows = _datagrid.size();
-        }
+        store->setValue(rec++, var);
     }
+    invalidateIndex(index);
 
 }
 
@@ -127,11 +149,11 @@ std::vector<QVariant> FlatTable::record(quint32 rec) const
         return std::vector<QVariant>();
     std::vector<QVariant> data;
 
-    if ( rec < _rows && _datagrid.size() != 0) {
+    if ( rec < _rows && _columnStores.size() != 0) {
         data.resize(columns());
         int col = 0;
-        for(const QVariant& var : _datagrid[rec])
-            data[col++] = var;
+        for(const SPColumnStore& store : _columnStores)
+            data[col++] = store->value(rec);
     }else
         kernel()->issues()->log(TR(ERR_INVALID_RECORD_SIZE_IN).arg(name()),IssueObject::itWarning);
     return data;
@@ -142,16 +164,17 @@ void FlatTable::record(quint32 rec, const std::vector<QVariant>& vars, quint32 o
     if (!const_cast<FlatTable *>(this)->initLoad())
         return ;
     if ( rec >= _rows ) {
-        _datagrid.push_back(std::vector<QVariant>(_columnDefinitionsByIndex.size()));
-        _rows = _datagrid.size();
+        newRecord();
         rec = _rows - 1;
     }
 
     quint32 col = offset;
     int cols = std::min(vars.size() - offset, _columns);
     for(const QVariant& var : vars) {
-        if ( col < cols)
-            _datagrid[rec][col++] = var;
+        if ( col < cols) {
+            invalidateIndex(col);
+            _columnStores[col++]->setValue(rec, var);
+        }
     }
 
 }
@@ -172,7 +195,7 @@ QVariant FlatTable::cell(const quint32 index, quint32 rec) const
     if ( !isColumnIndexValid(index))
         return QVariant();
     if ( rec < _rows)
-        return _datagrid[rec][index];
+        return _columnStores[index]->value(rec);
     kernel()->issues()->log(TR(ERR_INVALID_RECORD_SIZE_IN).arg(name()),IssueObject::itWarning);
     return QVariant();
 }
@@ -183,8 +206,10 @@ void  FlatTable::cell(quint32 index, quint32 rec, const QVariant& var){
 
     if ( !isColumnIndexValid(index))
         return;
-    if ( rec < _rows)
-        _datagrid[rec][index] = var;
+    if ( rec < _rows) {
+        _columnStores[index]->setValue(rec, var);
+        invalidateIndex(index);
+    }
 }
 
 void FlatTable::cell(const QString &col, quint32 rec, const QVariant &var)
@@ -206,3 +231,72 @@ std::vector<quint32> FlatTable::select(const QString &conditions) const
 {
     return TableSelector::select(this, conditions);
 }
+
+const ColumnStore *FlatTable::columnStore(quint32 index) const
+{
+    if (!const_cast<FlatTable *>(this)->initLoad())
+        return 0;
+    if ( !isColumnIndexValid(index))
+        return 0;
+    return _columnStores[index].get();
+}
+
+bool FlatTable::createIndex(const QString &column, ColumnIndex::IndexType type)
+{
+    if (!const_cast<FlatTable *>(this)->initLoad())
+        return false;
+    quint32 index = columnIndex(column);
+    if ( !isColumnIndexValid(index)) {
+        ERROR2(ERR_ILLEGAL_VALUE_2,"Column", column);
+        return false;
+    }
+    Locker lock(_indexMutex);
+    _requestedIndexes.resize(_columnStores.size(), 0);
+    _requestedIndexes[index] |= type;
+    return true;
+}
+
+void FlatTable::dropIndex(const QString &column)
+{
+    quint32 index = columnIndex(column);
+    if ( !isColumnIndexValid(index))
+        return;
+    Locker lock(_indexMutex);
+    if ( index < _requestedIndexes.size())
+        _requestedIndexes[index] = 0;
+    if ( index < _indexes.size())
+        _indexes[index] = std::array<SPColumnIndex,2>();
+}
+
+SPColumnIndex FlatTable::index(quint32 index, ColumnIndex::IndexType type) const
+{
+    if ( !isColumnIndexValid(index))
+        return SPColumnIndex();
+    Locker lock(_indexMutex);
+    if ( index >= _requestedIndexes.size() || (_requestedIndexes[index] & type) == 0)
+        return SPColumnIndex();
+    _indexes.resize(_columnStores.size());
+    SPColumnIndex& colindex = _indexes[index][type == ColumnIndex::ciSORTED ? 0 : 1];
+    if ( !colindex) { // build lazily; the index was dropped (or never build) since the last change of the column
+        if ( type == ColumnIndex::ciSORTED)
+            colindex.reset(new SortedColumnIndex(_columnStores[index].get()));
+        else
+            colindex.reset(new HashColumnIndex(_columnStores[index].get()));
+    }
+    return colindex;
+}
+
+void FlatTable::invalidateIndex(quint32 index)
+{
+    Locker lock(_indexMutex);
+    if ( index >= _requestedIndexes.size() || _requestedIndexes[index] == 0)
+        return;
+    if ( index < _indexes.size())
+        _indexes[index] = std::array<SPColumnIndex,2>();
+}
+
+void FlatTable::invalidateIndexes()
+{
+    Locker lock(_indexMutex);
+    _indexes.clear();
+}
@@ -1,7 +1,16 @@
 #ifndef FLATTABLE_H
 #define FLATTABLE_H
 
+#include <array>
+#include "columnstore.h"
+#include "columnindex.h"
+
 namespace Ilwis {
+/*!
+ An in memory table. The data is organized per column; each column has its own storage with a native type determined by the domain of the column (\se ColumnStore).
+ The QVariant based Table interface is still fully supported but for scans over (large) columns the typed column views are far more efficient as they give
+ direct access to the stored values without copying.
+ */
 class KERNELSHARED_EXPORT FlatTable : public BaseTable
 {
 public:
@@ -14,6 +23,10 @@ public:
      */
     bool createTable();
     /*!
+    \se Ilwis::Table
+     */
+    void setRows(quint32 r);
+    /*!
     \se Ilwis::Table
      */
     std::vector<QVariant> record(quint32 n) const ;
@@ -61,15 +74,57 @@ public:
 
     IlwisTypes ilwisType() const;
 
+    /*!
+     returns the storage of a column. The storage type tells which native type the values of the column have
+     * \param index the index of the column
+     * \return the storage or 0 if the index is not valid
+     */
+    const ColumnStore *columnStore(quint32 index) const;
+    /*!
+     returns a zero copy view on the native values of a column. The type must match the storage of the column; double for numeric columns,
+     quint32 for item columns (raw values) and string columns (dictionary keys, \se StringColumnStore).
+     * \param index the index of the column
+     * \return a view on the values or an invalid view if the index or the type is not valid
+     */
+    template<typename T> ColumnView<T> columnView(quint32 index) const{
+        if (!const_cast<FlatTable *>(this)->initLoad())
+            return ColumnView<T>();
+        if ( !isColumnIndexValid(index))
+            return ColumnView<T>();
+        const TypedColumnStore<T> *store = dynamic_cast<const TypedColumnStore<T> *>(_columnStores[index].get());
+        if ( store == 0)
+            return ColumnView<T>();
+        return store->view();
+    }
+    /*!
+     creates an index on a column. The index is maintained by the table; when the column is changed the index is rebuild the next time it is needed.
+     Indexes are optional, they only speed up selections on large tables (\se TableSelector).
+     * \param column name of the column
+     * \param type ciSORTED for range and equality selections, ciHASH for equality selections and key lookups
+     * \return false if the column doesnt exist
+     */
+    bool createIndex(const QString& column, ColumnIndex::IndexType type);
+    void dropIndex(const QString& column);
+    /*!
+     returns an index on a column if it was created (\se createIndex)
+     * \param index the index of the column
+     * \param type the type of index
+     * \return the index or a null pointer if no such index was created for the column
+     */
+    SPColumnIndex index(quint32 index, ColumnIndex::IndexType type) const;
+
 protected:
     bool isColumnIndexValid(quint32 index) const{
-        bool ok =  index != iUNDEF && _datagrid.size() != 0 && index < _datagrid[0].size();
-        if ( ok)
-            return true;
-        else
-            return false;
+        return index < _columnStores.size();
     }
-    std::vector< std::vector<QVariant> > _datagrid;
+    void newRecord();
+    void invalidateIndex(quint32 index);
+    void invalidateIndexes();
+
+    std::vector<SPColumnStore> _columnStores;
+    std::vector<quint8> _requestedIndexes;
+    mutable std::vector<std::array<SPColumnIndex,2>> _indexes;
+    mutable std::mutex _indexMutex;
 
 
 };
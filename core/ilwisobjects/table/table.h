@@ -129,6 +129,7 @@ protected:
 };
 typedef IlwisData<Table> ITable;
 }
+Q_DECLARE_METATYPE(Ilwis::ITable)
 
 // special columns
 #define COVERAGEKEYCOLUMN "coverage_key"
@@ -1,7 +1,11 @@
+#include <algorithm>
 #include "kernel.h"
 #include "ilwisdata.h"
 #include "domain.h"
 #include "range.h"
+#include "numericrange.h"
+#include "domainitem.h"
+#include "itemrange.h"
 #include "datadefinition.h"
 #include "columndefinition.h"
 #include "connectorinterface.h"
@@ -14,29 +18,125 @@ TableMerger::TableMerger()
 {
 }
 
-ITable TableMerger::mergeTables(const ITable& tbl1, const ITable& tbl2, int options) {
+bool TableMerger::mergeMetadataTables(ITable &tblOut, const ITable &tbl1, const ITable &tbl2, int options)
+{
+    if ( !tblOut.isValid())
+        return false;
+
+    _columns1.clear();
+    _columns2.clear();
+    quint32 columns1 = tbl1.isValid() ? tbl1->columns() : 0;
+    quint32 columns2 = tbl2.isValid() ? tbl2->columns() : 0;
     std::vector<ColumnDefinition> newdefs;
-    for(int c1 = 0; c1 < tbl1->columns(); ++c1) {
-        auto coldef1 = tbl1->columndefinition(c1);
-        for(int c2 = 0; c2 < tbl2->columns(); ++c2) {
-            auto coldef2 = tbl2->columndefinition(c2);
-            ColumnDefinition defnew = mergeColumnDefinitions(coldef1, coldef2);
-            if ( defnew.isValid())
-                newdefs.push_back(defnew);
+    for(quint32 c1 = 0; c1 < columns1; ++c1) {
+        ColumnDefinition coldef1 = tbl1->columndefinition(c1);
+        newdefs.push_back(ColumnDefinition(coldef1.name(), coldef1.datadef().domain(), newdefs.size()));
+        newdefs.back().datadef() = coldef1.datadef();
+        _columns1.push_back(c1);
+    }
+    for(quint32 c2 = 0; c2 < columns2; ++c2) {
+        ColumnDefinition coldef2 = tbl2->columndefinition(c2);
+        quint32 shared = iUNDEF;
+        for(quint32 c1 = 0; c1 < columns1 && shared == (quint32)iUNDEF; ++c1) {
+            if ( newdefs[c1].name() != coldef2.name())
+                continue;
+            if ( (options & moSEPARATECOLUMNS) && !isKeyColumn(coldef2.name()))
+                continue;
+            ColumnDefinition defnew = mergeColumnDefinitions(newdefs[c1], coldef2, c1);
+            if ( defnew.isValid()) {
+                newdefs[c1] = defnew;
+                shared = c1;
+            }
+        }
+        if ( shared == (quint32)iUNDEF) {
+            QString name = coldef2.name();
+            for(int suffix = 2; std::any_of(newdefs.begin(), newdefs.end(), [&](const ColumnDefinition& def){ return def.name() == name;}); ++suffix)
+                name = QString("%1_%2").arg(coldef2.name()).arg(suffix);
+            shared = newdefs.size();
+            newdefs.push_back(ColumnDefinition(name, coldef2.datadef().domain(), shared));
+            newdefs.back().datadef() = coldef2.datadef();
         }
+        _columns2.push_back(shared);
     }
-    return ITable();
+    for(const ColumnDefinition& def : newdefs)
+        tblOut->addColumn(def);
+    _columnCount = newdefs.size();
+
+    return true;
 }
 
-ColumnDefinition TableMerger::mergeColumnDefinitions(const ColumnDefinition &def1, const ColumnDefinition &def2) {
-    if (def1.datadef().domain() == def2.datadef().domain()) {
-        SPRange newRange = mergeRanges(def1.datadef().range(), def2.datadef().range());
+std::vector<QVariant> TableMerger::mergeRecords(const std::vector<QVariant> &rec1, const std::vector<QVariant> &rec2) const
+{
+    std::vector<QVariant> rec(_columnCount);
+    for(quint32 c = 0; c < rec1.size() && c < _columns1.size(); ++c)
+        rec[_columns1[c]] = rec1[c];
+    for(quint32 c = 0; c < rec2.size() && c < _columns2.size(); ++c) {
+        QVariant& target = rec[_columns2[c]];
+        bool ok;
+        double v = target.toDouble(&ok);
+        if ( !target.isValid() || (ok && isNumericalUndef(v)))
+            target = rec2[c];
     }
-    return ColumnDefinition();
+    return rec;
 }
 
-SPRange TableMerger::mergeRanges(const SPRange& rang1, const SPRange& rang2) {
+ITable TableMerger::mergeTables(const ITable& tbl1, const ITable& tbl2, int options) {
+    QString name = (tbl1.isValid() ? tbl1->name() : sUNDEF) + "_" + (tbl2.isValid() ? tbl2->name() : sUNDEF);
+    Resource resource(QUrl("ilwis://internal/" + name), itFLATTABLE);
+    ITable tblOut;
+    if ( !tblOut.prepare(resource))
+        return ITable();
 
+    TableMerger merger;
+    if (!merger.mergeMetadataTables(tblOut, tbl1, tbl2, options))
+        return ITable();
+    if ( options & moAPPENDRECORDS) {
+        quint32 records1 = tbl1.isValid() ? tbl1->records() : 0;
+        quint32 records2 = tbl2.isValid() ? tbl2->records() : 0;
+        for(quint32 rec = 0; rec < records1; ++rec)
+            tblOut->record(NEW_RECORD, merger.mergeRecords(tbl1->record(rec), {}));
+        for(quint32 rec = 0; rec < records2; ++rec)
+            tblOut->record(NEW_RECORD, merger.mergeRecords({}, tbl2->record(rec)));
+    }
+    return tblOut;
 }
 
+ColumnDefinition TableMerger::mergeColumnDefinitions(const ColumnDefinition &def1, const ColumnDefinition &def2, quint32 index) {
+    if (def1.datadef().domain() != def2.datadef().domain())
+        return ColumnDefinition();
 
+    ColumnDefinition defnew(def1.name(), def1.datadef().domain(), index);
+    SPRange newRange = mergeRanges(def1.datadef().range(), def2.datadef().range());
+    if ( !newRange.isNull())
+        defnew.datadef().range(newRange->clone());
+    return defnew;
+}
+
+SPRange TableMerger::mergeRanges(const SPRange& rang1, const SPRange& rang2) {
+    if ( rang1.isNull() || rang2.isNull())
+        return rang1.isNull() ? rang2 : rang1;
+
+    SPNumericRange numrange1 = rang1.dynamicCast<NumericRange>();
+    SPNumericRange numrange2 = rang2.dynamicCast<NumericRange>();
+    if ( !numrange1.isNull() && !numrange2.isNull()) {
+        if ( !numrange1->isValid())
+            return rang2;
+        if ( !numrange2->isValid())
+            return rang1;
+        return SPRange(NumericRange::merge(numrange1, numrange2));
+    }
+
+    SPItemRange itemrange1 = rang1.dynamicCast<ItemRange>();
+    SPItemRange itemrange2 = rang2.dynamicCast<ItemRange>();
+    if ( !itemrange1.isNull() && !itemrange2.isNull()) {
+        ItemRange *newRange = static_cast<ItemRange *>(itemrange1->clone());
+        newRange->addRange(*itemrange2);
+        return SPRange(newRange);
+    }
+    return rang1;
+}
+
+bool TableMerger::isKeyColumn(const QString &name)
+{
+    return name == FEATUREIDCOLUMN || name == COVERAGEKEYCOLUMN;
+}
@@ -2,14 +2,47 @@
 #define TABLEMERGER_H
 
 namespace Ilwis {
-class TableMerger
+/*!
+ Combines the columns of two tables into one set of columns and maps the records of both tables on it. Columns with the same name and domain
+ become one column with the union of their ranges; other columns of the second table are added, with a suffix if their name is already taken.
+ The key columns (feature id, coverage key) are always shared, so the merged table can be the attribute table of a coverage that has the
+ features of both coverages.
+ */
+class KERNELSHARED_EXPORT TableMerger
 {
 public:
+    enum MergeOptions{
+        moMERGECOLUMNS=0, // columns with the same name and domain are shared
+        moSEPARATECOLUMNS=1, // every column of both tables gets its own column, except the key columns
+        moAPPENDRECORDS=2 // mergeTables copies the records of the first and then of the second table
+    };
+
     TableMerger();
-    static ITable mergeTables(const ITable &tbl1, const ITable &tbl2, int options);
+    /*!
+     adds the merged columns of two tables to a table without columns. The mapping of the columns is kept for mergeRecords
+     * \param tblOut receives the columns
+     * \param tbl1 first table; may be invalid, it then has no columns
+     * \param tbl2 second table; may be invalid
+     * \param options combination of MergeOptions
+     * \return false if tblOut is invalid
+     */
+    bool mergeMetadataTables(ITable &tblOut, const ITable &tbl1, const ITable &tbl2, int options=moMERGECOLUMNS);
+    /*!
+     combines a record of each table in a record of the merged table. In shared columns the value of the first record is used unless it is undefined.
+     * \param rec1 record of the first table or an empty vector
+     * \param rec2 record of the second table or an empty vector
+     * \return the record with the columns of the merged table
+     */
+    std::vector<QVariant> mergeRecords(const std::vector<QVariant>& rec1, const std::vector<QVariant>& rec2) const;
+    static ITable mergeTables(const ITable &tbl1, const ITable &tbl2, int options=moMERGECOLUMNS | moAPPENDRECORDS);
 private:
-    static ColumnDefinition mergeColumnDefinitions(const Ilwis::ColumnDefinition &def1, const Ilwis::ColumnDefinition &def2);
+    std::vector<quint32> _columns1; // per column of the first table its column in the merged table
+    std::vector<quint32> _columns2;
+    quint32 _columnCount = 0;
+
+    static ColumnDefinition mergeColumnDefinitions(const Ilwis::ColumnDefinition &def1, const Ilwis::ColumnDefinition &def2, quint32 index);
     static SPRange mergeRanges(const SPRange &rang1, const SPRange &rang2);
+    static bool isKeyColumn(const QString& name);
 };
 }
 
@@ -1,9 +1,12 @@
+#include <algorithm>
+#include <cmath>
 #include "kernel.h"
 #include "ilwisdata.h"
 #include "domain.h"
 #include "domainitem.h"
 #include "itemdomain.h"
 #include "range.h"
+#include "itemrange.h"
 #include "datadefinition.h"
 #include "columndefinition.h"
 #include "logicalexpressionparser.h"
@@ -14,6 +17,44 @@
 
 using namespace Ilwis;
 
+namespace {
+/*!
+ evaluates a predicate on a typed column, 64 records per bitmap word. The predicate is choosen before the scan so the inner loop
+ contains no switches or conversions
+ */
+template<typename T, typename Pred> void evaluate(const ColumnView<T>& values, Pred pred, SelectionBitmap& bits) {
+    quint32 n = std::min(values.size(), bits.size());
+    for(quint32 w = 0; w < bits.words(); ++w) {
+        quint32 first = w * 64;
+        quint32 last = std::min(first + 64, n);
+        quint64 word = 0;
+        for(quint32 rec = first; rec < last; ++rec)
+            word |= (quint64)pred(values[rec]) << (rec - first);
+        bits.word(w) = word;
+    }
+}
+
+template<typename T> bool evaluateNumeric(const ColumnView<T>& values, const T& undef, LogicalOperator condition, double val2, SelectionBitmap& bits) {
+    switch(condition){
+    case loEQ:
+        evaluate(values, [&](const T& v){ return v != undef && v == val2;}, bits); break;
+    case loNEQ:
+        evaluate(values, [&](const T& v){ return v != undef && v != val2;}, bits); break;
+    case loLESS:
+        evaluate(values, [&](const T& v){ return v != undef && v < val2;}, bits); break;
+    case loLESSEQ:
+        evaluate(values, [&](const T& v){ return v != undef && v <= val2;}, bits); break;
+    case loGREATER:
+        evaluate(values, [&](const T& v){ return v != undef && v > val2;}, bits); break;
+    case loGREATEREQ:
+        evaluate(values, [&](const T& v){ return v != undef && v >= val2;}, bits); break;
+    default:
+        return false;
+    }
+    return true;
+}
+}
+
 TableSelector::TableSelector()
 {
 }
@@ -24,162 +65,162 @@ std::vector<quint32> TableSelector::select(const Table* table, const QString &co
     if ( !parser.isValid()) {
         return std::vector<quint32>();
     }
-    std::vector<bool> status(table->records(),false);
+    const FlatTable *flattable = dynamic_cast<const FlatTable *>(table);
+    SelectionBitmap status(table->records());
     for(auto part : parser.parts()) {
-        std::vector<QVariant> data = table->column(part.field());
-        if (data.size() == 0) {
+        quint32 colIndex = table->columnIndex(part.field());
+        if ( colIndex == (quint32)iUNDEF) {
             ERROR2(ERR_ILLEGAL_VALUE_2,TR("expression"), conditions);
             return std::vector<quint32>();
         }
-        const ColumnDefinition& coldef = table->columndefinition(part.field());
-
-        auto iter = status.begin();
-        IlwisTypes vt = part.valueType();
-        for(const QVariant& var : data) {
-            if ( hasType(vt, itNUMBER))
-                numericCase(part, var.toDouble(), iter);
-            else if ( hasType(vt, itSTRING )){
-                stringCase(part, coldef, var, iter);
-            }
-
-            ++iter;
-        }
+        SelectionBitmap bits(table->records());
+        if ( flattable == 0 || !selectTyped(flattable, part, bits))
+            selectVariant(table, part, bits);
 
+        status.combine(bits, part.logicalConnector());
     }
-    std::vector<quint32> result;
-    for(int i=0; i < status.size(); ++i)
-        if(status[i])
-            result.push_back(i);
 
-    return result;
+    return status.indexes();
 }
-void TableSelector::stringCase(const LogicalExpressionPart& part, const ColumnDefinition& coldef, const QVariant& var, std::vector<bool>::iterator& iter) {
-    QString text = part.value();
-    QString fieldtxt = var.toString();
-    if ( coldef.datadef().domain()->valueType() == itTHEMATICITEM){
-        quint32 raw = var.toUInt();
-        INamedIdDomain domainid = coldef.datadef().domain().get<NamedIdDomain>();
-        SPDomainItem item = domainid->item(raw);
-        fieldtxt = item->name();
-    }
-    LogicalOperator lconnector =  part.logicalConnector();
-    switch(part.condition()){
-    case loEQ:{
-        switch(lconnector){
-        case loNONE:
-            *iter = fieldtxt == text;break;
-        case loOR:
-            *iter = *iter || fieldtxt == text;break;
-        case loAND:
-            *iter = *iter && fieldtxt == text;break;
-        default:
-            *iter = false;break;
-        }
-        break;
-    }
-    case loNEQ:{
-        switch(lconnector){
-        case loNONE:
-            *iter = fieldtxt != text;break;
-        case loOR:
-            *iter = *iter || fieldtxt != text;break;
-        case loAND:
-            *iter = *iter && fieldtxt != text;break;
-        default:
-            *iter = false;break;
-        }
-        break;
+
+bool TableSelector::selectTyped(const FlatTable *tbl, const LogicalExpressionPart &part, SelectionBitmap &bits)
+{
+    quint32 colIndex = tbl->columnIndex(part.field());
+    const ColumnStore *store = tbl->columnStore(colIndex);
+    if ( store == 0 || store->size() != bits.size())
+        return false;
+
+    IlwisTypes vt = part.valueType();
+    ColumnStore::StorageType st = store->storageType();
+    if ( hasType(vt, itNUMBER)) {
+        if ( st != ColumnStore::stNUMERIC && st != ColumnStore::stRAW)
+            return false;
+        bool ok;
+        double value = part.value().toDouble(&ok);
+        if ( !ok || value == rUNDEF) // nothing is selected
+            return true;
+        return selectNumeric(tbl, colIndex, part.condition(), value, bits);
     }
-    default:
-        *iter = false;
+    if ( hasType(vt, itSTRING)) {
+        quint32 key = iUNDEF;
+        if ( st == ColumnStore::stSTRING) {
+            key = static_cast<const StringColumnStore *>(store)->key(part.value());
+        } else if ( st == ColumnStore::stRAW) { // the string is the name of an item; it is resolved once to its raw value
+            IDomain dom = tbl->columndefinition(colIndex).datadef().domain();
+            SPItemRange rng = dom.isValid() ? dom->range<ItemRange>() : SPItemRange();
+            if ( rng.isNull())
+                return false;
+            SPDomainItem item = rng->item(part.value());
+            if ( !item.isNull())
+                key = item->raw();
+        } else
+            return false;
+        return selectKey(tbl, colIndex, part.condition(), key, bits);
     }
+    return false;
 }
 
-
-void TableSelector::numericCase(const LogicalExpressionPart& part, double val1, std::vector<bool>::iterator& iter) {
-    double val2 = part.value().toDouble();
-    LogicalOperator lconnector =  part.logicalConnector();
-    switch(part.condition()){
-    case loEQ:{
-        switch(lconnector){
-        case loNONE:
-            *iter = val1 == val2;break;
-        case loOR:
-            *iter = *iter || val1 == val2;break;
-        case loAND:
-            *iter = *iter && val1 == val2;break;
-        default:
-            *iter = false;break;
+bool TableSelector::selectNumeric(const FlatTable *tbl, quint32 colIndex, LogicalOperator condition, double value, SelectionBitmap &bits)
+{
+    if ( condition == loEQ) {
+        SPColumnIndex index = tbl->index(colIndex, ColumnIndex::ciHASH);
+        if ( index && value >= 0 && value == std::floor(value)) {
+            std::static_pointer_cast<HashColumnIndex>(index)->select((quint64)value, bits);
+            return true;
         }
-        break;
     }
-    case loNEQ:{
-        switch(lconnector){
-        case loNONE:
-            *iter = val1 != val2;break;
-        case loOR:
-            *iter = *iter || val1 != val2;break;
-        case loAND:
-            *iter = *iter && val1 != val2;break;
-        default:
-            *iter = false;break;
-        }
-        break;
+    if ( condition != loNEQ) {
+        SPColumnIndex index = tbl->index(colIndex, ColumnIndex::ciSORTED);
+        if ( index && std::static_pointer_cast<SortedColumnIndex>(index)->select(condition, value, bits))
+            return true;
     }
-    case loLESS:{
-        switch(lconnector){
-        case loNONE:
-            *iter = (val1 < val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loOR:
-            *iter = (*iter || val1 < val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loAND:
-            *iter = (*iter && val1 < val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        default:
-            *iter = false;break;
-        }
-        break;
+    const ColumnStore *store = tbl->columnStore(colIndex);
+    if ( store->storageType() == ColumnStore::stNUMERIC) {
+        const NumericColumnStore *numbers = static_cast<const NumericColumnStore *>(store);
+        return evaluateNumeric(numbers->view(), numbers->undefined(), condition, value, bits);
     }
-    case loLESSEQ:{
-        switch(lconnector){
-        case loNONE:
-            *iter = (val1 <= val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loOR:
-            *iter = (*iter || val1 <= val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loAND:
-            *iter = (*iter && val1 <= val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        default:
-            *iter = false;break;
-        }
+    const RawColumnStore *raws = static_cast<const RawColumnStore *>(store);
+    return evaluateNumeric(raws->view(), raws->undefined(), condition, value, bits);
+}
+
+bool TableSelector::selectKey(const FlatTable *tbl, quint32 colIndex, LogicalOperator condition, quint32 key, SelectionBitmap &bits)
+{
+    const TypedColumnStore<quint32> *store = static_cast<const TypedColumnStore<quint32> *>(tbl->columnStore(colIndex));
+    quint32 undef = store->undefined();
+    switch(condition){
+    case loEQ:{
+        if ( key == undef) // the value doesnt occur in the column
+            return true;
+        SPColumnIndex index = tbl->index(colIndex, ColumnIndex::ciHASH);
+        if ( index)
+            std::static_pointer_cast<HashColumnIndex>(index)->select(key, bits);
+        else
+            evaluate(store->view(), [&](quint32 v){ return v == key;}, bits);
         break;
     }
-    case loGREATEREQ:{
-        switch(lconnector){
-        case loNONE:
-            *iter = (val1 >= val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loOR:
-            *iter = (*iter || val1 >= val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loAND:
-            *iter = (*iter && val1 >= val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        default:
-            *iter = false;break;
-        }
-        break;
+    case loNEQ:
+        evaluate(store->view(), [&](quint32 v){ return v != undef && v != key;}, bits); break;
+    default:
+        break; // strings have no order; nothing is selected
     }
-    case loGREATER:{
-        switch(lconnector){
-        case loNONE:
-            *iter = (val1 > val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loOR:
-            *iter = (*iter || val1 > val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        case loAND:
-            *iter = (*iter && val1 > val2) && val1 !=rUNDEF && val2 != rUNDEF;break;
-        default:
-            *iter = false;break;
+    return true;
+}
+
+void TableSelector::selectVariant(const Table *tbl, const LogicalExpressionPart &part, SelectionBitmap &bits)
+{
+    std::vector<QVariant> data = tbl->column(part.field());
+    const ColumnDefinition& coldef = tbl->columndefinition(part.field());
+    IlwisTypes vt = part.valueType();
+    LogicalOperator condition = part.condition();
+    if ( hasType(vt, itNUMBER)) {
+        double val2 = part.value().toDouble();
+        for(quint32 rec = 0; rec < data.size(); ++rec)
+            bits.set(rec, numericCase(condition, data[rec].toDouble(), val2));
+    } else if ( hasType(vt, itSTRING)) {
+        QString text = part.value();
+        INamedIdDomain domainid;
+        if ( coldef.datadef().domain()->valueType() == itTHEMATICITEM)
+            domainid = coldef.datadef().domain().get<NamedIdDomain>();
+        for(quint32 rec = 0; rec < data.size(); ++rec) {
+            QString fieldtxt;
+            if ( domainid.isValid()) {
+                SPDomainItem item = domainid->item(data[rec].toUInt());
+                fieldtxt = item.isNull() ? sUNDEF : item->name();
+            } else
+                fieldtxt = data[rec].toString();
+            bits.set(rec, stringCase(condition, fieldtxt, text));
         }
-        break;
     }
+}
+
+bool TableSelector::stringCase(LogicalOperator condition, const QString& fieldtxt, const QString& text) {
+    switch(condition){
+    case loEQ:
+        return fieldtxt == text;
+    case loNEQ:
+        return fieldtxt != text;
     default:
-        *iter = false;break;
+        return false;
+    }
+}
 
+bool TableSelector::numericCase(LogicalOperator condition, double val1, double val2) {
+    if ( val1 == rUNDEF || val2 == rUNDEF)
+        return false;
+    switch(condition){
+    case loEQ:
+        return val1 == val2;
+    case loNEQ:
+        return val1 != val2;
+    case loLESS:
+        return val1 < val2;
+    case loLESSEQ:
+        return val1 <= val2;
+    case loGREATEREQ:
+        return val1 >= val2;
+    case loGREATER:
+        return val1 > val2;
+    default:
+        return false;
     }
 }
@@ -2,15 +2,24 @@
 #define TABLESELECTOR_H
 
 namespace Ilwis {
+/*!
+ Evaluates selection conditions on tables. Each part of a condition is compiled once; string values are resolved to the raw value of
+ an item or to the dictionary key of a string column before the scan. On the typed columns of a FlatTable the conditions are evaluated
+ 64 records at a time into a bitmap and, when present, the indexes of the table are used (\se FlatTable::createIndex). All other columns
+ use the (slower) QVariant based evaluation. Undefined values never satisfy a condition.
+ */
 class TableSelector
 {
     friend class FlatTable;
 
     TableSelector();
     static std::vector<quint32> select(const Table *tbl, const QString &conditions) ;
-    static void numericCase(const LogicalExpressionPart &part, double val1, std::vector<bool>::iterator &iter);
-    static void stringCase(const LogicalExpressionPart &part, const Ilwis::ColumnDefinition &coldef,
-                           const QVariant &val1, std::vector<bool>::iterator &iter);
+    static bool selectTyped(const FlatTable *tbl, const LogicalExpressionPart &part, SelectionBitmap& bits);
+    static bool selectNumeric(const FlatTable *tbl, quint32 colIndex, LogicalOperator condition, double value, SelectionBitmap& bits);
+    static bool selectKey(const FlatTable *tbl, quint32 colIndex, LogicalOperator condition, quint32 key, SelectionBitmap& bits);
+    static void selectVariant(const Table *tbl, const LogicalExpressionPart &part, SelectionBitmap& bits);
+    static bool numericCase(LogicalOperator condition, double val1, double val2);
+    static bool stringCase(LogicalOperator condition, const QString& fieldtxt, const QString &text);
 };
 }
 
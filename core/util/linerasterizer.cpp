@@ -1,15 +1,121 @@
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <QThread>
 #include "kernel.h"
 #include "ilwis.h"
 #include "geometries.h"
 #include "ilwisdata.h"
 #include "coordinatesystem.h"
+#include "coordinatetransformer.h"
 #include "georeference.h"
-#include "coordinatesystem.h"
+#include "polygon.h"
 #include "linerasterizer.h"
 
 using namespace Ilwis;
 
-LineRasterizer::LineRasterizer(const IGeoReference& grf, const ICoordinateSystem& csyIn) : _grf(grf), _csy(csyIn)
+namespace {
+struct Edge {
+    double _x0, _y0, _x1, _y1;
+    quint32 _index;
+
+    double ymin() const { return std::min(_y0, _y1); }
+    double ymax() const { return std::max(_y0, _y1); }
+};
+
+// tiles whose rows are touched by the vertical range ymin..ymax (in pixels)
+void tileRange(double ymin, double ymax, quint32 tiles, quint32 tileLines, quint32& first, quint32& last) {
+    first = (quint32)std::max(0.0, std::floor(ymin) / tileLines);
+    last = (quint32)std::max(0.0, std::min((double)tiles - 1, std::floor(ymax) / tileLines));
+}
+
+/*
+ writes the pixels of a segment that lie in rows y0..y1-1. The major axis is stepped per pixel, the other axis is sampled at the
+ center of each step. The steps of the major axis are limited to the rows of the tile first, so long segments are not walked completely
+ for each tile they cross.
+ */
+void walkSegment(const Edge& edge, qint32 y0, qint32 y1, qint32 xsize, const LineRasterizer::SpanWriter& writer) {
+    double dx = edge._x1 - edge._x0, dy = edge._y1 - edge._y0;
+    double xmin = std::min(edge._x0, edge._x1), xmax = std::max(edge._x0, edge._x1);
+    double ymin = edge.ymin(), ymax = edge.ymax();
+    if ( std::abs(dx) >= std::abs(dy)) {
+        qint32 first = (qint32)std::floor(xmin), last = (qint32)std::floor(xmax);
+        if ( dy != 0) { // y is monotonic in x, only the columns that map to the rows of the tile (and a one column margin) are visited
+            double xa = edge._x0 + (y0 - edge._y0) * dx / dy, xb = edge._x0 + (y1 - edge._y0) * dx / dy;
+            first = std::max(first, (qint32)std::floor(std::min(xa, xb)) - 1);
+            last = std::min(last, (qint32)std::floor(std::max(xa, xb)) + 1);
+        }
+        first = std::max(first, 0);
+        last = std::min(last, xsize - 1);
+        qint32 spanRow = iUNDEF, spanStart = 0, spanEnd = 0;
+        for(qint32 x = first; x <= last; ++x) {
+            double xc = std::max(xmin, std::min(xmax, x + 0.5));
+            qint32 y = (qint32)std::floor(dx == 0 ? edge._y0 : edge._y0 + (xc - edge._x0) * dy / dx);
+            if ( y < y0 || y >= y1)
+                continue;
+            if ( y == spanRow && x == spanEnd + 1) {
+                spanEnd = x;
+                continue;
+            }
+            if ( spanRow != iUNDEF)
+                writer(edge._index, spanRow, spanStart, spanEnd);
+            spanRow = y;
+            spanStart = spanEnd = x;
+        }
+        if ( spanRow != iUNDEF)
+            writer(edge._index, spanRow, spanStart, spanEnd);
+    } else {
+        qint32 first = std::max((qint32)std::floor(ymin), y0), last = std::min((qint32)std::floor(ymax), y1 - 1);
+        for(qint32 y = first; y <= last; ++y) {
+            double yc = std::max(ymin, std::min(ymax, y + 0.5));
+            qint32 x = (qint32)std::floor(edge._x0 + (yc - edge._y0) * dx / dy);
+            if ( x >= 0 && x < xsize)
+                writer(edge._index, y, x, x);
+        }
+    }
+}
+
+// the last cell of the range lo..hi; a range that ends exactly on a cell boundary does not include the next cell
+qint32 lastCell(double lo, double hi) {
+    return hi > lo ? (qint32)std::ceil(hi) - 1 : (qint32)std::floor(lo);
+}
+
+/*
+ writes all pixels a segment passes through that lie in rows y0..y1-1. Per row the segment is clipped to the row and the columns between
+ its entry and exit point are one run.
+ */
+void walkTouched(const Edge& edge, qint32 y0, qint32 y1, qint32 xsize, const LineRasterizer::SpanWriter& writer) {
+    double dx = edge._x1 - edge._x0, dy = edge._y1 - edge._y0;
+    double ymin = edge.ymin(), ymax = edge.ymax();
+    qint32 first = std::max((qint32)std::floor(ymin), y0), last = std::min(lastCell(ymin, ymax), y1 - 1);
+    for(qint32 y = first; y <= last; ++y) {
+        double xa = edge._x0, xb = edge._x1;
+        if ( dy != 0) {
+            xa = edge._x0 + (std::max(ymin, (double)y) - edge._y0) * dx / dy;
+            xb = edge._x0 + (std::min(ymax, (double)y + 1) - edge._y0) * dx / dy;
+        }
+        qint32 x0 = std::max(0, (qint32)std::floor(std::min(xa, xb)));
+        qint32 x1 = std::min(xsize - 1, lastCell(std::min(xa, xb), std::max(xa, xb)));
+        if ( x0 <= x1)
+            writer(edge._index, y, x0, x1);
+    }
+}
+
+void addRing(const std::vector<Pixel_d>& pixels, quint32 first, quint32 count, quint32 index, bool horizontal, std::vector<Edge>& edges) {
+    for(quint32 i = 0; i < count; ++i) {
+        const Pixel_d& p1 = pixels[first + i];
+        const Pixel_d& p2 = pixels[first + (i + 1) % count];
+        if ( p1.y() != p2.y() || horizontal) // horizontal edges never cross a scanline, they are only needed for the touched pixels
+            edges.push_back({p1.x(), p1.y(), p2.x(), p2.y(), index});
+    }
+}
+}
+
+LineRasterizer::LineRasterizer(const IGeoReference& grf, const ICoordinateSystem& csyIn) :
+    _grf(grf),
+    _csy(csyIn),
+    _transformer(*CoordinateTransformer::transformer(csyIn, grf->coordinateSystem()))
 {
 }
 
@@ -18,9 +124,15 @@ std::vector<Pixel> LineRasterizer::rasterize(const Coordinate2d &start, const Co
     std::vector<Pixel> result;
     Coordinate2d c1 = start;
     Coordinate2d c2 = end;
-    if ( _grf->coordinateSystem() != _csy) {
-        c1 = _grf->coordinateSystem()->coord2coord(_csy, c1);
-        c2 = _grf->coordinateSystem()->coord2coord(_csy, c2);
+    if ( !_transformer.isIdentity()) {
+        std::vector<Coordinate> ends = {Coordinate(c1), Coordinate(c2)};
+        std::vector<Coordinate> converted;
+        if ( _transformer.transform(ends, converted)) {
+            c1 = Coordinate2d(converted[0].x(), converted[0].y());
+            c2 = Coordinate2d(converted[1].x(), converted[1].y());
+        } else {
+            c1 = c2 = Coordinate2d();
+        }
     }
     if ( !c1.isValid() || !c2.isValid()) {
         ERROR2(ERR_NO_INITIALIZED_2,"Coordinates", "Line rasterization");
@@ -85,6 +197,182 @@ std::vector<Pixel> LineRasterizer::rasterize(const Coordinate2d &start, const Co
     return result;
 }
 
+bool LineRasterizer::rasterize(const std::vector<Line2D<Coordinate2d> > &lines, const SpanWriter &writer, Mode mode, quint32 tileLines) const
+{
+    std::vector<Coordinate> crds;
+    for(const Line2D<Coordinate2d>& line : lines)
+        for(const Coordinate2d& crd : line)
+            crds.push_back(Coordinate(crd.x(), crd.y(), 0));
+    std::vector<Pixel_d> pixels;
+    if (!toPixels(crds, pixels))
+        return false;
+
+    std::vector<Edge> edges;
+    quint32 vertex = 0;
+    for(quint32 index = 0; index < lines.size(); ++index) {
+        quint32 count = lines[index].size();
+        for(quint32 i = 0; i < count; ++i) {
+            const Pixel_d& p1 = pixels[vertex + i];
+            const Pixel_d& p2 = pixels[vertex + std::min(i + 1, count - 1)]; // a line of one point is a segment of zero length
+            if ( (i + 1 < count || count == 1) && p1.isValid() && p2.isValid())
+                edges.push_back({p1.x(), p1.y(), p2.x(), p2.y(), index});
+        }
+        vertex += count;
+    }
+
+    qint32 xsize = _grf->size().xsize(), ysize = _grf->size().ysize();
+    tileLines = std::max(1U, tileLines);
+    quint32 tiles = (ysize + tileLines - 1) / tileLines;
+    std::vector<std::vector<quint32>> buckets(tiles);
+    for(quint32 e = 0; e < edges.size(); ++e) {
+        if ( edges[e].ymax() < 0 || edges[e].ymin() >= ysize)
+            continue;
+        quint32 first, last;
+        tileRange(edges[e].ymin(), edges[e].ymax(), tiles, tileLines, first, last);
+        for(quint32 t = first; t <= last; ++t)
+            buckets[t].push_back(e);
+    }
+    forTiles([&](quint32 tile, qint32 y0, qint32 y1) {
+        for(quint32 e : buckets[tile]) {
+            if ( mode == mALLTOUCHED)
+                walkTouched(edges[e], y0, y1, xsize, writer);
+            else
+                walkSegment(edges[e], y0, y1, xsize, writer);
+        }
+    }, tiles, tileLines);
+    return true;
+}
+
+bool LineRasterizer::fill(const std::vector<Polygon> &polygons, const SpanWriter &writer, Mode mode, quint32 tileLines) const
+{
+    std::vector<Coordinate> crds;
+    for(const Polygon& pol : polygons) {
+        for(const Coordinate2d& crd : pol.outer())
+            crds.push_back(Coordinate(crd.x(), crd.y(), 0));
+        for(const auto& ring : pol.inners())
+            for(const Coordinate2d& crd : ring)
+                crds.push_back(Coordinate(crd.x(), crd.y(), 0));
+    }
+    std::vector<Pixel_d> pixels;
+    if (!toPixels(crds, pixels))
+        return false;
+
+    // the edges of all rings of a polygon are stored consecutively; polygonEdges[i]..polygonEdges[i+1] are the edges of polygon i
+    std::vector<Edge> edges;
+    std::vector<quint32> polygonEdges(polygons.size() + 1, 0);
+    quint32 vertex = 0;
+    for(quint32 index = 0; index < polygons.size(); ++index) {
+        const Polygon& pol = polygons[index];
+        quint32 count = pol.outer().size();
+        for(const auto& ring : pol.inners())
+            count += ring.size();
+        bool valid = count > 0;
+        for(quint32 i = 0; i < count && valid; ++i)
+            valid = pixels[vertex + i].isValid();
+        if ( valid) {
+            quint32 first = vertex;
+            addRing(pixels, first, pol.outer().size(), index, mode == mALLTOUCHED, edges);
+            first += pol.outer().size();
+            for(const auto& ring : pol.inners()) {
+                addRing(pixels, first, ring.size(), index, mode == mALLTOUCHED, edges);
+                first += ring.size();
+            }
+        }
+        vertex += count;
+        polygonEdges[index + 1] = edges.size();
+    }
+
+    qint32 xsize = _grf->size().xsize(), ysize = _grf->size().ysize();
+    tileLines = std::max(1U, tileLines);
+    quint32 tiles = (ysize + tileLines - 1) / tileLines;
+    std::vector<std::vector<quint32>> buckets(tiles);
+    for(quint32 index = 0; index < polygons.size(); ++index) {
+        if ( polygonEdges[index] == polygonEdges[index + 1])
+            continue;
+        double ymin = edges[polygonEdges[index]].ymin(), ymax = edges[polygonEdges[index]].ymax();
+        for(quint32 e = polygonEdges[index]; e < polygonEdges[index + 1]; ++e) {
+            ymin = std::min(ymin, edges[e].ymin());
+            ymax = std::max(ymax, edges[e].ymax());
+        }
+        if ( ymax < 0 || ymin >= ysize)
+            continue;
+        quint32 first, last;
+        tileRange(ymin, ymax, tiles, tileLines, first, last);
+        for(quint32 t = first; t <= last; ++t)
+            buckets[t].push_back(index);
+    }
+    forTiles([&](quint32 tile, qint32 y0, qint32 y1) {
+        std::vector<const Edge *> active;
+        std::vector<double> crossings;
+        for(quint32 index : buckets[tile]) {
+            active.clear();
+            for(quint32 e = polygonEdges[index]; e < polygonEdges[index + 1]; ++e)
+                if ( edges[e].ymax() >= y0 && edges[e].ymin() < y1 + 1)
+                    active.push_back(&edges[e]);
+            for(qint32 y = y0; y < y1; ++y) {
+                // an edge crosses the scanline through the pixel centers when ymin <= yc < ymax; a vertex on the scanline is counted once
+                double yc = y + 0.5;
+                crossings.clear();
+                for(const Edge *edge : active) {
+                    if ( yc < edge->ymin() || yc >= edge->ymax())
+                        continue;
+                    crossings.push_back(edge->_x0 + (yc - edge->_y0) * (edge->_x1 - edge->_x0) / (edge->_y1 - edge->_y0));
+                }
+                std::sort(crossings.begin(), crossings.end());
+                for(quint32 i = 0; i + 1 < crossings.size(); i += 2) {
+                    qint32 x0 = std::max(0, (qint32)std::ceil(crossings[i] - 0.5));
+                    qint32 x1 = std::min(xsize - 1, (qint32)std::ceil(crossings[i + 1] - 0.5) - 1);
+                    if ( x0 <= x1)
+                        writer(index, y, x0, x1);
+                }
+            }
+            if ( mode == mALLTOUCHED) {
+                for(const Edge *edge : active)
+                    walkTouched(*edge, y0, y1, xsize, writer);
+            }
+        }
+    }, tiles, tileLines);
+    return true;
+}
+
+bool LineRasterizer::toPixels(const std::vector<Coordinate> &crds, std::vector<Pixel_d> &pixels) const
+{
+    if ( !_grf.isValid())
+        return ERROR2(ERR_NO_INITIALIZED_2,"Georeference", "Line rasterization");
+    std::vector<Coordinate> converted;
+    const std::vector<Coordinate> *source = &crds;
+    if ( !_transformer.isIdentity()) {
+        if (!_transformer.transform(crds, converted))
+            return ERROR2(ERR_NO_INITIALIZED_2,"Coordinates", "Line rasterization");
+        source = &converted;
+    }
+    pixels.resize(source->size());
+    for(quint32 i = 0; i < source->size(); ++i) {
+        const Coordinate& crd = (*source)[i];
+        pixels[i] = crd.isValid() ? _grf->coord2Pixel(crd) : Pixel_d();
+    }
+    return true;
+}
+
+void LineRasterizer::forTiles(const std::function<void (quint32, qint32, qint32)> &func, quint32 tiles, quint32 tileLines) const
+{
+    // tiles are handed out one at a time, so threads that get tiles with few geometries take more tiles
+    qint32 ysize = _grf->size().ysize();
+    std::atomic<quint32> next(0);
+    auto worker = [&]() -> bool {
+        for(quint32 tile = next++; tile < tiles; tile = next++)
+            func(tile, tile * tileLines, std::min(ysize, (qint32)((tile + 1) * tileLines)));
+        return true;
+    };
+    int threads = std::max(1, std::min((int)tiles, QThread::idealThreadCount()));
+    std::vector<std::future<bool>> futures(threads - 1);
+    for(int i = 0; i < threads - 1; ++i)
+        futures[i] = std::async(std::launch::async, worker);
+    worker();
+    for(int i = 0; i < threads - 1; ++i)
+        futures[i].get();
+}
+
 bool LineRasterizer::inBounds(const Pixel& cur, const QSize& size) const{
     return !( cur.x() < 0 || cur.y() < 0 || cur.x() >= size.width() || cur.y() >= size.height());
 }
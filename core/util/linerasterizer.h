@@ -1,19 +1,62 @@
 #ifndef LINERASTERIZER_H
 #define LINERASTERIZER_H
 
+#include <functional>
+#include "polygon.h"
+
 namespace Ilwis {
+/*!
+ Converts lines and polygons to the pixels of a georeference. Single segments can be converted to a list of pixels; whole sets of lines or
+ polygons are converted in one pass. For sets the vertices are transformed to the coordinate system of the georeference in one batch and the
+ result is written as horizontal runs of pixels through a callback. The rows of the georeference are divided into tiles of a fixed number of
+ lines; tiles are processed in parallel.
+ */
 class KERNELSHARED_EXPORT LineRasterizer
 {
 public:
+    /*!
+     receives the pixels x0..x1 (inclusive) on row y that belong to geometry 'index' of the set being rasterized. Calls for different tiles
+     can come from different threads at the same time; all calls for one tile come from the same thread.
+     */
+    typedef std::function<void(quint32 index, qint32 y, qint32 x0, qint32 x1)> SpanWriter;
+    /*!
+     which pixels belong to a geometry. mCENTER: the pixels whose center is inside a polygon, resp. one pixel per step along a line.
+     mALLTOUCHED: every pixel that is touched by the geometry, a line then also includes the pixels it only clips at a corner.
+     */
+    enum Mode{mCENTER, mALLTOUCHED};
+
     LineRasterizer(const IGeoReference &grf, const ICoordinateSystem &csyIn);
 
     std::vector<Pixel> rasterize(const Coordinate2d &start, const Coordinate2d &end) const;
+    /*!
+     converts a set of lines to pixels. Per segment the major axis is stepped pixel by pixel, the result is an 8-connected line.
+     A pixel that is shared by two consecutive segments may be reported twice.
+     * \param lines the lines in the coordinate system of the rasterizer
+     * \param writer receives the runs of pixels
+     * \param mode center or all touched pixels
+     * \param tileLines number of rows per tile
+     * \return false if the vertices could not be converted to pixels
+     */
+    bool rasterize(const std::vector<Line2D<Coordinate2d>>& lines, const SpanWriter& writer, Mode mode=mCENTER, quint32 tileLines=256) const;
+    /*!
+     fills a set of polygons by scanlines. A pixel belongs to a polygon when its center is inside the polygon (even-odd rule, so holes are
+     left open). In mALLTOUCHED mode the pixels touched by the boundary are added. Polygons whose vertices can not all be converted are skipped.
+     * \param polygons the polygons in the coordinate system of the rasterizer
+     * \param writer receives the runs of pixels
+     * \param mode center or all touched pixels
+     * \param tileLines number of rows per tile
+     * \return false if the vertices could not be converted to pixels
+     */
+    bool fill(const std::vector<Polygon>& polygons, const SpanWriter& writer, Mode mode=mCENTER, quint32 tileLines=256) const;
 
 private:
     IGeoReference _grf;
     ICoordinateSystem _csy;
+    CoordinateTransformer _transformer;
 
     bool inBounds(const Pixel& cur, const QSize &size) const;
+    bool toPixels(const std::vector<Coordinate>& crds, std::vector<Pixel_d>& pixels) const;
+    void forTiles(const std::function<void(quint32 tile, qint32 y0, qint32 y1)>& func, quint32 tiles, quint32 tileLines) const;
 };
 }
 
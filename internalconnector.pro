@@ -29,6 +29,9 @@ HEADERS += \
     internalconnector/internalprjmplfactory.h \
     internalconnector/projections/platecaree.h \
     internalconnector/projections/projectionimplementationinternal.h \
+    internalconnector/projections/transversemercator.h \
+    internalconnector/projections/utm.h \
+    internalconnector/projections/mercator.h \
     internalconnector/epsg.h
 
 win32:CONFIG(release, debug|release): LIBS += -L$$PWD/../libraries/$$PLATFORM$$CONF/core/ -lilwiscore
@@ -45,7 +48,10 @@ SOURCES += \
     internalconnector/internaltableconnector.cpp \
     internalconnector/internalprjimplfactory.cpp \
     internalconnector/projections/platecaree.cpp \
-    internalconnector/projections/projectionimplementationinternal.cpp
+    internalconnector/projections/projectionimplementationinternal.cpp \
+    internalconnector/projections/transversemercator.cpp \
+    internalconnector/projections/utm.cpp \
+    internalconnector/projections/mercator.cpp
 
 OTHER_FILES += \
     internalconnector/internalconnector.json
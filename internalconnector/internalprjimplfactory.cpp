@@ -18,6 +18,9 @@
 #include "ProjectionImplementation.h"
 #include "projections/projectionimplementationinternal.h"
 #include "projections/platecaree.h"
+#include "projections/transversemercator.h"
+#include "projections/utm.h"
+#include "projections/mercator.h"
 
 using namespace Ilwis;
 using namespace Internal;
@@ -31,6 +34,12 @@ ProjectionImplementation *ProjectionImplFactory::create(const Ilwis::Resource &r
 
     if ( prj == "PRJPC")
         return new PlateCaree(resource);
+    if ( prj == "PRJTM")
+        return new TransverseMercator(resource);
+    if ( prj == "PRJUTM")
+        return new UTM(resource);
+    if ( prj == "PRJMERC")
+        return new Mercator(resource);
 
     return 0;
 }
@@ -42,11 +51,7 @@ ProjectionImplementation *ProjectionImplFactory::create(const QString &) const
 
 bool ProjectionImplFactory::canUse(const Ilwis::Resource &resource) const
 {
-    QString prj = resource.code();
-    if ( prj == "PRJPC")
-        return true;
-
-    return false;
+    return PlateCaree::canUse(resource) || TransverseMercator::canUse(resource) || UTM::canUse(resource) || Mercator::canUse(resource);
 }
 
 bool ProjectionImplFactory::prepare()
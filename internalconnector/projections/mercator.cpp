@@ -0,0 +1,84 @@
+#include <QString>
+#include <functional>
+#include <cmath>
+
+#include "kernel.h"
+#include "ilwis.h"
+#include "angle.h"
+#include "point.h"
+#include "ilwisobject.h"
+#include "ilwisdata.h"
+#include "ellipsoid.h"
+#include "geodeticdatum.h"
+#include "projection.h"
+#include "ProjectionImplementation.h"
+#include "coordinatesystem.h"
+#include "conventionalcoordinatesystem.h"
+#include "projectionimplementationinternal.h"
+#include "mercator.h"
+
+using namespace Ilwis;
+using namespace Internal;
+
+Mercator::Mercator(const Ilwis::Resource &resource) : ProjectionImplementationInternal(resource.code()), _k0(1), _kA(0)
+{
+    init();
+}
+
+Mercator::~Mercator()
+{
+}
+
+void Mercator::init()
+{
+    ProjectionImplementationInternal::init();
+    double latts = parameter(Projection::pvLATTS).toDouble() * M_PI / 180.0;
+    if ( latts != 0) {
+        double sints = std::sin(latts);
+        _k0 = std::cos(latts) / std::sqrt(1 - _e * _e * sints * sints);
+    } else {
+        double k0 = parameter(Projection::pvK0).toDouble();
+        _k0 = k0 == 0 ? 1.0 : k0;
+    }
+    _kA = _k0 * _maxis;
+}
+
+bool Mercator::ll2crd(double phi, double lam, double &x, double &y) const
+{
+    if ( std::abs(phi) >= M_PI_2 - EPS10) // the poles are at infinity
+        return false;
+    x = _kA * lam;
+    y = _kA * std::asinh(tauPrime(std::tan(phi))); // the isometric latitude
+    return true;
+}
+
+bool Mercator::crd2ll(double x, double y, double &phi, double &lam) const
+{
+    if ( _kA == 0)
+        return false;
+    lam = x / _kA;
+    phi = std::atan(tauFromTauPrime(std::sinh(y / _kA)));
+    return true;
+}
+
+bool Mercator::checkParameters() const
+{
+    double latts = parameter(Projection::pvLATTS).toDouble();
+    if ( std::abs(latts) >= 90)
+        return ERROR2(ERR_ILLEGAL_VALUE_2, parameterName(Projection::pvLATTS), QString::number(latts));
+    double k0 = parameter(Projection::pvK0).toDouble();
+    if ( k0 < 0)
+        return ERROR2(ERR_ILLEGAL_VALUE_2, parameterName(Projection::pvK0), QString::number(k0));
+    return ProjectionImplementationInternal::checkParameters();
+}
+
+QString Mercator::proj4Parameters() const
+{
+    return QString("+proj=merc +lon_0=%1 +k=%2 +x_0=%3 +y_0=%4").arg(_centralMeridian * 180.0 / M_PI, 0, 'g', 12)
+            .arg(_k0, 0, 'g', 12).arg(_easting, 0, 'g', 12).arg(_northing, 0, 'g', 12);
+}
+
+bool Mercator::canUse(const Ilwis::Resource &resource)
+{
+    return resource.code() == "PRJMERC";
+}
@@ -0,0 +1,31 @@
+#ifndef MERCATOR_H
+#define MERCATOR_H
+
+namespace Ilwis {
+namespace Internal {
+/*!
+ Ellipsoidal (normal) mercator. The scale is taken from the latitude of true scale if it is given, else from the scale factor. On a
+ spherical ellipsoid with the major axis of WGS84 this is the "web mercator" of most tile services.
+ */
+class Mercator : public ProjectionImplementationInternal
+{
+public:
+    Mercator(const Ilwis::Resource &resource);
+    ~Mercator();
+    static bool canUse(const Ilwis::Resource &) ;
+
+protected:
+    bool ll2crd(double phi, double lam, double& x, double& y) const;
+    bool crd2ll(double x, double y, double& phi, double& lam) const;
+    void init();
+    bool checkParameters() const;
+    QString proj4Parameters() const;
+
+private:
+    double _k0;
+    double _kA; // scale factor times the major axis
+};
+}
+}
+
+#endif // MERCATOR_H
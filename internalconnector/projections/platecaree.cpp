@@ -1,5 +1,6 @@
 #include <QString>
 #include <functional>
+#include <cmath>
 
 #include "kernel.h"
 #include "ilwis.h"
@@ -19,24 +20,49 @@
 using namespace Ilwis;
 using namespace Internal;
 
-PlateCaree::PlateCaree(const Ilwis::Resource &resource)
+PlateCaree::PlateCaree(const Ilwis::Resource &resource) : ProjectionImplementationInternal(resource.code()), _scaleX(0)
 {
-
+    init();
 }
 
 PlateCaree::~PlateCaree()
 {
 }
 
-Coordinate PlateCaree::ll2crd(const LatLon &ll) const
+void PlateCaree::init()
+{
+    ProjectionImplementationInternal::init();
+    _scaleX = _maxis * std::cos(parameter(Projection::pvLATTS).toDouble() * M_PI / 180.0);
+}
+
+bool PlateCaree::ll2crd(double phi, double lam, double &x, double &y) const
+{
+    x = _scaleX * lam;
+    y = _maxis * phi;
+    return true;
+}
+
+bool PlateCaree::crd2ll(double x, double y, double &phi, double &lam) const
+{
+    if ( _scaleX == 0)
+        return false;
+    lam = x / _scaleX;
+    phi = y / _maxis;
+    return true;
+}
+
+bool PlateCaree::checkParameters() const
 {
-    return Coordinate(ll.lon(), ll.lat());
+    double latts = parameter(Projection::pvLATTS).toDouble();
+    if ( std::abs(latts) >= 90)
+        return ERROR2(ERR_ILLEGAL_VALUE_2, parameterName(Projection::pvLATTS), QString::number(latts));
+    return ProjectionImplementationInternal::checkParameters();
 }
 
-LatLon PlateCaree::crd2ll(const Coordinate &crd) const
+QString PlateCaree::proj4Parameters() const
 {
-    LatLon ll(crd.y() * 180.0 / M_PI, crd.x() * 180.0 / M_PI);
-    return ll;
+    return QString("+proj=eqc +lat_ts=%1 +lon_0=%2 +x_0=%3 +y_0=%4").arg(parameter(Projection::pvLATTS).toDouble())
+            .arg(_centralMeridian * 180.0 / M_PI, 0, 'g', 12).arg(_easting, 0, 'g', 12).arg(_northing, 0, 'g', 12);
 }
 
 bool PlateCaree::canUse(const Ilwis::Resource &resource)
@@ -50,8 +76,4 @@ bool PlateCaree::canUse(const Ilwis::Resource &resource)
     return false;
 }
 
-bool PlateCaree::prepare(const QString& parms){
-    return true;
-}
-
 
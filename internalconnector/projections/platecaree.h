@@ -8,10 +8,17 @@ class PlateCaree : public ProjectionImplementationInternal
 public:
     PlateCaree(const Ilwis::Resource &resource);
     ~PlateCaree();
-    Coordinate ll2crd(const LatLon&) const;
-    LatLon crd2ll(const Coordinate&) const;
     static bool canUse(const Ilwis::Resource &) ;
-    bool prepare(const QString &parms = "");
+
+protected:
+    bool ll2crd(double phi, double lam, double& x, double& y) const;
+    bool crd2ll(double x, double y, double& phi, double& lam) const;
+    void init();
+    bool checkParameters() const;
+    QString proj4Parameters() const;
+
+private:
+    double _scaleX; // major axis times the cosine of the latitude of true scale
 };
 }
 }
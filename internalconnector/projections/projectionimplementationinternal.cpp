@@ -1,5 +1,6 @@
 #include <QString>
 #include <functional>
+#include <cmath>
 
 #include "kernel.h"
 #include "ilwis.h"
@@ -18,70 +19,145 @@
 using namespace Ilwis;
 using namespace Internal;
 
-ProjectionImplementationInternal::ProjectionImplementationInternal() :
+namespace {
+double adjustLongitude(double lam) {
+    if ( lam < -M_PI || lam > M_PI)
+        lam -= 2 * M_PI * std::floor((lam + M_PI) / (2 * M_PI));
+    return lam;
+}
+}
+
+ProjectionImplementationInternal::ProjectionImplementationInternal(const QString &type) :
+    ProjectionImplementation(type),
     _easting(0),
     _northing(0),
     _maxis(6371007.180918499800),
+    _flattening(0),
+    _e(0),
     _centralMeridian(0)
 {
 }
 
 Coordinate ProjectionImplementationInternal::latlon2coord(const LatLon &ll) const
 {
-    if (_coordinateSystem->projection().isValid() && ll.isValid()) {
-        LatLon pl(ll);
-        if (pl.lat() > M_PI_2)
-            pl.setLat( M_PI_2);
-        else if (pl.lat() < -M_PI_2)
-            pl.setLat(-M_PI_2);
-        pl.setLon( pl.lon()-_centralMeridian);
-        Coordinate xy = ll2crd(pl);
-        if (xy != crdUNDEF)
-            return crdUNDEF;
-        Coordinate crd;
-        crd.x(xy.x() * _maxis  + _easting);
-        crd.y(xy.y() * _maxis  + _northing);
-        return crd;
-    }
-    else
+    if ( !ll.isValid())
         return crdUNDEF;
-
+    double phi = std::max(-M_PI_2, std::min(M_PI_2, ll.lat(Angle::uRADIANS)));
+    double x, y;
+    if (!ll2crd(phi, adjustLongitude(ll.lon(Angle::uRADIANS) - _centralMeridian), x, y))
+        return crdUNDEF;
+    return Coordinate(x + _easting, y + _northing);
 }
 
 LatLon ProjectionImplementationInternal::coord2latlon(const Coordinate &crdSource) const
 {
-    if (_coordinateSystem->projection().isValid() && crdSource != crdUNDEF) {
-        Coordinate xy((crdSource.x() - _easting) / _maxis, (crdSource.y() - _northing) / _maxis);
-
-        LatLon pl = crd2ll(xy);
-        if (!pl.isValid())
-            return llUNDEF;
-        if (abs(pl.lat()) > 90)
-            return llUNDEF;
-        pl.setLon( pl.lon() + _centralMeridian);
-        return pl;
-    }
-    else
+    if ( !crdSource.isValid())
         return llUNDEF;
+    double phi, lam;
+    if (!crd2ll(crdSource.x() - _easting, crdSource.y() - _northing, phi, lam) || std::abs(phi) > M_PI_2)
+        return llUNDEF;
+    return LatLon(Degrees(phi, false), Degrees(adjustLongitude(lam + _centralMeridian), false));
+}
 
+bool ProjectionImplementationInternal::latlon2coord(const std::vector<LatLon> &llSource, std::vector<Coordinate> &crdTarget) const
+{
+    crdTarget.resize(llSource.size());
+    double x, y;
+    for(quint32 i = 0; i < llSource.size(); ++i) {
+        const LatLon& ll = llSource[i];
+        if ( ll.isValid() && ll2crd(std::max(-M_PI_2, std::min(M_PI_2, ll.lat(Angle::uRADIANS))),
+                                    adjustLongitude(ll.lon(Angle::uRADIANS) - _centralMeridian), x, y))
+            crdTarget[i] = Coordinate(x + _easting, y + _northing);
+        else
+            crdTarget[i] = Coordinate();
+    }
+    return true;
+}
+
+bool ProjectionImplementationInternal::coord2latlon(const std::vector<Coordinate> &crdSource, std::vector<LatLon> &llTarget) const
+{
+    llTarget.resize(crdSource.size());
+    double phi, lam;
+    for(quint32 i = 0; i < crdSource.size(); ++i) {
+        const Coordinate& crd = crdSource[i];
+        if ( crd.isValid() && crd2ll(crd.x() - _easting, crd.y() - _northing, phi, lam) && std::abs(phi) <= M_PI_2)
+            llTarget[i] = LatLon(Degrees(phi, false), Degrees(adjustLongitude(lam + _centralMeridian), false));
+        else
+            llTarget[i] = LatLon();
+    }
+    return true;
 }
 
 void ProjectionImplementationInternal::setCoordinateSystem(ConventionalCoordinateSystem *csy)
 {
     ProjectionImplementation::setCoordinateSystem(csy);
-    IProjection prj = _coordinateSystem->projection();
-    if ( prj.isValid()) {
-        _easting = prj->parameter(Projection::pvX0).toDouble();
-        _northing = prj->parameter(Projection::pvY0).toDouble();
+    init();
+}
+
+void ProjectionImplementationInternal::setParameter(Projection::ProjectionParamValue type, const QVariant &value)
+{
+    ProjectionImplementation::setParameter(type, value);
+    init();
+}
+
+void ProjectionImplementationInternal::init()
+{
+    if ( _coordinateSystem && _coordinateSystem->ellipsoid().isValid()) {
         _maxis = _coordinateSystem->ellipsoid()->majorAxis();
-        _centralMeridian = prj->parameter(Projection::pvLON0).toDouble();
+        _flattening = _coordinateSystem->ellipsoid()->flattening();
+        _e = std::sqrt(2 * _flattening - _flattening * _flattening);
     }
+    _easting = parameter(Projection::pvX0).toDouble();
+    _northing = parameter(Projection::pvY0).toDouble();
+    _centralMeridian = parameter(Projection::pvLON0).toDouble() * M_PI / 180.0;
+}
 
+bool ProjectionImplementationInternal::prepare(const QString &)
+{
+    init();
+    return checkParameters();
+}
 
+bool ProjectionImplementationInternal::checkParameters() const
+{
+    if ( _maxis <= 0 || _flattening < 0 || _flattening >= 1)
+        return ERROR2(ERR_ILLEGAL_VALUE_2, "ellipsoid", QString("a=%1 f=%2").arg(_maxis).arg(_flattening));
+    return true;
+}
+
+QString ProjectionImplementationInternal::proj4Parameters() const
+{
+    return sUNDEF;
 }
 
 QString ProjectionImplementationInternal::toProj4() const
 {
-    return sUNDEF; // TODO
+    QString parms = proj4Parameters();
+    if ( parms == sUNDEF)
+        return sUNDEF;
+    QString ellipsoid = _flattening == 0 ? QString(" +a=%1 +b=%1").arg(_maxis, 0, 'g', 12)
+                                         : QString(" +a=%1 +rf=%2").arg(_maxis, 0, 'g', 12).arg(1.0 / _flattening, 0, 'g', 12);
+    return parms + ellipsoid + " +no_defs";
+}
+
+double ProjectionImplementationInternal::tauPrime(double tau) const
+{
+    // tangent of the conformal latitude from the tangent of the latitude (Karney, 2011)
+    double sig = std::sinh(_e * std::atanh(_e * tau / std::sqrt(1 + tau * tau)));
+    return tau * std::sqrt(1 + sig * sig) - sig * std::sqrt(1 + tau * tau);
+}
 
+double ProjectionImplementationInternal::tauFromTauPrime(double taup) const
+{
+    // inverse of tauPrime by Newton's method; converges in two or three steps
+    double e2m = 1 - _e * _e;
+    double tau = taup;
+    for(int i = 0; i < 5; ++i) {
+        double taupa = tauPrime(tau);
+        double dtau = (taup - taupa) * (1 + e2m * tau * tau) / (e2m * std::sqrt(1 + tau * tau) * std::sqrt(1 + taupa * taupa));
+        tau += dtau;
+        if ( std::abs(dtau) < 1e-14 * std::max(1.0, std::abs(tau)))
+            break;
+    }
+    return tau;
 }
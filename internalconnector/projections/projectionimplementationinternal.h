@@ -3,23 +3,61 @@
 
 namespace Ilwis {
 namespace Internal {
+/*!
+ Base class of the projections that are implemented natively instead of through proj4. The projections only implement the forward
+ and inverse formulas on plain doubles; the conversion from and to LatLon/Coordinate, the central meridian and the false easting
+ and northing are handled here. The batch versions loop over the points without any allocation per point.
+ The lat/lon side is on the ellipsoid of the coordinate system; there is no datum shift. Without a coordinate system the projection works
+ on the sphere with the authalic radius of WGS84, as the internal projections always did.
+ */
 class ProjectionImplementationInternal : public ProjectionImplementation
 {
 public:
-    ProjectionImplementationInternal();
+    ProjectionImplementationInternal(const QString& type=sUNDEF);
 
     Coordinate latlon2coord(const LatLon&) const;
     LatLon coord2latlon(const Coordinate&) const;
+    bool latlon2coord(const std::vector<LatLon>& llSource, std::vector<Coordinate>& crdTarget) const;
+    bool coord2latlon(const std::vector<Coordinate>& crdSource, std::vector<LatLon>& llTarget) const;
     void setCoordinateSystem(ConventionalCoordinateSystem *csy);
+    void setParameter(Projection::ProjectionParamValue type, const QVariant& value);
+    /*!
+     recomputes the constants of the projection and checks its parameters. The parameter string is not used; the parameters are set
+     through setParameter
+     * \return false if the ellipsoid or one of the parameters is out of range
+     */
+    bool prepare(const QString& parms="");
     QString toProj4() const;
 protected:
-    virtual Coordinate ll2crd(const LatLon&) const = 0;
-    virtual LatLon crd2ll(const Coordinate&) const = 0;
+    /*!
+     forward formula of the projection
+     * \param phi latitude in radians
+     * \param lam longitude in radians relative to the central meridian, in the range -pi..pi
+     * \param x,y receive the projected position in meters, without false easting and northing
+     * \return false if the position can not be projected
+     */
+    virtual bool ll2crd(double phi, double lam, double& x, double& y) const = 0;
+    virtual bool crd2ll(double x, double y, double& phi, double& lam) const = 0;
+    /*!
+     recomputes the constants of the projection from the parameters and the ellipsoid. Derived classes call this at the end of their
+     constructor; it is called again when a parameter or the coordinate system changes
+     */
+    virtual void init();
+    /*!
+     checks the parameters of the projection; called by prepare after init. Errors are logged
+     */
+    virtual bool checkParameters() const;
+    virtual QString proj4Parameters() const;
+
+    double tauPrime(double tau) const;
+    double tauFromTauPrime(double taup) const;
 
     double _easting;
     double _northing;
     double _maxis;
-    double _centralMeridian;
+    double _flattening;
+    double _e; // excentricity
+    double _centralMeridian; // radians
 };
 }
 }
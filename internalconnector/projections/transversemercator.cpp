@@ -0,0 +1,138 @@
+#include <QString>
+#include <functional>
+#include <cmath>
+
+#include "kernel.h"
+#include "ilwis.h"
+#include "angle.h"
+#include "point.h"
+#include "ilwisobject.h"
+#include "ilwisdata.h"
+#include "ellipsoid.h"
+#include "geodeticdatum.h"
+#include "projection.h"
+#include "ProjectionImplementation.h"
+#include "coordinatesystem.h"
+#include "conventionalcoordinatesystem.h"
+#include "projectionimplementationinternal.h"
+#include "transversemercator.h"
+
+using namespace Ilwis;
+using namespace Internal;
+
+TransverseMercator::TransverseMercator(const Ilwis::Resource &resource) : TransverseMercator(resource.code())
+{
+    init();
+}
+
+TransverseMercator::TransverseMercator(const QString &type) : ProjectionImplementationInternal(type), _k0(1), _kA(0), _y0(0)
+{
+}
+
+TransverseMercator::~TransverseMercator()
+{
+}
+
+void TransverseMercator::init()
+{
+    ProjectionImplementationInternal::init();
+    double k0 = parameter(Projection::pvK0).toDouble();
+    initSeries(k0 == 0 ? 1.0 : k0, parameter(Projection::pvLAT0).toDouble() * M_PI / 180.0);
+}
+
+void TransverseMercator::initSeries(double k0, double lat0)
+{
+    _k0 = k0;
+    double n = _flattening / (2 - _flattening);
+    double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+    _kA = _k0 * _maxis / (1 + n) * (1 + n2 / 4 + n4 / 64 + n6 / 256);
+
+    _alpha[0] = _beta[0] = 0;
+    _alpha[1] = n / 2 - 2 * n2 / 3 + 5 * n3 / 16 + 41 * n4 / 180 - 127 * n5 / 288 + 7891 * n6 / 37800;
+    _alpha[2] = 13 * n2 / 48 - 3 * n3 / 5 + 557 * n4 / 1440 + 281 * n5 / 630 - 1983433 * n6 / 1935360;
+    _alpha[3] = 61 * n3 / 240 - 103 * n4 / 140 + 15061 * n5 / 26880 + 167603 * n6 / 181440;
+    _alpha[4] = 49561 * n4 / 161280 - 179 * n5 / 168 + 6601661 * n6 / 7257600;
+    _alpha[5] = 34729 * n5 / 80640 - 3418889 * n6 / 1995840;
+    _alpha[6] = 212378941 * n6 / 319334400;
+
+    _beta[1] = n / 2 - 2 * n2 / 3 + 37 * n3 / 96 - n4 / 360 - 81 * n5 / 512 + 96199 * n6 / 604800;
+    _beta[2] = n2 / 48 + n3 / 15 - 437 * n4 / 1440 + 46 * n5 / 105 - 1118711 * n6 / 3870720;
+    _beta[3] = 17 * n3 / 480 - 37 * n4 / 840 - 209 * n5 / 4480 + 5569 * n6 / 90720;
+    _beta[4] = 4397 * n4 / 161280 - 11 * n5 / 504 - 830251 * n6 / 7257600;
+    _beta[5] = 4583 * n5 / 161280 - 108847 * n6 / 3991680;
+    _beta[6] = 20648693 * n6 / 638668800;
+
+    _y0 = 0;
+    double x;
+    ll2crd(lat0, 0, x, _y0);
+}
+
+bool TransverseMercator::ll2crd(double phi, double lam, double &x, double &y) const
+{
+    if ( std::abs(lam) >= M_PI_2)
+        return false;
+    double cl = std::cos(lam);
+    double xip, etap;
+    if ( std::abs(phi) >= M_PI_2) { // the poles map on the central meridian
+        xip = phi > 0 ? M_PI_2 : -M_PI_2;
+        etap = 0;
+    } else {
+        double taup = tauPrime(std::tan(phi));
+        xip = std::atan2(taup, cl);
+        etap = std::asinh(std::sin(lam) / std::sqrt(taup * taup + cl * cl));
+    }
+    double xi = xip, eta = etap;
+    for(int j = 1; j <= 6; ++j) {
+        xi += _alpha[j] * std::sin(2 * j * xip) * std::cosh(2 * j * etap);
+        eta += _alpha[j] * std::cos(2 * j * xip) * std::sinh(2 * j * etap);
+    }
+    x = _kA * eta;
+    y = _kA * xi - _y0;
+    return true;
+}
+
+bool TransverseMercator::crd2ll(double x, double y, double &phi, double &lam) const
+{
+    if ( _kA == 0)
+        return false;
+    double xi = (y + _y0) / _kA;
+    double eta = x / _kA;
+    double xip = xi, etap = eta;
+    for(int j = 1; j <= 6; ++j) {
+        xip -= _beta[j] * std::sin(2 * j * xi) * std::cosh(2 * j * eta);
+        etap -= _beta[j] * std::cos(2 * j * xi) * std::sinh(2 * j * eta);
+    }
+    double s = std::sinh(etap);
+    double c = std::cos(xip);
+    double r = std::sqrt(s * s + c * c);
+    if ( r == 0) { // pole
+        phi = xip > 0 ? M_PI_2 : -M_PI_2;
+        lam = 0;
+        return true;
+    }
+    lam = std::atan2(s, c);
+    phi = std::atan(tauFromTauPrime(std::sin(xip) / r));
+    return true;
+}
+
+bool TransverseMercator::checkParameters() const
+{
+    double k0 = parameter(Projection::pvK0).toDouble();
+    if ( k0 < 0)
+        return ERROR2(ERR_ILLEGAL_VALUE_2, parameterName(Projection::pvK0), QString::number(k0));
+    double lat0 = parameter(Projection::pvLAT0).toDouble();
+    if ( std::abs(lat0) > 90)
+        return ERROR2(ERR_ILLEGAL_VALUE_2, parameterName(Projection::pvLAT0), QString::number(lat0));
+    return ProjectionImplementationInternal::checkParameters();
+}
+
+QString TransverseMercator::proj4Parameters() const
+{
+    return QString("+proj=tmerc +lat_0=%1 +lon_0=%2 +k=%3 +x_0=%4 +y_0=%5").arg(parameter(Projection::pvLAT0).toDouble(), 0, 'g', 12)
+            .arg(_centralMeridian * 180.0 / M_PI, 0, 'g', 12).arg(_k0, 0, 'g', 12).arg(_easting, 0, 'g', 12).arg(_northing, 0, 'g', 12);
+}
+
+bool TransverseMercator::canUse(const Ilwis::Resource &resource)
+{
+    return resource.code() == "PRJTM";
+}
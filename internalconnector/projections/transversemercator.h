@@ -0,0 +1,38 @@
+#ifndef TRANSVERSEMERCATOR_H
+#define TRANSVERSEMERCATOR_H
+
+namespace Ilwis {
+namespace Internal {
+/*!
+ Ellipsoidal transverse mercator using the series of Krüger to the sixth order in the third flattening (as in C.F.F. Karney,
+ Transverse Mercator with an accuracy of a few nanometers, 2011). Within 4000 km of the central meridian the error is well below a
+ millimeter; points more than 90 degrees from the central meridian are undefined.
+ */
+class TransverseMercator : public ProjectionImplementationInternal
+{
+public:
+    TransverseMercator(const Ilwis::Resource &resource);
+    ~TransverseMercator();
+    static bool canUse(const Ilwis::Resource &) ;
+
+protected:
+    TransverseMercator(const QString& type); // for derived projections, which do their own init
+    bool ll2crd(double phi, double lam, double& x, double& y) const;
+    bool crd2ll(double x, double y, double& phi, double& lam) const;
+    void init();
+    bool checkParameters() const;
+    QString proj4Parameters() const;
+    void initSeries(double k0, double lat0);
+
+    double _k0;
+
+private:
+    double _alpha[7]; // index 0 is not used
+    double _beta[7];
+    double _kA; // scale factor times the rectifying radius
+    double _y0; // northing of the origin latitude on the central meridian
+};
+}
+}
+
+#endif // TRANSVERSEMERCATOR_H
@@ -0,0 +1,61 @@
+#include <QString>
+#include <functional>
+#include <cmath>
+
+#include "kernel.h"
+#include "ilwis.h"
+#include "angle.h"
+#include "point.h"
+#include "ilwisobject.h"
+#include "ilwisdata.h"
+#include "ellipsoid.h"
+#include "geodeticdatum.h"
+#include "projection.h"
+#include "ProjectionImplementation.h"
+#include "coordinatesystem.h"
+#include "conventionalcoordinatesystem.h"
+#include "projectionimplementationinternal.h"
+#include "transversemercator.h"
+#include "utm.h"
+
+using namespace Ilwis;
+using namespace Internal;
+
+UTM::UTM(const Ilwis::Resource &resource) : TransverseMercator(resource.code()), _zone(1), _south(false)
+{
+    init();
+}
+
+void UTM::init()
+{
+    ProjectionImplementationInternal::init();
+    bool ok;
+    int zone = parameter(Projection::pvZONE).toInt(&ok);
+    _zone = ok && zone >= 1 && zone <= 60 ? zone : 1;
+    QVariant north = parameter(Projection::pvNORTH);
+    _south = north.isValid() && (north.toString().toLower() == "no" || north.toString().toLower() == "false");
+    _centralMeridian = (-183.0 + 6.0 * _zone) * M_PI / 180.0;
+    _easting = 500000.0;
+    _northing = _south ? 10000000.0 : 0.0;
+    initSeries(0.9996, 0);
+}
+
+bool UTM::checkParameters() const
+{
+    // init falls back on zone 1 so the projection stays usable; prepare reports the bad zone
+    bool ok;
+    int zone = parameter(Projection::pvZONE).toInt(&ok);
+    if ( !ok || zone < 1 || zone > 60)
+        return ERROR2(ERR_ILLEGAL_VALUE_2, parameterName(Projection::pvZONE), parameter(Projection::pvZONE).toString());
+    return ProjectionImplementationInternal::checkParameters();
+}
+
+QString UTM::proj4Parameters() const
+{
+    return QString("+proj=utm +zone=%1%2").arg(_zone).arg(_south ? " +south" : "");
+}
+
+bool UTM::canUse(const Ilwis::Resource &resource)
+{
+    return resource.code() == "PRJUTM";
+}
@@ -0,0 +1,28 @@
+#ifndef UTM_H
+#define UTM_H
+
+namespace Ilwis {
+namespace Internal {
+/*!
+ Universal transverse mercator; a transverse mercator of which the central meridian, scale and false easting/northing follow from the zone
+ (parameter zone) and hemisphere (parameter north, "No" for the southern hemisphere).
+ */
+class UTM : public TransverseMercator
+{
+public:
+    UTM(const Ilwis::Resource &resource);
+    static bool canUse(const Ilwis::Resource &) ;
+
+protected:
+    void init();
+    bool checkParameters() const;
+    QString proj4Parameters() const;
+
+private:
+    int _zone;
+    bool _south;
+};
+}
+}
+
+#endif // UTM_H
@@ -1,5 +1,7 @@
 #include <QString>
 #include <functional>
+#include <cmath>
+#include <mutex>
 
 #include "kernel.h"
 #include "ilwis.h"
@@ -30,49 +32,109 @@ void ProjectionImplementationProj4::setParameter(Projection::ProjectionParamValu
     QString value = v.toString();
     switch(type) {
     case Projection::pvX0:
-        _targetDef += " +x_0=" + value;break;
+        addToDefinition(" +x_0=" + value);break;
     case Projection::pvY0:
-        _targetDef += " +y_0=" + value; break;
+        addToDefinition(" +y_0=" + value); break;
     case Projection::pvLON0:
-        _targetDef += " +lon_0=" + value; break;
+        addToDefinition(" +lon_0=" + value); break;
     case Projection::pvLAT0:
-        _targetDef += " +lat_0=" + value; break;
+        addToDefinition(" +lat_0=" + value); break;
     case Projection::pvLAT1:
-        _targetDef += " +lat_1=" + value; break;
+        addToDefinition(" +lat_1=" + value); break;
     case Projection::pvLAT2:
-        _targetDef += " +lat_2=" + value; break;
+        addToDefinition(" +lat_2=" + value); break;
     case Projection::pvLATTS:
-        _targetDef += " +lat_ts=" + value; break;
+        addToDefinition(" +lat_ts=" + value); break;
     case Projection::pvZONE:
-        _targetDef += " +zone=" + value; break;
+        addToDefinition(" +zone=" + value); break;
     case Projection::pvK0:
-        _targetDef += " +k0=" + value; break;
+        addToDefinition(" +k0=" + value); break;
     case Projection::pvELLCODE:
-        _targetDef += " " + value; break;
+        addToDefinition(" " + value); break;
     case Projection::pvNORTH:
-        _targetDef += value == "No" ? "+south" : ""; break;
+        addToDefinition(value == "No" ? " +south" : ""); break;
     default:
-        _targetDef += "";
+        break;
     }
-    if ( _pjBase)
-        pj_free(_pjBase);
-
-    _pjBase = pj_init_plus(_targetDef.toLatin1());
 }
 
-ProjectionImplementationProj4::ProjectionImplementationProj4(const Resource &resource)
+ProjectionImplementationProj4::ProjectionImplementationProj4(const Resource &resource) : _generation(0)
 {
     QString cd = resource.code();
     _outputIsLatLon = cd == "latlong" || cd == "longlat";
     _targetDef = QString("+proj=%1").arg(cd);
-    _pjLatlon =  pj_init_plus("+proj=latlong +ellps=WGS84");
-    _pjBase = pj_init_plus(_targetDef.toLatin1());
 }
 
 ProjectionImplementationProj4::~ProjectionImplementationProj4()
 {
-    pj_free(_pjLatlon);
-    pj_free(_pjBase);
+    for(Context *ctx : _contexts)
+        delete ctx;
+}
+
+void ProjectionImplementationProj4::addToDefinition(const QString &def)
+{
+    Locker lock(_mutex);
+    _targetDef += def;
+    ++_generation;
+}
+
+ProjectionImplementationProj4::Context::Context() : _ctx(pj_ctx_alloc()), _pjLatlon(0), _pjBase(0), _generation(iUNDEF)
+{
+}
+
+ProjectionImplementationProj4::Context::~Context()
+{
+    if ( _pjLatlon)
+        pj_free(_pjLatlon);
+    if ( _pjBase)
+        pj_free(_pjBase);
+    if ( _ctx)
+        pj_ctx_free(_ctx);
+}
+
+ProjectionImplementationProj4::Context *ProjectionImplementationProj4::acquireContext() const
+{
+    Context *ctx;
+    QString def;
+    quint32 generation;
+    {
+        Locker lock(_mutex);
+        if ( _freeContexts.size() > 0) {
+            ctx = _freeContexts.back();
+            _freeContexts.pop_back();
+        } else {
+            ctx = new Context();
+            _contexts.push_back(ctx);
+        }
+        if ( ctx->_generation == _generation)
+            return ctx;
+        def = _targetDef;
+        generation = _generation;
+    }
+    if ( ctx->_pjBase)
+        pj_free(ctx->_pjBase);
+    if ( !ctx->_pjLatlon)
+        ctx->_pjLatlon = pj_init_plus_ctx(ctx->_ctx, "+proj=latlong +ellps=WGS84");
+    ctx->_pjBase = pj_init_plus_ctx(ctx->_ctx, def.toLatin1());
+    ctx->_generation = generation;
+    return ctx;
+}
+
+void ProjectionImplementationProj4::releaseContext(Context *ctx) const
+{
+    Locker lock(_mutex);
+    _freeContexts.push_back(ctx);
+}
+
+ProjectionImplementationProj4::ContextLock::ContextLock(const ProjectionImplementationProj4 *projection) :
+    _projection(projection),
+    _ctx(projection->acquireContext())
+{
+}
+
+ProjectionImplementationProj4::ContextLock::~ContextLock()
+{
+    _projection->releaseContext(_ctx);
 }
 
 bool ProjectionImplementationProj4::prepare(const QString &parms)
@@ -93,41 +155,33 @@ bool ProjectionImplementationProj4::prepare(const QString &parms)
         };
         QString ellps = proj4["ellps"];
         if ( ellps != sUNDEF) {
-            _targetDef += " +ellps=" + ellps;
+            addToDefinition(" +ellps=" + ellps);
         }
         QString a = proj4["a"];
         if ( a != sUNDEF) {
-            _targetDef += " +a=" + a;
+            addToDefinition(" +a=" + a);
         }
         QString b = proj4["b"];
         if ( b != sUNDEF) {
-            _targetDef += " +b=" + b;
+            addToDefinition(" +b=" + b);
         }
         QString shifts = proj4["towgs84"];
         if ( shifts != sUNDEF) {
-            _targetDef += " +towgs84=" + shifts;
+            addToDefinition(" +towgs84=" + shifts);
         }
 
         for(auto iter= alias.begin(); iter != alias.end(); ++iter) {
             assign(iter->first);
         }
-        if ( _pjBase)
-            pj_free(_pjBase);
-
-        _pjBase = pj_init_plus(_targetDef.toLatin1());
         return true;
     }
     else if ( _coordinateSystem != 0) {
         if ( _coordinateSystem->ellipsoid().isValid()) {
-            _targetDef += " " + _coordinateSystem->ellipsoid()->code();
+            addToDefinition(" " + _coordinateSystem->ellipsoid()->code());
         }
         if ( _coordinateSystem->datum() && _coordinateSystem->datum()->isValid()) {
-            _targetDef += " " + _coordinateSystem->datum()->code();
+            addToDefinition(" " + _coordinateSystem->datum()->code());
         }
-        if ( _pjBase)
-            pj_free(_pjBase);
-
-        _pjBase = pj_init_plus(_targetDef.toLatin1());
         return true;
     }
     return ERROR1(ERR_NO_INITIALIZED_1,"Projection");
@@ -135,24 +189,19 @@ bool ProjectionImplementationProj4::prepare(const QString &parms)
 
 QString ProjectionImplementationProj4::toProj4() const
 {
+    Locker lock(_mutex);
     return _targetDef;
 }
 
 Coordinate ProjectionImplementationProj4::latlon2coord(const LatLon &ll) const
 {
-    if ( _pjBase == 0 || _pjLatlon == 0) {
-        int *err = pj_get_errno_ref();
-        if (err != 0){
-            QString error(pj_strerrno(*err));
-            error = "projection error:" + error;
-            kernel()->issues()->log(error);
-        }
+    ContextLock ctx(this);
+    if ( !isReady(ctx))
         return Coordinate();
-    }
 
     double x = ll.lon(Angle::uRADIANS);
     double y = ll.lat(Angle::uRADIANS);
-    int err = pj_transform(_pjLatlon, _pjBase, 1, 1, &x, &y, NULL );
+    int err = pj_transform(ctx->_pjLatlon, ctx->_pjBase, 1, 1, &x, &y, NULL );
     if ( err != 0) {
         QString error(pj_strerrno(err));
         error = "projection error:" + error;
@@ -169,20 +218,13 @@ Coordinate ProjectionImplementationProj4::latlon2coord(const LatLon &ll) const
 
 LatLon ProjectionImplementationProj4::coord2latlon(const Coordinate &crd) const
 {
-
-    if ( _pjBase == 0 || _pjLatlon == 0){
-        int *err = pj_get_errno_ref();
-        if (err != 0){
-            QString error(pj_strerrno(*err));
-            error = "projection error:" + error;
-            kernel()->issues()->log(error);
-        }
+    ContextLock ctx(this);
+    if ( !isReady(ctx))
         return LatLon();
-    }
 
     double x = crd.x();
     double y = crd.y();
-    int err = pj_transform(_pjBase,_pjLatlon, 1, 1, &x, &y, NULL );
+    int err = pj_transform(ctx->_pjBase, ctx->_pjLatlon, 1, 1, &x, &y, NULL );
     if ( err != 0) {
         QString error(pj_strerrno(err));
         error = "projection error:" + error;
@@ -194,3 +236,83 @@ LatLon ProjectionImplementationProj4::coord2latlon(const Coordinate &crd) const
 }
 
 
+
+bool ProjectionImplementationProj4::latlon2coord(const std::vector<LatLon> &llSource, std::vector<Coordinate> &crdTarget) const
+{
+    crdTarget.resize(llSource.size());
+    ContextLock ctx(this);
+    if ( !isReady(ctx))
+        return false;
+
+    std::vector<double> x(llSource.size());
+    std::vector<double> y(llSource.size());
+    for(quint32 i = 0; i < llSource.size(); ++i) {
+        x[i] = llSource[i].isValid() ? llSource[i].lon(Angle::uRADIANS) : HUGE_VAL;
+        y[i] = llSource[i].isValid() ? llSource[i].lat(Angle::uRADIANS) : HUGE_VAL;
+    }
+    if (!transform(ctx->_pjLatlon, ctx->_pjBase, x, y))
+        return false;
+
+    double factor = _outputIsLatLon ? RAD_TO_DEG : 1.0;
+    for(quint32 i = 0; i < llSource.size(); ++i) {
+        if ( x[i] == HUGE_VAL || y[i] == HUGE_VAL)
+            crdTarget[i] = Coordinate();
+        else
+            crdTarget[i] = Coordinate(x[i] * factor, y[i] * factor);
+    }
+    return true;
+}
+
+bool ProjectionImplementationProj4::coord2latlon(const std::vector<Coordinate> &crdSource, std::vector<LatLon> &llTarget) const
+{
+    llTarget.resize(crdSource.size());
+    ContextLock ctx(this);
+    if ( !isReady(ctx))
+        return false;
+
+    std::vector<double> x(crdSource.size());
+    std::vector<double> y(crdSource.size());
+    for(quint32 i = 0; i < crdSource.size(); ++i) {
+        x[i] = crdSource[i].isValid() ? crdSource[i].x() : HUGE_VAL;
+        y[i] = crdSource[i].isValid() ? crdSource[i].y() : HUGE_VAL;
+    }
+    if (!transform(ctx->_pjBase, ctx->_pjLatlon, x, y))
+        return false;
+
+    for(quint32 i = 0; i < crdSource.size(); ++i) {
+        if ( x[i] == HUGE_VAL || y[i] == HUGE_VAL)
+            llTarget[i] = LatLon();
+        else
+            llTarget[i] = LatLon(Degrees(y[i],false),Degrees(x[i], false));
+    }
+    return true;
+}
+
+bool ProjectionImplementationProj4::isReady(const Context *ctx) const
+{
+    if ( ctx->_pjBase == 0 || ctx->_pjLatlon == 0){
+        int err = pj_ctx_get_errno(ctx->_ctx);
+        if (err != 0){
+            QString error(pj_strerrno(err));
+            error = "projection error:" + error;
+            kernel()->issues()->log(error);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ProjectionImplementationProj4::transform(projPJ source, projPJ target, std::vector<double> &x, std::vector<double> &y) const
+{
+    if ( x.size() == 0)
+        return true;
+    // one call for all points; points that fail are set to HUGE_VAL by proj4 and the others are still transformed
+    int err = pj_transform(source, target, x.size(), 1, &x[0], &y[0], NULL );
+    if ( err != 0) {
+        QString error(pj_strerrno(err));
+        error = "projection error:" + error;
+        kernel()->issues()->log(error);
+        return false;
+    }
+    return true;
+}
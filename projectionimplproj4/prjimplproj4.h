@@ -2,6 +2,12 @@
 #define PROJECTIONIMPLEMENTATIONPROJ4_H
 
 namespace Ilwis {
+/*!
+ Projection through proj4. proj4 handles may not be used by more than one thread at the same time, so a thread that uses the
+ projection takes a proj4 context with its own handles from a pool of the projection and gives it back when it is done. Contexts are
+ created when all are in use and their handles are recreated when the definition changes; the pool is deleted with the projection.
+ Errors are taken from the context of the calling thread.
+ */
 class ProjectionImplementationProj4 : public ProjectionImplementation
 {
 public:
@@ -9,6 +15,8 @@ public:
     ~ProjectionImplementationProj4();
     Coordinate latlon2coord(const LatLon&) const;
     LatLon coord2latlon(const Coordinate&) const;
+    bool latlon2coord(const std::vector<LatLon>& llSource, std::vector<Coordinate>& crdTarget) const;
+    bool coord2latlon(const std::vector<Coordinate>& crdSource, std::vector<LatLon>& llTarget) const;
     static bool canUse(const Ilwis::Resource &) { return true;}
     static ProjectionImplementation *create(const Ilwis::Resource &resource);
      bool compute() { return true; }
@@ -17,10 +25,38 @@ public:
      bool prepare(const QString& parms="");
      QString toProj4() const;
 private:
+    struct Context {
+        Context();
+        ~Context();
+
+        projCtx _ctx;
+        projPJ  _pjLatlon;
+        projPJ  _pjBase;
+        quint32 _generation;
+    };
+    class ContextLock {
+    public:
+        ContextLock(const ProjectionImplementationProj4 *projection);
+        ~ContextLock();
+        Context *operator->() const { return _ctx; }
+        operator Context *() const { return _ctx; }
+    private:
+        const ProjectionImplementationProj4 *_projection;
+        Context *_ctx;
+    };
+
+    Context *acquireContext() const;
+    void releaseContext(Context *ctx) const;
+    bool isReady(const Context *ctx) const;
+    bool transform(projPJ source, projPJ target, std::vector<double>& x, std::vector<double>& y) const;
+    void addToDefinition(const QString& def);
+
     QString _targetDef;
-    projPJ  _pjLatlon;
-    projPJ  _pjBase;
     bool _outputIsLatLon;
+    quint32 _generation; // changes with every change of the definition, makes the handles of the contexts invalid
+    mutable std::mutex _mutex;
+    mutable std::vector<Context *> _contexts;
+    mutable std::vector<Context *> _freeContexts; // the contexts that no thread is using
 };
 }
 
@@ -21,13 +21,21 @@ DEFINES += PROJECTIONIMPLPROJ4_LIBRARY
 SOURCES += \ 
     rasteroperations/rasteroperationsmodule.cpp \
     rasteroperations/aggregateraster.cpp \
-    rasteroperations/areanumbering.cpp
+    rasteroperations/areanumbering.cpp \
+    rasteroperations/reclassify.cpp \
+    rasteroperations/rasterizefeatures.cpp \
+    rasteroperations/rastertopolygon.cpp \
+    rasteroperations/zonalstatistics.cpp
 
 
 HEADERS += \
     rasteroperations/rasteroperationsmodule.h \
     rasteroperations/aggregateraster.h \
-    rasteroperations/areanumbering.h
+    rasteroperations/areanumbering.h \
+    rasteroperations/reclassify.h \
+    rasteroperations/rasterizefeatures.h \
+    rasteroperations/rastertopolygon.h \
+    rasteroperations/zonalstatistics.h
 
 
 OTHER_FILES += \ 
@@ -0,0 +1,267 @@
+#include <functional>
+#include <future>
+#include <algorithm>
+#include "kernel.h"
+#include "raster.h"
+#include "columndefinition.h"
+#include "table.h"
+#include "attributerecord.h"
+#include "polygon.h"
+#include "geometry.h"
+#include "feature.h"
+#include "featurecoverage.h"
+#include "featureiterator.h"
+#include "coordinatetransformer.h"
+#include "linerasterizer.h"
+#include "symboltable.h"
+#include "ilwisoperation.h"
+#include "rasterizefeatures.h"
+
+using namespace Ilwis;
+using namespace RasterOperations;
+
+namespace {
+// the geometries of the features per kind, each with the index of the value of its feature
+struct Geometries {
+    std::vector<Polygon> _polygons;
+    std::vector<Line2D<Coordinate2d>> _lines;
+    std::vector<Line2D<Coordinate2d>> _points; // a line of one point is one pixel
+    std::vector<quint32> _polygonValues;
+    std::vector<quint32> _lineValues;
+    std::vector<quint32> _pointValues;
+};
+
+class AddGeometry : public boost::static_visitor<void> {
+public:
+    AddGeometry(Geometries& geometries, quint32 value) : _geometries(geometries), _value(value) {}
+
+    void operator()(const Pixel& p) const {
+        addPoint(p.x(), p.y());
+    }
+    void operator()(const Coordinate2d& p) const {
+        addPoint(p.x(), p.y());
+    }
+    void operator()(const Coordinate& p) const {
+        addPoint(p.x(), p.y());
+    }
+    void operator()(const Line2D<Coordinate2d>& line) const {
+        _geometries._lines.push_back(line);
+        _geometries._lineValues.push_back(_value);
+    }
+    void operator()(const Line2D<Pixel>& line) const {
+        Line2D<Coordinate2d> converted;
+        for(const Pixel& p : line)
+            converted.push_back(Coordinate2d(p.x(), p.y()));
+        _geometries._lines.push_back(converted);
+        _geometries._lineValues.push_back(_value);
+    }
+    void operator()(const Polygon& pol) const {
+        _geometries._polygons.push_back(pol);
+        _geometries._polygonValues.push_back(_value);
+    }
+
+private:
+    Geometries& _geometries;
+    quint32 _value;
+
+    void addPoint(double x, double y) const {
+        Line2D<Coordinate2d> point;
+        point.push_back(Coordinate2d(x, y));
+        _geometries._points.push_back(point);
+        _geometries._pointValues.push_back(_value);
+    }
+};
+}
+
+Ilwis::OperationImplementation *RasterizeFeatures::create(quint64 metaid, const Ilwis::OperationExpression &expr)
+{
+    return new RasterizeFeatures(metaid, expr);
+}
+
+RasterizeFeatures::RasterizeFeatures()
+{
+}
+
+RasterizeFeatures::RasterizeFeatures(quint64 metaid, const Ilwis::OperationExpression &expr) :
+    OperationImplementation(metaid, expr)
+{
+}
+
+bool RasterizeFeatures::execute(ExecutionContext *ctx, SymbolTable& symTable)
+{
+    if (_prepState == sNOTPREPARED)
+        if((_prepState = prepare(ctx,symTable)) != sPREPARED)
+            return false;
+
+    IRasterCoverage outputRaster = _outputObj.get<RasterCoverage>();
+    IFeatureCoverage inputFC = _inputObj.get<FeatureCoverage>();
+
+    std::vector<double> values;
+    Geometries geometries;
+    FeatureIterator iter(inputFC);
+    for(; iter != iter.end(); ++iter) {
+        SPFeatureI feature = *iter;
+        if ( _attribColumn != "") {
+            bool ok;
+            double v = feature->cell(_attribColumn).toDouble(&ok);
+            values.push_back(ok && !isNumericalUndef(v) ? v : rUNDEF);
+        } else
+            values.push_back(feature->featureid());
+        for(quint32 t = 0; t < feature->trackSize(); ++t)
+            feature->geometry(t).apply(AddGeometry(geometries, values.size() - 1));
+    }
+
+    // the runs of pixels per row, in the order in which they must be burned. A row is only touched by the thread that handles its tile
+    qint32 ysize = outputRaster->size().ysize();
+    std::vector<std::vector<Span>> rows(ysize);
+    auto spans = [&](const std::vector<quint32>& owners) -> LineRasterizer::SpanWriter {
+        return [&rows, &owners](quint32 index, qint32 y, qint32 x0, qint32 x1) {
+            rows[y].push_back({x0, x1, owners[index]});
+        };
+    };
+    LineRasterizer rasterizer(outputRaster->georeference(), inputFC->coordinateSystem());
+    if (!rasterizer.fill(geometries._polygons, spans(geometries._polygonValues), _mode))
+        return false;
+    if (!rasterizer.rasterize(geometries._lines, spans(geometries._lineValues), _mode))
+        return false;
+    if (!rasterizer.rasterize(geometries._points, spans(geometries._pointValues), _mode))
+        return false;
+
+    BoxedAsyncFunc burnFun = [&](const Box3D<qint32>& box) -> bool {
+        PixelIterator iterOut(outputRaster, box);
+        PixelIterator iterEnd = iterOut.end();
+        qint32 xmin = box.min_corner().x(), xmax = box.max_corner().x();
+        std::vector<double> row(xmax - xmin + 1);
+        qint32 currentRow = iUNDEF;
+        while(iterOut != iterEnd) {
+            Voxel position = iterOut.position();
+            if ( position.y() != currentRow) {
+                currentRow = position.y();
+                std::fill(row.begin(), row.end(), rUNDEF);
+                for(const Span& span : rows[currentRow]) {
+                    qint32 x0 = std::max(span._x0, xmin), x1 = std::min(span._x1, xmax);
+                    if ( x0 <= x1)
+                        std::fill(row.begin() + (x0 - xmin), row.begin() + (x1 - xmin + 1), values[span._value]);
+                }
+            }
+            *iterOut = row[position.x() - xmin];
+            ++iterOut;
+        }
+        return true;
+    };
+    bool res = OperationHelperRaster::execute(ctx, burnFun, outputRaster);
+
+    if ( res && ctx != 0) {
+        QVariant value;
+        value.setValue<IRasterCoverage>(outputRaster);
+        ctx->addOutput(symTable,value,outputRaster->name(), itRASTER, outputRaster->source() );
+    }
+    return res;
+}
+
+Ilwis::OperationImplementation::State RasterizeFeatures::prepare(ExecutionContext *, const SymbolTable & )
+{
+    if ( _expression.parameterCount() < 2 || _expression.parameterCount() > 4) {
+        ERROR3(ERR_ILLEGAL_NUM_PARM3,"rasterize","2,3 or 4",QString::number(_expression.parameterCount()));
+        return sPREPAREFAILED;
+    }
+    QString features = _expression.parm(0).value();
+    QString outputName = _expression.parm(0,false).value();
+
+    if (!_inputObj.prepare(features, itFEATURE)) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,features,"");
+        return sPREPAREFAILED;
+    }
+    IFeatureCoverage inputFC = _inputObj.get<FeatureCoverage>();
+    IGeoReference grf;
+    grf.prepare(_expression.parm(1).value());
+    if ( !grf.isValid()) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,_expression.parm(1).value(),"");
+        return sPREPAREFAILED;
+    }
+
+    IDomain dom;
+    if ( _expression.parameterCount() > 2) {
+        _attribColumn = _expression.parm(2).value();
+        _attribColumn.remove('"');
+    }
+    if ( _attribColumn != "") {
+        ITable attTable = inputFC->attributeTable();
+        if (! attTable.isValid()) {
+            ERROR2(ERR_NO_FOUND2,"attribute-table", "coverage");
+            return sPREPAREFAILED;
+        }
+        if ( attTable->columnIndex(_attribColumn) == (quint32)iUNDEF) {
+            ERROR2(ERR_COLUMN_MISSING_2, _attribColumn, attTable->name());
+            return sPREPAREFAILED;
+        }
+        dom = attTable->columndefinition(_attribColumn).datadef().domain();
+        // the values are burned as numbers; text columns cant be used
+        if ( !dom.isValid() || !hasType(dom->valueType(), itNUMERIC | itDOMAINITEM)) {
+            ERROR3(ERR_ILLEGAL_PARM_3,"column",_attribColumn,"rasterize");
+            return sPREPAREFAILED;
+        }
+    } else
+        dom.prepare("value");
+
+    if ( _expression.parameterCount() == 4) {
+        QString mode = _expression.parm(3).value().toLower();
+        if ( mode == "center")
+            _mode = LineRasterizer::mCENTER;
+        else if ( mode == "alltouched")
+            _mode = LineRasterizer::mALLTOUCHED;
+        else {
+            ERROR3(ERR_ILLEGAL_PARM_3,"mode",mode,"rasterize");
+            return sPREPAREFAILED;
+        }
+    }
+
+    Resource resource(itRASTER);
+    resource.addProperty("size", IVARIANT(grf->size()));
+    resource.addProperty("georeference", IVARIANT(grf));
+    resource.addProperty("coordinatesystem", IVARIANT(grf->coordinateSystem()));
+    resource.addProperty("envelope", IVARIANT(grf->pixel2Coord(grf->size())));
+    resource.addProperty("domain", IVARIANT(dom));
+    resource.prepare();
+    if ( !_outputObj.prepare(resource)) {
+        ERROR1(ERR_NO_INITIALIZED_1, "output rastercoverage");
+        return sPREPAREFAILED;
+    }
+    if ( outputName != sUNDEF)
+        _outputObj->setName(outputName);
+
+    return sPREPARED;
+}
+
+quint64 RasterizeFeatures::createMetadata()
+{
+    QString url = QString("ilwis://operations/rasterize");
+    Resource resource(QUrl(url), itOPERATIONMETADATA);
+    resource.addProperty("namespace","ilwis");
+    resource.addProperty("longname","rasterize feature coverage");
+    resource.addProperty("syntax","rasterize(inputfeaturecoverage,targetgeoref[,attributecolumn[,center|alltouched]])");
+    resource.addProperty("description",TR("burns the features of a feature coverage into a raster coverage; polygons are filled, lines and points are drawn on top of them"));
+    resource.addProperty("inparameters","2|3|4");
+    resource.addProperty("pin_1_type", itFEATURE);
+    resource.addProperty("pin_1_name", TR("input featurecoverage"));
+    resource.addProperty("pin_1_desc",TR("input featurecoverage with points, lines and/or polygons"));
+    resource.addProperty("pin_2_type", itGEOREF);
+    resource.addProperty("pin_2_name", TR("target georeference"));
+    resource.addProperty("pin_2_desc",TR("the georeference of the output raster coverage"));
+    resource.addProperty("pin_3_type", itSTRING);
+    resource.addProperty("pin_3_name", TR("attribute column"));
+    resource.addProperty("pin_3_desc",TR("optional column of the attribute table that contains the values to burn; without it the feature ids are burned"));
+    resource.addProperty("pin_4_type", itSTRING);
+    resource.addProperty("pin_4_name", TR("pixel selection"));
+    resource.addProperty("pin_4_desc",TR("optional; center (default) selects the pixels whose center is inside a polygon, alltouched every pixel touched by a feature"));
+    resource.addProperty("outparameters",1);
+    resource.addProperty("pout_1_type", itRASTER);
+    resource.addProperty("pout_1_name", TR("output rastercoverage"));
+    resource.addProperty("pout_1_desc",TR("output rastercoverage with the domain of the attribute column or a value domain"));
+    resource.prepare();
+    url += "=" + QString::number(resource.id());
+    resource.setUrl(url);
+
+    mastercatalog()->addItems({resource});
+    return resource.id();
+}
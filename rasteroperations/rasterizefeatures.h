@@ -0,0 +1,39 @@
+#ifndef RASTERIZEFEATURES_H
+#define RASTERIZEFEATURES_H
+
+namespace Ilwis {
+namespace RasterOperations {
+/*!
+ Burns the features of a feature coverage into a raster with a given georeference. The value of a feature is an attribute of the feature or,
+ without attribute, its feature id. Polygons are filled by scanlines, lines and points are burned on top of them; within a kind a later
+ feature overwrites an earlier one. The geometries are converted to runs of pixels per row first (in parallel over tiles of rows), then the
+ rows are written to the output raster in parallel.
+ */
+class RasterizeFeatures : public OperationImplementation
+{
+public:
+    RasterizeFeatures();
+    RasterizeFeatures(quint64 metaid, const Ilwis::OperationExpression &expr);
+
+    bool execute(ExecutionContext *ctx,SymbolTable& symTable);
+    static Ilwis::OperationImplementation *create(quint64 metaid,const Ilwis::OperationExpression& expr);
+    Ilwis::OperationImplementation::State prepare(ExecutionContext *ctx, const SymbolTable &);
+
+    static quint64 createMetadata();
+
+private:
+    struct Span {
+        qint32 _x0;
+        qint32 _x1;
+        quint32 _value; // index in the values of the features
+    };
+
+    IIlwisObject _inputObj;
+    IIlwisObject _outputObj;
+    QString _attribColumn;
+    LineRasterizer::Mode _mode = LineRasterizer::mCENTER;
+};
+}
+}
+
+#endif // RASTERIZEFEATURES_H
@@ -15,6 +15,13 @@
 #include "pixeliterator.h"
 #include "aggregateraster.h"
 #include "areanumbering.h"
+#include "reclassify.h"
+#include "polygon.h"
+#include "coordinatetransformer.h"
+#include "linerasterizer.h"
+#include "rasterizefeatures.h"
+#include "rastertopolygon.h"
+#include "zonalstatistics.h"
 
 using namespace Ilwis;
 using namespace RasterOperations;
@@ -34,6 +41,10 @@ void RasterOperationsModule::prepare()
 {
    commandhandler()->addOperation(AggregateRaster::createMetadata(), AggregateRaster::create);
    commandhandler()->addOperation(AreaNumbering::createMetadata(), AreaNumbering::create);
+   commandhandler()->addOperation(Reclassify::createMetadata(), Reclassify::create);
+   commandhandler()->addOperation(RasterizeFeatures::createMetadata(), RasterizeFeatures::create);
+   commandhandler()->addOperation(RasterToPolygon::createMetadata(), RasterToPolygon::create);
+   commandhandler()->addOperation(ZonalStatistics::createMetadata(), ZonalStatistics::create);
 
 }
 
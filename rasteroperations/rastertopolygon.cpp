@@ -0,0 +1,375 @@
+#include <functional>
+#include <future>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <boost/geometry/algorithms/correct.hpp>
+#include "kernel.h"
+#include "raster.h"
+#include "columndefinition.h"
+#include "table.h"
+#include "attributerecord.h"
+#include "polygon.h"
+#include "geometry.h"
+#include "feature.h"
+#include "featurecoverage.h"
+#include "symboltable.h"
+#include "ilwisoperation.h"
+#include "operationhelperfeatures.h"
+#include "rastertopolygon.h"
+
+using namespace Ilwis;
+using namespace RasterOperations;
+
+#define STRIPSIZE 64
+
+Ilwis::OperationImplementation *RasterToPolygon::create(quint64 metaid, const Ilwis::OperationExpression &expr)
+{
+    return new RasterToPolygon(metaid, expr);
+}
+
+RasterToPolygon::RasterToPolygon()
+{
+}
+
+RasterToPolygon::RasterToPolygon(quint64 metaid, const Ilwis::OperationExpression &expr) :
+    OperationImplementation(metaid, expr)
+{
+}
+
+bool RasterToPolygon::execute(ExecutionContext *ctx, SymbolTable& symTable)
+{
+    if (_prepState == sNOTPREPARED)
+        if((_prepState = prepare(ctx,symTable)) != sPREPARED)
+            return false;
+
+    IRasterCoverage inputRaster = _inputObj.get<RasterCoverage>();
+    IFeatureCoverage outputFC = _outputObj.get<FeatureCoverage>();
+    IGeoReference grf = inputRaster->georeference();
+    // the corners of the pixels are at whole pixel positions, as in LineRasterizer
+    double offset = grf->centerOfPixel() ? -0.5 : 0;
+
+    Features features;
+    BoundaryTracer tracer(inputRaster->size().xsize(), [&](double value, const std::vector<std::vector<Pixel>>& rings) {
+        Polygon pol;
+        pol.inners().resize(rings.size() - 1);
+        for(quint32 r = 0; r < rings.size(); ++r) {
+            auto& ring = r == 0 ? pol.outer() : pol.inners()[r - 1];
+            for(const Pixel& pix : rings[r]) {
+                Coordinate crd = grf->pixel2Coord(Pixel_d(pix.x() + offset, pix.y() + offset));
+                ring.push_back(Coordinate2d(crd.x(), crd.y()));
+            }
+        }
+        boost::geometry::correct(pol); // the orientation in world coordinates depends on the georeference
+        SPFeatureI feature = outputFC->createFeature(Geometry(pol));
+        features.push_back(feature);
+        _attTable->record(NEW_RECORD, {feature->featureid(), value});
+    });
+
+    Size sz = inputRaster->size();
+    std::vector<double> row(sz.xsize());
+    for(qint32 y0 = 0; y0 < sz.ysize(); y0 += STRIPSIZE) {
+        qint32 y1 = std::min(y0 + STRIPSIZE, (qint32)sz.ysize()) - 1;
+        PixelIterator iter(inputRaster, Box3D<qint32>(Voxel(0, y0, 0), Voxel(sz.xsize() - 1, y1, 0)));
+        for(qint32 y = y0; y <= y1; ++y) {
+            for(quint32 x = 0; x < sz.xsize(); ++x, ++iter)
+                row[x] = *iter;
+            tracer.addRow(row);
+        }
+        outputFC->addFeatures(features); // the areas that were closed in this strip
+        features.clear();
+    }
+    tracer.finish();
+    outputFC->addFeatures(features);
+    OperationHelper::updateRanges(_attTable);
+
+    if ( ctx != 0) {
+        QVariant value;
+        value.setValue<IFeatureCoverage>(outputFC);
+        ctx->addOutput(symTable,value,outputFC->name(), itFEATURE, outputFC->source() );
+    }
+    return true;
+}
+
+Ilwis::OperationImplementation::State RasterToPolygon::prepare(ExecutionContext *, const SymbolTable & )
+{
+    QString raster = _expression.parm(0).value();
+    QString outputName = _expression.parm(0,false).value();
+
+    if (!_inputObj.prepare(raster, itRASTER)) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,raster,"");
+        return sPREPAREFAILED;
+    }
+    IRasterCoverage inputRaster = _inputObj.get<RasterCoverage>();
+
+    _outputObj = OperationHelperFeatures::initialize(_inputObj,itFEATURE, itCOORDSYSTEM | itENVELOPE);
+    if ( !_outputObj.isValid()) {
+        ERROR1(ERR_NO_INITIALIZED_1, "output featurecoverage");
+        return sPREPAREFAILED;
+    }
+    if ( outputName != sUNDEF)
+        _outputObj->setName(outputName);
+
+    QString url = "ilwis://internal/" + outputName;
+    Resource resource(url, itFLATTABLE);
+    _attTable.prepare(resource);
+    IDomain covdom;
+    if (!covdom.prepare("count")){
+        return sPREPAREFAILED;
+    }
+    _attTable->addColumn(FEATUREIDCOLUMN,covdom);
+    _attTable->addColumn("value", inputRaster->datadef().domain());
+    IFeatureCoverage outputFC = _outputObj.get<FeatureCoverage>();
+    outputFC->attributeTable(_attTable);
+
+    return sPREPARED;
+}
+
+quint64 RasterToPolygon::createMetadata()
+{
+    QString url = QString("ilwis://operations/raster2polygon");
+    Resource resource(QUrl(url), itOPERATIONMETADATA);
+    resource.addProperty("namespace","ilwis");
+    resource.addProperty("longname","raster to polygon");
+    resource.addProperty("syntax","raster2polygon(inputgridcoverage)");
+    resource.addProperty("description",TR("converts the areas of a raster coverage (connected pixels with the same value) to polygons, e.g. the output of areanumbering"));
+    resource.addProperty("inparameters","1");
+    resource.addProperty("pin_1_type", itRASTER);
+    resource.addProperty("pin_1_name", TR("input rastercoverage"));
+    resource.addProperty("pin_1_desc",TR("input rastercoverage; undefined pixels are not converted"));
+    resource.addProperty("outparameters",1);
+    resource.addProperty("pout_1_type", itFEATURE);
+    resource.addProperty("pout_1_name", TR("output featurecoverage"));
+    resource.addProperty("pout_1_desc",TR("polygon coverage with a feature per area; the attribute 'value' holds the value of the area"));
+    resource.prepare();
+    url += "=" + QString::number(resource.id());
+    resource.setUrl(url);
+
+    mastercatalog()->addItems({resource});
+    return resource.id();
+}
+
+//-----------------------------------------------------------
+namespace {
+quint64 vertexKey(qint32 x, qint32 y) {
+    return ((quint64)(quint32)y << 32) | (quint32)x;
+}
+
+qint32 sign(qint32 v) {
+    return (v > 0) - (v < 0);
+}
+
+bool isDefined(double v) {
+    return !isNumericalUndef(v);
+}
+}
+
+BoundaryTracer::BoundaryTracer(quint32 xsize, const AreaWriter &writer) : _xsize(xsize), _writer(writer)
+{
+}
+
+void BoundaryTracer::addRow(const std::vector<double> &row)
+{
+    std::vector<Run> current = runs(row);
+    qint32 y = _row;
+
+    // runs that continue an area of the previous row get its number; areas that meet in this row are joined
+    for(quint32 i = 0, j = 0; i < _previous.size() && j < current.size(); ) {
+        const Run& above = _previous[i];
+        Run& run = current[j];
+        if ( isDefined(run._value) && run._value == above._value) {
+            run._area = run._area == (quint32)iUNDEF ? find(above._area) : merge(run._area, above._area);
+        }
+        qint32 end = std::min(above._x1, run._x1); // both advance when they end in the same column
+        i += above._x1 == end;
+        j += run._x1 == end;
+    }
+    for(Run& run : current) {
+        if ( isDefined(run._value) && run._area == (quint32)iUNDEF) {
+            run._area = _nextArea++;
+            _areas[run._area]._value = run._value;
+        }
+    }
+
+    // horizontal boundaries on the line between the previous row and this row
+    if ( y == 0) {
+        for(const Run& run : current)
+            if ( isDefined(run._value))
+                addSegment(run._area, run._x0, 0, run._x1 + 1, 0);
+    } else {
+        for(quint32 i = 0, j = 0; i < _previous.size() && j < current.size(); ) {
+            const Run& above = _previous[i];
+            const Run& run = current[j];
+            if ( above._value != run._value) {
+                qint32 a = std::max(above._x0, run._x0), b = std::min(above._x1, run._x1) + 1;
+                if ( isDefined(run._value))
+                    addSegment(find(run._area), a, y, b, y);
+                if ( isDefined(above._value))
+                    addSegment(find(above._area), b, y, a, y);
+            }
+            qint32 end = std::min(above._x1, run._x1); // both advance when they end in the same column
+            i += above._x1 == end;
+            j += run._x1 == end;
+        }
+    }
+    // vertical boundaries; runs are as long as possible, so both ends of a run are boundaries
+    for(const Run& run : current) {
+        if ( !isDefined(run._value))
+            continue;
+        quint32 area = find(run._area);
+        addSegment(area, run._x0, y + 1, run._x0, y);
+        addSegment(area, run._x1 + 1, y, run._x1 + 1, y + 1);
+    }
+
+    // areas of the previous row that do not continue in this row are complete
+    std::unordered_set<quint32> open;
+    for(Run& run : current) {
+        if ( isDefined(run._value)) {
+            run._area = find(run._area);
+            open.insert(run._area);
+        }
+    }
+    for(const Run& above : _previous) {
+        if ( isDefined(above._value)) {
+            quint32 area = find(above._area);
+            if ( open.find(area) == open.end())
+                close(area);
+        }
+    }
+    _merged.clear();
+    _previous.swap(current);
+    ++_row;
+}
+
+void BoundaryTracer::finish()
+{
+    for(const Run& run : _previous)
+        if ( isDefined(run._value))
+            addSegment(run._area, run._x1 + 1, _row, run._x0, _row);
+    for(const Run& run : _previous)
+        if ( isDefined(run._value))
+            close(run._area);
+    _previous.clear();
+}
+
+quint32 BoundaryTracer::openAreas() const
+{
+    return _areas.size();
+}
+
+std::vector<BoundaryTracer::Run> BoundaryTracer::runs(const std::vector<double> &row) const
+{
+    std::vector<Run> result;
+    for(quint32 x = 0; x < std::min(_xsize, (quint32)row.size()); ++x) {
+        double v = isDefined(row[x]) ? row[x] : rUNDEF;
+        if ( result.size() > 0 && result.back()._value == v)
+            result.back()._x1 = x;
+        else
+            result.push_back({(qint32)x, (qint32)x, v, (quint32)iUNDEF});
+    }
+    return result;
+}
+
+quint32 BoundaryTracer::find(quint32 area) const
+{
+    for(auto iter = _merged.find(area); iter != _merged.end(); iter = _merged.find(area))
+        area = (*iter).second;
+    return area;
+}
+
+quint32 BoundaryTracer::merge(quint32 area1, quint32 area2)
+{
+    area1 = find(area1);
+    area2 = find(area2);
+    if ( area1 == area2)
+        return area1;
+    // the boundaries of the smaller area are moved
+    if ( _areas[area1]._segments.size() < _areas[area2]._segments.size())
+        std::swap(area1, area2);
+    std::vector<Segment>& segments = _areas[area1]._segments;
+    const std::vector<Segment>& moved = _areas[area2]._segments;
+    segments.insert(segments.end(), moved.begin(), moved.end());
+    _areas.erase(area2);
+    _merged[area2] = area1;
+    return area1;
+}
+
+void BoundaryTracer::addSegment(quint32 area, qint32 x0, qint32 y0, qint32 x1, qint32 y1)
+{
+    _areas[area]._segments.push_back({x0, y0, x1, y1});
+}
+
+void BoundaryTracer::close(quint32 area)
+{
+    auto iter = _areas.find(area);
+    if ( iter == _areas.end()) // already closed
+        return;
+    Area closed = std::move((*iter).second);
+    _areas.erase(iter);
+    std::vector<std::vector<Pixel>> rings = trace(closed._segments);
+    if ( rings.size() > 0)
+        _writer(closed._value, rings);
+}
+
+std::vector<std::vector<Pixel>> BoundaryTracer::trace(const std::vector<Segment> &segments) const
+{
+    std::vector<std::pair<quint64, quint32>> starts(segments.size());
+    for(quint32 i = 0; i < segments.size(); ++i)
+        starts[i] = {vertexKey(segments[i]._x0, segments[i]._y0), i};
+    std::sort(starts.begin(), starts.end());
+
+    std::vector<bool> used(segments.size(), false);
+    std::vector<std::vector<Pixel>> rings;
+    std::vector<double> areas;
+    for(quint32 first = 0; first < segments.size(); ++first) {
+        if ( used[first])
+            continue;
+        std::vector<Pixel> ring;
+        quint32 current = first;
+        while(!used[current]) {
+            used[current] = true;
+            const Segment& seg = segments[current];
+            qint32 dx = sign(seg._x1 - seg._x0), dy = sign(seg._y1 - seg._y0);
+            // of the segments that start at the end of this one, the right turn comes first, then straight on, then the left turn
+            auto range = std::equal_range(starts.begin(), starts.end(), std::make_pair(vertexKey(seg._x1, seg._y1), 0u),
+                                          [](const std::pair<quint64, quint32>& s1, const std::pair<quint64, quint32>& s2) { return s1.first < s2.first; });
+            quint32 next = iUNDEF;
+            int best = 3;
+            for(auto iter = range.first; iter != range.second; ++iter) {
+                const Segment& candidate = segments[(*iter).second];
+                qint32 cx = sign(candidate._x1 - candidate._x0), cy = sign(candidate._y1 - candidate._y0);
+                int rank = cx == -dy && cy == dx ? 0 : (cx == dx && cy == dy ? 1 : (cx == dy && cy == -dx ? 2 : 3));
+                if ( rank < best) {
+                    best = rank;
+                    next = (*iter).second;
+                }
+            }
+            if ( next == (quint32)iUNDEF)
+                break;
+            if ( best != 1) // only the corners are vertices of the ring
+                ring.push_back(Pixel(seg._x1, seg._y1));
+            current = next;
+        }
+        if ( ring.size() < 3)
+            continue;
+        ring.push_back(ring.front());
+        double area = 0;
+        for(quint32 i = 0; i + 1 < ring.size(); ++i)
+            area += (double)ring[i].x() * ring[i + 1].y() - (double)ring[i + 1].x() * ring[i].y();
+        rings.push_back(ring);
+        areas.push_back(area);
+    }
+    // clockwise rings (positive area, y downwards) are outer rings; an area is connected so it has one
+    std::vector<std::vector<Pixel>> result;
+    quint32 outer = iUNDEF;
+    for(quint32 i = 0; i < rings.size(); ++i)
+        if ( areas[i] > 0 && (outer == (quint32)iUNDEF || areas[i] > areas[outer]))
+            outer = i;
+    if ( outer == (quint32)iUNDEF)
+        return result;
+    result.push_back(rings[outer]);
+    for(quint32 i = 0; i < rings.size(); ++i)
+        if ( areas[i] < 0)
+            result.push_back(rings[i]);
+    return result;
+}
@@ -0,0 +1,87 @@
+#ifndef RASTERTOPOLYGON_H
+#define RASTERTOPOLYGON_H
+
+namespace Ilwis {
+namespace RasterOperations {
+/*!
+ Converts the areas of a raster to polygons. An area is a 4-connected set of pixels with the same value, as numbered by AreaNumbering; every
+ area becomes one polygon feature with the value of its pixels as attribute. Undefined pixels do not belong to an area. The raster is read
+ strip by strip in one pass.
+ */
+class RasterToPolygon : public OperationImplementation
+{
+public:
+    RasterToPolygon();
+    RasterToPolygon(quint64 metaid, const Ilwis::OperationExpression &expr);
+
+    bool execute(ExecutionContext *ctx,SymbolTable& symTable);
+    static Ilwis::OperationImplementation *create(quint64 metaid,const Ilwis::OperationExpression& expr);
+    Ilwis::OperationImplementation::State prepare(ExecutionContext *ctx, const SymbolTable &);
+
+    static quint64 createMetadata();
+
+private:
+    IIlwisObject _inputObj;
+    IIlwisObject _outputObj;
+    ITable _attTable;
+};
+
+/*!
+ Traces the boundaries of the areas of a raster that is offered row by row. Only the runs of the previous row and the boundaries of the areas
+ that are still open are kept; an area is closed, and handed to the writer, in the first row that does not continue it. Memory use is
+ proportional to the frontier of open areas, not to the size of the raster.
+ Boundaries are traced on the pixel corners, clockwise with the area on the right (y runs downwards). Where an area touches itself at a
+ corner the tracer turns towards the area, so diagonal neighbours are not connected.
+ */
+class BoundaryTracer {
+public:
+    /*!
+     receives a closed area: the value of its pixels and its rings in pixel corner coordinates; the first ring is the outer ring, the others are holes
+     */
+    typedef std::function<void(double value, const std::vector<std::vector<Pixel>>& rings)> AreaWriter;
+
+    BoundaryTracer(quint32 xsize, const AreaWriter& writer);
+    void addRow(const std::vector<double>& row);
+    /*!
+     closes the areas that reach the last row. No rows can be added after this
+     */
+    void finish();
+    quint32 openAreas() const;
+
+private:
+    struct Run {
+        qint32 _x0;
+        qint32 _x1;
+        double _value;
+        quint32 _area;
+    };
+    struct Segment { // directed, the area is on its right
+        qint32 _x0;
+        qint32 _y0;
+        qint32 _x1;
+        qint32 _y1;
+    };
+    struct Area {
+        double _value;
+        std::vector<Segment> _segments;
+    };
+
+    quint32 _xsize;
+    qint32 _row = 0;
+    quint32 _nextArea = 0;
+    AreaWriter _writer;
+    std::vector<Run> _previous;
+    std::unordered_map<quint32, Area> _areas;
+    std::unordered_map<quint32, quint32> _merged; // areas that were joined in the current row, and the area they were joined to
+
+    std::vector<Run> runs(const std::vector<double>& row) const;
+    quint32 find(quint32 area) const;
+    quint32 merge(quint32 area1, quint32 area2);
+    void addSegment(quint32 area, qint32 x0, qint32 y0, qint32 x1, qint32 y1);
+    void close(quint32 area);
+    std::vector<std::vector<Pixel>> trace(const std::vector<Segment>& segments) const;
+};
+}
+}
+
+#endif // RASTERTOPOLYGON_H
@@ -0,0 +1,173 @@
+#include <functional>
+#include <future>
+#include "kernel.h"
+#include "raster.h"
+#include "symboltable.h"
+#include "ilwisoperation.h"
+#include "columndefinition.h"
+#include "table.h"
+#include "attributerecord.h"
+#include "reclassify.h"
+
+using namespace Ilwis;
+using namespace RasterOperations;
+
+
+Ilwis::OperationImplementation *Reclassify::create(quint64 metaid, const Ilwis::OperationExpression &expr)
+{
+    return new Reclassify(metaid, expr);
+}
+
+Reclassify::Reclassify()
+{
+}
+
+Reclassify::Reclassify(quint64 metaid, const Ilwis::OperationExpression &expr) :
+    OperationImplementation(metaid, expr)
+{
+}
+
+bool Reclassify::execute(ExecutionContext *ctx, SymbolTable& symTable)
+{
+    if (_prepState == sNOTPREPARED)
+        if((_prepState = prepare(ctx,symTable)) != sPREPARED)
+            return false;
+
+    IRasterCoverage outputRaster = _outputObj.get<RasterCoverage>();
+    IRasterCoverage inputRaster = _inputObj.get<RasterCoverage>();
+    if (!buildLookup(inputRaster))
+        return false;
+
+    BoxedAsyncFunc reclassFun = [&](const Box3D<qint32>& box) -> bool {
+        PixelIterator iterOut(outputRaster, box);
+        PixelIterator iterIn(inputRaster, box);
+        PixelIterator iterEnd = iterOut.end();
+        if ( _dense) { // the common case gets its own loop; a bounds check and an array read per pixel
+            const double *table = _denseLookup.data();
+            quint64 tableSize = _denseLookup.size();
+            while(iterOut != iterEnd) {
+                double key = *iterIn;
+                *iterOut = key >= 0 && key < tableSize ? table[(quint64)key] : rUNDEF;
+                ++iterOut;
+                ++iterIn;
+            }
+        } else {
+            while(iterOut != iterEnd) {
+                *iterOut = lookup(*iterIn);
+                ++iterOut;
+                ++iterIn;
+            }
+        }
+        return true;
+    };
+    bool res = OperationHelperRaster::execute(ctx, reclassFun, outputRaster);
+
+    if ( res && ctx != 0) {
+        QVariant value;
+        value.setValue<IRasterCoverage>(outputRaster);
+        ctx->addOutput(symTable,value,outputRaster->name(), itRASTER, outputRaster->source() );
+    }
+    return res;
+}
+
+bool Reclassify::buildLookup(const IRasterCoverage& inputRaster)
+{
+    ITable attTable = inputRaster->attributeTable();
+    // dense for item domains and small integer ranges; the table may be a bit larger than the number of records
+    quint32 maxKey = std::max<quint32>(1 << 16, 4 * attTable->records());
+    _denseLookup.clear();
+    _sparseLookup.clear();
+    _dense = AttributeRecord(attTable, COVERAGEKEYCOLUMN).projectColumn(_attribColumn, _denseLookup, maxKey);
+    if ( _dense)
+        return true;
+
+    std::vector<QVariant> keys = attTable->column(COVERAGEKEYCOLUMN);
+    std::vector<QVariant> values = attTable->column(_attribColumn);
+    if ( keys.size() != values.size()) {
+        ERROR2(ERR_COLUMN_MISSING_2, _attribColumn, attTable->name());
+        return false;
+    }
+    _sparseLookup.reserve(keys.size());
+    for(quint32 rec = 0; rec < keys.size(); ++rec) {
+        bool ok;
+        quint64 key = keys[rec].toULongLong(&ok);
+        if ( !ok || _sparseLookup.find(key) != _sparseLookup.end()) // first record wins, as in AttributeRecord
+            continue;
+        double v = values[rec].toDouble(&ok);
+        _sparseLookup[key] = ok && !isNumericalUndef(v) ? v : rUNDEF;
+    }
+    return true;
+}
+
+Ilwis::OperationImplementation::State Reclassify::prepare(ExecutionContext *, const SymbolTable & )
+{
+    if ( _expression.parameterCount() != 2) {
+        ERROR3(ERR_ILLEGAL_NUM_PARM3,"reclassify","2",QString::number(_expression.parameterCount()));
+        return sPREPAREFAILED;
+    }
+    QString raster = _expression.parm(0).value();
+    QString outputName = _expression.parm(0,false).value();
+    int copylist = itCOORDSYSTEM | itGEOREF | itRASTERSIZE | itENVELOPE;
+
+    if (!_inputObj.prepare(raster, itRASTER)) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,raster,"");
+        return sPREPAREFAILED;
+    }
+    IRasterCoverage inputRaster = _inputObj.get<RasterCoverage>();
+    ITable attTable = inputRaster->attributeTable();
+    if (! attTable.isValid()) {
+        ERROR2(ERR_NO_FOUND2,"attribute-table", "coverage");
+        return sPREPAREFAILED;
+    }
+    _attribColumn = _expression.parm(1).value();
+    _attribColumn.remove('"');
+    if ( attTable->columnIndex(_attribColumn) == (quint32)iUNDEF) {
+        ERROR2(ERR_COLUMN_MISSING_2, _attribColumn, attTable->name());
+        return sPREPAREFAILED;
+    }
+    // the new values are read as numbers; text columns cant be used
+    IDomain dom = attTable->columndefinition(_attribColumn).datadef().domain();
+    if ( !dom.isValid() || !hasType(dom->valueType(), itNUMERIC | itDOMAINITEM)) {
+        ERROR3(ERR_ILLEGAL_PARM_3,"column",_attribColumn,"reclassify");
+        return sPREPAREFAILED;
+    }
+
+    _outputObj = OperationHelperRaster::initialize(_inputObj,itRASTER, copylist);
+    if ( !_outputObj.isValid()) {
+        ERROR1(ERR_NO_INITIALIZED_1, "output rastercoverage");
+        return sPREPAREFAILED;
+    }
+    IRasterCoverage outputRaster = _outputObj.get<RasterCoverage>();
+    outputRaster->datadef() = attTable->columndefinition(_attribColumn).datadef();
+    if ( outputName != sUNDEF)
+        _outputObj->setName(outputName);
+
+    return sPREPARED;
+}
+
+quint64 Reclassify::createMetadata()
+{
+    QString url = QString("ilwis://operations/reclassify");
+    Resource resource(QUrl(url), itOPERATIONMETADATA);
+    resource.addProperty("namespace","ilwis");
+    resource.addProperty("longname","reclassify raster coverage");
+    resource.addProperty("syntax","reclassify(inputgridcoverage,attributecolumn)");
+    resource.addProperty("description",TR("maps the values of a raster coverage through a column of its attribute table"));
+    resource.addProperty("inparameters","2");
+    resource.addProperty("pin_1_type", itRASTER);
+    resource.addProperty("pin_1_name", TR("input rastercoverage"));
+    resource.addProperty("pin_1_desc",TR("input rastercoverage with an attribute table"));
+    resource.addProperty("pin_2_type", itSTRING);
+    resource.addProperty("pin_2_name", TR("attribute column"));
+    resource.addProperty("pin_2_desc",TR("column of the attribute table that contains the new values"));
+    resource.addProperty("outparameters",1);
+    resource.addProperty("pout_1_type", itRASTER);
+    resource.addProperty("pout_1_name", TR("output rastercoverage"));
+    resource.addProperty("pout_1_desc",TR("output rastercoverage with the domain of the attribute column"));
+    resource.prepare();
+    url += "=" + QString::number(resource.id());
+    resource.setUrl(url);
+
+    mastercatalog()->addItems({resource});
+    return resource.id();
+}
@@ -0,0 +1,45 @@
+#ifndef RECLASSIFY_H
+#define RECLASSIFY_H
+
+namespace Ilwis {
+namespace RasterOperations {
+/*!
+ Maps the values of a raster through a column of its attribute table. The lookup table is build once before the pixels are visited; for item domains
+ and small integer ranges it is a dense array indexed by the raster value, for sparse keys it is a hash table.
+ */
+class Reclassify : public OperationImplementation
+{
+public:
+    Reclassify();
+    Reclassify(quint64 metaid, const Ilwis::OperationExpression &expr);
+
+    bool execute(ExecutionContext *ctx,SymbolTable& symTable);
+    static Ilwis::OperationImplementation *create(quint64 metaid,const Ilwis::OperationExpression& expr);
+    Ilwis::OperationImplementation::State prepare(ExecutionContext *ctx, const SymbolTable &);
+
+    static quint64 createMetadata();
+
+private:
+    bool buildLookup(const IRasterCoverage &inputRaster);
+    double lookup(double key) const{
+        if ( key < 0 || key == rUNDEF)
+            return rUNDEF;
+        if ( _dense) {
+            quint64 index = (quint64)key;
+            return index < _denseLookup.size() ? _denseLookup[index] : rUNDEF;
+        }
+        auto iter = _sparseLookup.find((quint64)key);
+        return iter != _sparseLookup.end() ? (*iter).second : rUNDEF;
+    }
+
+    IIlwisObject _inputObj;
+    IIlwisObject _outputObj;
+    QString _attribColumn;
+    bool _dense = true;
+    std::vector<double> _denseLookup;
+    std::unordered_map<quint64, double> _sparseLookup;
+};
+}
+}
+
+#endif // RECLASSIFY_H
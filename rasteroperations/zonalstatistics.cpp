@@ -0,0 +1,311 @@
+#include <functional>
+#include <future>
+#include <algorithm>
+#include <unordered_map>
+#include "kernel.h"
+#include "raster.h"
+#include "columndefinition.h"
+#include "table.h"
+#include "symboltable.h"
+#include "ilwisoperation.h"
+#include "zonalstatistics.h"
+
+using namespace Ilwis;
+using namespace RasterOperations;
+
+#define HISTOGRAMBINS 1000
+
+void ZonalStatistics::ZoneStats::add(double v)
+{
+    ++_count;
+    _sum += v;
+    if ( _count == 1)
+        _min = _max = v;
+    else {
+        _min = std::min(_min, v);
+        _max = std::max(_max, v);
+    }
+    double delta = v - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (v - _mean);
+}
+
+void ZonalStatistics::ZoneStats::merge(const ZoneStats &stats)
+{
+    if ( stats._count == 0)
+        return;
+    if ( _count == 0) {
+        *this = stats;
+        return;
+    }
+    quint64 count = _count + stats._count;
+    double delta = stats._mean - _mean;
+    _mean += delta * stats._count / count;
+    _m2 += stats._m2 + delta * delta * ((double)_count * stats._count / count);
+    _count = count;
+    _sum += stats._sum;
+    _min = std::min(_min, stats._min);
+    _max = std::max(_max, stats._max);
+    if ( stats._bins.size() == 0)
+        return;
+    addToBin(stats._firstBin, 0); // grows the bins once for the whole range of the other zone
+    addToBin(stats._firstBin + stats._bins.size() - 1, 0);
+    for(quint32 i = 0; i < stats._bins.size(); ++i)
+        _bins[stats._firstBin + i - _firstBin] += stats._bins[i];
+}
+
+void ZonalStatistics::ZoneStats::addToBin(qint32 bin, quint32 n)
+{
+    if ( _bins.size() == 0) {
+        _firstBin = bin;
+        _bins.push_back(n);
+        return;
+    }
+    if ( bin < _firstBin) {
+        _bins.insert(_bins.begin(), _firstBin - bin, 0);
+        _firstBin = bin;
+    } else if ( bin >= _firstBin + (qint32)_bins.size())
+        _bins.resize(bin - _firstBin + 1, 0);
+    _bins[bin - _firstBin] += n;
+}
+
+double ZonalStatistics::ZoneStats::stdev() const
+{
+    if ( _count < 2)
+        return rUNDEF;
+    return std::sqrt(_m2 / (_count - 1));
+}
+
+//------------------------------------------------------------------------
+Ilwis::OperationImplementation *ZonalStatistics::create(quint64 metaid, const Ilwis::OperationExpression &expr)
+{
+    return new ZonalStatistics(metaid, expr);
+}
+
+ZonalStatistics::ZonalStatistics()
+{
+}
+
+ZonalStatistics::ZonalStatistics(quint64 metaid, const Ilwis::OperationExpression &expr) :
+    OperationImplementation(metaid, expr)
+{
+}
+
+bool ZonalStatistics::execute(ExecutionContext *ctx, SymbolTable& symTable)
+{
+    if (_prepState == sNOTPREPARED)
+        if((_prepState = prepare(ctx,symTable)) != sPREPARED)
+            return false;
+
+    IRasterCoverage zoneRaster = _zoneObj.get<RasterCoverage>();
+    IRasterCoverage valueRaster = _valueObj.get<RasterCoverage>();
+
+    // the boxes of subdivideTasks share a row, which would be counted twice; the rows are divided again over the same number of tasks
+    std::vector<Box3D<qint32>> boxes;
+    int cores = OperationHelperRaster::subdivideTasks(ctx, zoneRaster, Box3D<qint32>(), boxes);
+    if ( cores == iUNDEF)
+        return false;
+    Size sz = zoneRaster->size();
+    cores = std::min<qint64>(cores, sz.ysize()); // a task gets at least one row; none for a raster without rows
+    boxes.resize(cores);
+    for(int i = 0; i < cores; ++i) {
+        qint32 y0 = (qint64)sz.ysize() * i / cores;
+        qint32 y1 = (qint64)sz.ysize() * (i + 1) / cores - 1;
+        boxes[i] = Box3D<qint32>(Voxel(0, y0, 0), Voxel(sz.xsize() - 1, y1, sz.zsize() - 1));
+    }
+
+    std::vector<Zones> zones(cores);
+    auto accumulate = [&](int task) -> bool {
+        Zones& taskZones = zones[task];
+        PixelIterator iterZone(zoneRaster, boxes[task]);
+        PixelIterator iterValue(valueRaster, boxes[task]);
+        PixelIterator iterEnd = iterZone.end();
+        double lastZone = rUNDEF;
+        ZoneStats *stats = 0;
+        while(iterZone != iterEnd) {
+            double zone = *iterZone;
+            double v = *iterValue;
+            ++iterZone;
+            ++iterValue;
+            if ( isNumericalUndef(zone) || isNumericalUndef(v))
+                continue;
+            if ( stats == 0 || zone != lastZone) { // zones come in runs, so the lookup is mostly skipped
+                stats = &taskZones[zone];
+                lastZone = zone;
+            }
+            stats->add(v);
+            if ( _median)
+                addToHistogram(*stats, v);
+        }
+        return true;
+    };
+
+    std::vector<std::future<bool>> futures(cores);
+    for(int i = 0; i < cores; ++i)
+        futures[i] = std::async(std::launch::async, accumulate, i);
+    bool res = true;
+    for(int i = 0; i < cores; ++i)
+        res &= futures[i].get();
+    if (!res)
+        return false;
+
+    Zones result; // stays empty when there were no tasks
+    for(Zones& taskZones : zones) {
+        if ( result.empty())
+            result.swap(taskZones);
+        else {
+            for(const auto& zone : taskZones)
+                result[zone.first].merge(zone.second);
+            taskZones.clear();
+        }
+    }
+    std::vector<double> keys;
+    keys.reserve(result.size());
+    for(const auto& zone : result)
+        keys.push_back(zone.first);
+    std::sort(keys.begin(), keys.end());
+
+    for(double key : keys) {
+        const ZoneStats& stats = result[key];
+        std::vector<QVariant> rec = {key, stats._count, stats._sum, stats._min, stats._max, stats._mean, stats.stdev()};
+        if ( _median)
+            rec.push_back(median(stats));
+        _outputTable->record(NEW_RECORD, rec);
+    }
+    OperationHelper::updateRanges(_outputTable);
+
+    if ( ctx != 0) {
+        QVariant value;
+        value.setValue<ITable>(_outputTable);
+        ctx->addOutput(symTable,value,_outputTable->name(), itTABLE, _outputTable->source() );
+    }
+    return true;
+}
+
+void ZonalStatistics::addToHistogram(ZoneStats &stats, double v) const
+{
+    double width = _histMax - _histMin;
+    qint32 bin = width > 0 ? (qint32)((v - _histMin) / width * HISTOGRAMBINS) : 0;
+    stats.addToBin(std::max(0, std::min(HISTOGRAMBINS - 1, bin)));
+}
+
+double ZonalStatistics::median(const ZoneStats &stats) const
+{
+    if ( stats._count == 0 || stats._bins.size() == 0)
+        return rUNDEF;
+    double width = (_histMax - _histMin) / HISTOGRAMBINS;
+    double half = stats._count / 2.0;
+    quint64 below = 0;
+    for(quint32 i = 0; i < stats._bins.size(); ++i) {
+        quint32 n = stats._bins[i];
+        if ( below + n >= half && n > 0) {
+            // interpolated within the bin, limited to the values that were actually seen
+            double m = _histMin + width * (stats._firstBin + i + (half - below) / n);
+            return std::max(stats._min, std::min(stats._max, m));
+        }
+        below += n;
+    }
+    return stats._max;
+}
+
+Ilwis::OperationImplementation::State ZonalStatistics::prepare(ExecutionContext *, const SymbolTable & )
+{
+    if ( _expression.parameterCount() < 2 || _expression.parameterCount() > 3) {
+        ERROR3(ERR_ILLEGAL_NUM_PARM3,"zonalstatistics","2 or 3",QString::number(_expression.parameterCount()));
+        return sPREPAREFAILED;
+    }
+    QString zones = _expression.parm(0).value();
+    QString values = _expression.parm(1).value();
+    QString outputName = _expression.parm(0,false).value();
+
+    if (!_zoneObj.prepare(zones, itRASTER)) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,zones,"");
+        return sPREPAREFAILED;
+    }
+    if (!_valueObj.prepare(values, itRASTER)) {
+        ERROR2(ERR_COULD_NOT_LOAD_2,values,"");
+        return sPREPAREFAILED;
+    }
+    IRasterCoverage zoneRaster = _zoneObj.get<RasterCoverage>();
+    IRasterCoverage valueRaster = _valueObj.get<RasterCoverage>();
+    if ( zoneRaster->size() != valueRaster->size()) {
+        ERROR2(ERR_NOT_COMPATIBLE2, zoneRaster->name(), valueRaster->name());
+        return sPREPAREFAILED;
+    }
+    if ( !hasType(valueRaster->datadef().domain()->valueType(), itNUMERIC)) {
+        ERROR2(ERR_OPERATION_NOTSUPPORTED2, "non numeric values", "zonalstatistics");
+        return sPREPAREFAILED;
+    }
+
+    if ( _expression.parameterCount() == 3) {
+        QString stats = _expression.parm(2).value().toLower();
+        if ( stats != "median") {
+            ERROR3(ERR_ILLEGAL_PARM_3,"statistics",stats,"zonalstatistics");
+            return sPREPAREFAILED;
+        }
+        _median = true;
+        auto range = valueRaster->datadef().range().dynamicCast<NumericRange>();
+        if ( !range.isNull() && !isNumericalUndef(range->min()) && !isNumericalUndef(range->max())) {
+            _histMin = range->min();
+            _histMax = range->max();
+        } else { // without a known range the histogram needs an extra pass
+            NumericStatistics stats;
+            PixelIterator iter(valueRaster);
+            stats.calculate(iter, iter.end());
+            _histMin = stats[NumericStatistics::pMIN];
+            _histMax = stats[NumericStatistics::pMAX];
+        }
+    }
+
+    QString url = "ilwis://internal/" + outputName;
+    Resource resource(url, itFLATTABLE);
+    _outputTable.prepare(resource);
+    if ( !_outputTable.isValid()) {
+        ERROR1(ERR_NO_INITIALIZED_1, "output table");
+        return sPREPAREFAILED;
+    }
+    if ( outputName != sUNDEF)
+        _outputTable->setName(outputName);
+    IDomain countdom, valuedom;
+    if (!countdom.prepare("count") || !valuedom.prepare("value")){
+        return sPREPAREFAILED;
+    }
+    _outputTable->addColumn(COVERAGEKEYCOLUMN, zoneRaster->datadef().domain());
+    _outputTable->addColumn("count", countdom);
+    for(const QString& column : {"sum", "min", "max", "mean", "stdev"})
+        _outputTable->addColumn(column, valuedom);
+    if ( _median)
+        _outputTable->addColumn("median", valuedom);
+
+    return sPREPARED;
+}
+
+quint64 ZonalStatistics::createMetadata()
+{
+    QString url = QString("ilwis://operations/zonalstatistics");
+    Resource resource(QUrl(url), itOPERATIONMETADATA);
+    resource.addProperty("namespace","ilwis");
+    resource.addProperty("longname","zonal statistics");
+    resource.addProperty("syntax","zonalstatistics(zoneraster,valueraster[,median])");
+    resource.addProperty("description",TR("calculates count, sum, minimum, maximum, mean and standard deviation of the values of a raster per zone of another raster, optionally with an estimated median"));
+    resource.addProperty("inparameters","2|3");
+    resource.addProperty("pin_1_type", itRASTER);
+    resource.addProperty("pin_1_name", TR("zone rastercoverage"));
+    resource.addProperty("pin_1_desc",TR("rastercoverage of which every distinct value is a zone"));
+    resource.addProperty("pin_2_type", itRASTER);
+    resource.addProperty("pin_2_name", TR("value rastercoverage"));
+    resource.addProperty("pin_2_desc",TR("numeric rastercoverage with the same size as the zone raster"));
+    resource.addProperty("pin_3_type", itSTRING);
+    resource.addProperty("pin_3_name", TR("median"));
+    resource.addProperty("pin_3_desc",TR("optional; adds the median, estimated from a histogram of the values per zone"));
+    resource.addProperty("outparameters",1);
+    resource.addProperty("pout_1_type", itTABLE);
+    resource.addProperty("pout_1_name", TR("output table"));
+    resource.addProperty("pout_1_desc",TR("table with a record per zone, keyed on the domain of the zone raster"));
+    resource.prepare();
+    url += "=" + QString::number(resource.id());
+    resource.setUrl(url);
+
+    mastercatalog()->addItems({resource});
+    return resource.id();
+}
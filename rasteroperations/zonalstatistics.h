@@ -0,0 +1,60 @@
+#ifndef ZONALSTATISTICS_H
+#define ZONALSTATISTICS_H
+
+namespace Ilwis {
+namespace RasterOperations {
+/*!
+ Calculates statistics of a value raster per zone of a zone raster in one pass over both rasters. Every thread accumulates the count, sum,
+ minimum, maximum, mean and variance per zone of its own rows; the accumulators are merged when all threads are done. Optionally the median is
+ estimated from a histogram per zone with a fixed bin width over the range of the value raster; a zone only keeps the bins between its
+ smallest and largest value. The result is a table with a record per
+ zone, keyed on the zone domain, so it can be used as attribute table of the zone raster.
+ */
+class ZonalStatistics : public OperationImplementation
+{
+public:
+    ZonalStatistics();
+    ZonalStatistics(quint64 metaid, const Ilwis::OperationExpression &expr);
+
+    bool execute(ExecutionContext *ctx,SymbolTable& symTable);
+    static Ilwis::OperationImplementation *create(quint64 metaid,const Ilwis::OperationExpression& expr);
+    Ilwis::OperationImplementation::State prepare(ExecutionContext *ctx, const SymbolTable &);
+
+    static quint64 createMetadata();
+
+    /*!
+     running statistics of one zone. Mean and variance are kept with Welford's method, so merging the statistics of two threads does not lose precision
+     */
+    struct ZoneStats {
+        quint64 _count = 0;
+        double _sum = 0;
+        double _min = rUNDEF;
+        double _max = rUNDEF;
+        double _mean = 0;
+        double _m2 = 0; // sum of the squared differences from the mean
+        qint32 _firstBin = 0;
+        std::vector<quint32> _bins; // the bins from _firstBin on of the histogram, only when the median is asked; grown when a value falls outside them
+
+        void add(double v);
+        void addToBin(qint32 bin, quint32 n=1);
+        void merge(const ZoneStats& stats);
+        double stdev() const;
+    };
+
+private:
+    typedef std::unordered_map<double, ZoneStats> Zones;
+
+    IIlwisObject _zoneObj;
+    IIlwisObject _valueObj;
+    ITable _outputTable;
+    bool _median = false;
+    double _histMin = rUNDEF;
+    double _histMax = rUNDEF;
+
+    void addToHistogram(ZoneStats& stats, double v) const;
+    double median(const ZoneStats& stats) const;
+};
+}
+}
+
+#endif // ZONALSTATISTICS_H